@@ -4,6 +4,11 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <set>
+#include <type_traits>
+#include <utility>
+
+#include "llvm/ADT/StringRef.h"
 #include "llvm/IR/Module.h"
 
 #include "revng/EarlyFunctionAnalysis/ControlFlowGraphCache.h"
@@ -11,12 +16,84 @@
 #include "revng/Pipes/StringMap.h"
 
 #include "revng-c/Backend/DecompilePipe.h"
+#include "revng-c/RestructureCFG/ASTTree.h"
 
 namespace ptml {
 class CTypeBuilder;
 }
 
+/// Restructure and decompile \p F.
+///
+/// \note this mutates the IR of \p F, see beautifyAST.
+std::string decompile(ControlFlowGraphCache &Cache,
+                      llvm::Function &F,
+                      const model::Binary &Model,
+                      ptml::CTypeBuilder &B);
+
+/// Build the GHAST of \p F, and serialize it.
+///
+/// A temporary copy of \p F is restructured, so that \p F is not mutated.
+std::string restructure(llvm::Function &F, const model::Binary &Model);
+
+/// Decompile \p F, using the GHAST that restructure produced for it.
+///
+/// \note the changes that beautification made to the IR are replayed on \p F.
 std::string decompile(ControlFlowGraphCache &Cache,
                       llvm::Function &F,
                       const model::Binary &Model,
+                      llvm::StringRef SerializedGHAST,
                       ptml::CTypeBuilder &B);
+
+/// The entities of the model that the C code of a function has been emitted
+/// from.
+///
+/// The C backend records them where it reads them from the model, so that the
+/// reads can be replayed on a tracked model after decompiling on an untracked
+/// one. The types they refer to are not recorded: replaying has to read them
+/// as well.
+struct ModelReads {
+  template<typename T>
+  using KeyOf = std::decay_t<decltype(std::declval<const T &>().key())>;
+
+  std::set<KeyOf<model::Function>> Functions;
+  std::set<KeyOf<model::DynamicFunction>> DynamicFunctions;
+  std::set<KeyOf<model::Segment>> Segments;
+  std::set<KeyOf<model::TypeDefinition>> TypeDefinitions;
+
+  void read(const model::Function &Function) {
+    Functions.insert(Function.key());
+  }
+
+  void read(const model::DynamicFunction &Function) {
+    DynamicFunctions.insert(Function.key());
+  }
+
+  void read(const model::Segment &Segment) {
+    Segments.insert(Segment.key());
+  }
+
+  void read(const model::TypeDefinition &Definition) {
+    TypeDefinitions.insert(Definition.key());
+  }
+
+  void read(const model::Type &Type);
+};
+
+/// Variant of decompile that can be invoked from multiple threads at the same
+/// time, on different functions of the same module.
+///
+/// Replaying on the IR the changes made by beautification mutates state shared
+/// across the whole module (e.g., the use lists of constants), so \p GHAST
+/// must have been restored with deserializeAST before any thread starts
+/// emitting C code. This only reads the IR.
+/// Each thread must use its own \p Cache and \p B. All the threads can share
+/// \p Model, as long as it is not tracked: reading a tracked model updates the
+/// state used to track its accesses. The parts of \p Model the C code depends
+/// on are recorded in \p Reads.
+/// \note no progress is reported, since `Task`s are not thread-safe.
+std::string decompileConcurrently(ControlFlowGraphCache &Cache,
+                                  const llvm::Function &F,
+                                  const ASTTree &GHAST,
+                                  const model::Binary &Model,
+                                  ptml::CTypeBuilder &B,
+                                  ModelReads &Reads);
@@ -17,6 +17,7 @@
 #include "revng/Pipes/Kinds.h"
 #include "revng/Pipes/StringMap.h"
 
+#include "revng-c/Backend/RestructurePipe.h"
 #include "revng-c/Pipes/Kinds.h"
 
 namespace revng::pipes {
@@ -40,18 +41,24 @@ public:
     return { ContractGroup({ Contract(StackAccessesSegregated,
                                       0,
                                       Decompiled,
-                                      2,
+                                      3,
                                       InputPreservation::Preserve),
                              Contract(CFG,
                                       1,
                                       Decompiled,
+                                      3,
+                                      InputPreservation::Preserve),
+                             Contract(GHAST,
                                       2,
+                                      Decompiled,
+                                      3,
                                       InputPreservation::Preserve) }) };
   }
 
   void run(pipeline::ExecutionContext &EC,
            pipeline::LLVMContainer &IRContainer,
            const revng::pipes::CFGMap &CFGMap,
+           const GHASTStringMap &GHASTs,
            DecompileStringMap &DecompiledFunctionsContainer);
 };
 
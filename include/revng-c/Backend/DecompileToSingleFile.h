@@ -4,6 +4,11 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <set>
+#include <string>
+
+#include "llvm/ADT/STLFunctionalExtras.h"
+
 #include "revng/Pipes/StringMap.h"
 #include "revng/Support/MetaAddress.h"
 
@@ -17,6 +22,19 @@ namespace detail {
 using DecompiledStringMap = revng::pipes::DecompileStringMap;
 }
 
+/// Callback writing the body of a function to the single C file
+using FunctionBodyPrinter = llvm::function_ref<void(const std::string &)>;
+
+/// Print a single C file, whose function bodies are provided by \p Generate.
+///
+/// \p Generate is invoked exactly once, and it has to call the printer it is
+/// given once per function, in the order in which they should appear.
+/// Each body is written to the output stream of \p B right away, so the
+/// caller can produce the bodies one at a time and drop them immediately,
+/// instead of keeping all of them in memory.
+void printSingleCFile(ptml::CTypeBuilder &B,
+                      llvm::function_ref<void(FunctionBodyPrinter)> Generate);
+
 void printSingleCFile(ptml::CTypeBuilder &B,
                       const detail::DecompiledStringMap &Functions,
                       const std::set<MetaAddress> &Targets);
@@ -0,0 +1,53 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <array>
+
+#include "revng/Pipeline/Context.h"
+#include "revng/Pipeline/Contract.h"
+#include "revng/Pipes/Kinds.h"
+#include "revng/Pipes/StringMap.h"
+
+#include "revng-c/Pipes/Kinds.h"
+
+namespace revng::pipes {
+
+inline constexpr char GHASTMime[] = "text/x.ghast+tar+gz";
+inline constexpr char GHASTName[] = "ghast";
+inline constexpr char GHASTExtension[] = ".ghast";
+using GHASTStringMap = FunctionStringMap<&kinds::GHAST,
+                                         GHASTName,
+                                         GHASTMime,
+                                         GHASTExtension>;
+
+/// Restructure each function and store its beautified GHAST, so that the C
+/// code can be emitted again without restructuring it from scratch.
+///
+/// \note the GHAST of a function is invalidated together with its IR in
+///       module.ll. Renaming something only re-runs the emission of C, while
+///       editing a type that changes the canonicalized IR still restructures
+///       the function again.
+class Restructure {
+public:
+  static constexpr auto Name = "restructure";
+
+  std::array<pipeline::ContractGroup, 1> getContract() const {
+    using namespace pipeline;
+    using namespace revng::kinds;
+
+    return { ContractGroup({ Contract(StackAccessesSegregated,
+                                      0,
+                                      GHAST,
+                                      1,
+                                      InputPreservation::Preserve) }) };
+  }
+
+  void run(pipeline::ExecutionContext &EC,
+           pipeline::LLVMContainer &IRContainer,
+           GHASTStringMap &GHASTContainer);
+};
+
+} // end namespace revng::pipes
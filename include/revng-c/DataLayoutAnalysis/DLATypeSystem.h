@@ -14,12 +14,14 @@
 #include <set>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/GraphTraits.h"
 #include "llvm/ADT/IntEqClasses.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/iterator.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -157,6 +159,7 @@ public:
 }; // end class TypeLinkTag
 
 class LayoutTypeSystem;
+struct LayoutTypeSystemPartition;
 
 enum InterferingChildrenInfo {
   Unknown = 0,
@@ -188,6 +191,11 @@ struct LayoutTypeSystemNode {
         if (auto Cmp = ID <=> Other.ID; Cmp != 0)
           return Cmp < 0;
 
+        // Tags are uniqued by the LayoutTypeSystem, so the same pointer means
+        // the same tag, and we can skip comparing the OffsetExpressions.
+        if (TagPointer == Other.TagPointer)
+          return false;
+
         if (nullptr == TagPointer or nullptr == Other.TagPointer)
           return TagPointer < Other.TagPointer;
 
@@ -200,6 +208,10 @@ struct LayoutTypeSystemNode {
     }
   };
 
+  // The neighbors are kept in node-based sets on purpose: many middle-end
+  // steps hold NeighborIterators across insertions and removals of other
+  // edges, which a flat adjacency storage would invalidate. Moving to a flat
+  // or CSR adjacency requires reworking those steps first.
   using NeighborsSet = std::set<Link, NeighborLinkComparison>;
   using NeighborIterator = NeighborsSet::iterator;
   NeighborsSet Successors{};
@@ -285,10 +297,71 @@ public:
   using NodeUniquePtr = std::unique_ptr<LayoutTypeSystemNode>;
   using NeighborIterator = LayoutTypeSystemNode::NeighborIterator;
 
+  /// Iterates over the nodes of a LayoutTypeSystem, in ID order, which is
+  /// the order in which they have been created.
+  ///
+  /// The iterator is not invalidated by the creation or the removal of other
+  /// nodes. Nodes created while iterating are visited too.
+  class LayoutIterator
+    : public llvm::iterator_facade_base<LayoutIterator,
+                                        std::forward_iterator_tag,
+                                        LayoutTypeSystemNode *,
+                                        std::ptrdiff_t,
+                                        LayoutTypeSystemNode **,
+                                        LayoutTypeSystemNode *> {
+  private:
+    const std::vector<LayoutTypeSystemNode *> *Nodes = nullptr;
+    size_t Index = 0;
+
+  public:
+    LayoutIterator() = default;
+    LayoutIterator(const std::vector<LayoutTypeSystemNode *> &Nodes,
+                   size_t Index) :
+      Nodes(&Nodes), Index(Index) {
+      skipRemoved();
+    }
+
+    /// The end iterator stays the end even if nodes are added afterwards
+    static LayoutIterator
+    end(const std::vector<LayoutTypeSystemNode *> &Nodes) {
+      return LayoutIterator(Nodes, std::numeric_limits<size_t>::max());
+    }
+
+  public:
+    LayoutTypeSystemNode *operator*() const {
+      revng_assert(not atEnd());
+      return (*Nodes)[Index];
+    }
+
+    LayoutIterator &operator++() {
+      revng_assert(not atEnd());
+      ++Index;
+      skipRemoved();
+      return *this;
+    }
+
+    bool operator==(const LayoutIterator &Other) const {
+      revng_assert(Nodes == Other.Nodes);
+      if (atEnd() or Other.atEnd())
+        return atEnd() and Other.atEnd();
+      return Index == Other.Index;
+    }
+
+  private:
+    bool atEnd() const { return Nodes == nullptr or Index >= Nodes->size(); }
+
+    void skipRemoved() {
+      while (not atEnd() and (*Nodes)[Index] == nullptr)
+        ++Index;
+    }
+  };
+
   LayoutTypeSystem() : DebugPrinter(new TSDebugPrinter) {}
 
   ~LayoutTypeSystem() {
     for (auto *Layout : Layouts) {
+      if (Layout == nullptr)
+        continue;
       Layout->~LayoutTypeSystemNode();
       NodeAllocator.Deallocate(Layout);
     }
@@ -308,13 +381,15 @@ protected:
   addLink(LayoutTypeSystemNode *Src, LayoutTypeSystemNode *Tgt, TagT &&Tag) {
     if (Src == nullptr or Tgt == nullptr or Src == Tgt)
       return std::make_pair(nullptr, false);
-    revng_assert(Layouts.contains(Src));
-    revng_assert(Layouts.contains(Tgt));
+    revng_assert(getLayout(Src->ID) == Src);
+    revng_assert(getLayout(Tgt->ID) == Tgt);
     auto It = LinkTags.insert(std::forward<TagT>(Tag)).first;
     revng_assert(It != LinkTags.end());
     const TypeLinkTag *T = &*It;
     bool New = Src->Successors.insert(std::make_pair(Tgt, T)).second;
     New |= Tgt->Predecessors.insert(std::make_pair(Src, T)).second;
+    if (New)
+      markChanged();
     return std::make_pair(T, New);
   }
 
@@ -360,10 +435,26 @@ public:
     dumpDotOnFile(FName.c_str(), ShowCollapsed);
   }
 
-  auto getNumLayouts() const { return Layouts.size(); }
+  auto getNumLayouts() const { return NumLayouts; }
+
+  /// A counter that grows at each change to the nodes or to the edges
+  ///
+  /// The methods of this class changing the graph bump it on their own. Code
+  /// updating the Size, the InterferingInfo or the NonScalar flag of an
+  /// existing node, or its neighbors directly, must call markChanged().
+  uint64_t getGeneration() const { return Generation; }
+
+  void markChanged() { ++Generation; }
 
   auto getLayoutsRange() const {
-    return llvm::make_range(Layouts.begin(), Layouts.end());
+    return llvm::make_range(LayoutIterator(Layouts, 0),
+                            LayoutIterator::end(Layouts));
+  }
+
+  /// Get the node with the given \a ID, or nullptr if it has been merged or
+  /// removed
+  LayoutTypeSystemNode *getLayout(uint64_t ID) const {
+    return ID < Layouts.size() ? Layouts[ID] : nullptr;
   }
 
 public:
@@ -386,12 +477,40 @@ public:
 
   void dropOutgoingEdges(LayoutTypeSystemNode *N);
 
+public:
+  /// Split the type system in \a N independent type systems, that can be
+  /// processed in parallel.
+  ///
+  /// Each weakly connected component ends up entirely in a single partition,
+  /// and the components are distributed so that the partitions have roughly
+  /// the same number of nodes. After this call the nodes of this type system
+  /// have no edges, until absorb() is called.
+  std::vector<LayoutTypeSystemPartition> partition(unsigned N);
+
+  /// Bring back the result of processing the partitions created by
+  /// partition().
+  ///
+  /// The nodes merged or removed in a partition are merged or removed in this
+  /// type system, joining their equivalence classes accordingly, and the nodes
+  /// created in a partition get a new ID in this type system.
+  void absorb(std::vector<LayoutTypeSystemPartition> &&Partitions);
+
+private:
+  /// Destroy \a N, without updating its neighbors
+  void destroyNode(LayoutTypeSystemNode *N);
+
 private:
   uint64_t NID = 0ULL;
 
   // Holds all the LayoutTypeSystemNode
   llvm::BumpPtrAllocator NodeAllocator = {};
-  std::set<LayoutTypeSystemNode *> Layouts = {};
+  // Maps the ID of each node to the node, or to nullptr if the node has been
+  // merged or removed
+  std::vector<LayoutTypeSystemNode *> Layouts = {};
+  // Number of non-null elements in Layouts
+  size_t NumLayouts = 0;
+  // See getGeneration()
+  uint64_t Generation = 0;
 
   // Holds the link tags, so that they can be deduplicated and referred to using
   // TypeLinkTag * in the links inside LayoutTypeSystemNode
@@ -432,6 +551,15 @@ public:
   }
 }; // end class LayoutTypeSystem
 
+/// A part of a LayoutTypeSystem that can be processed independently, see
+/// LayoutTypeSystem::partition
+struct LayoutTypeSystemPartition {
+  std::unique_ptr<LayoutTypeSystem> TS;
+  /// Maps the ID of each node initially in TS to the ID of the node it has
+  /// been created from
+  std::vector<uint64_t> OriginalIDs;
+};
+
 } // end namespace dla
 
 template<>
@@ -571,7 +699,7 @@ struct llvm::GraphTraits<const dla::LayoutTypeSystem *>
   : public llvm::GraphTraits<const dla::LayoutTypeSystemNode *> {
 
 public:
-  using nodes_iterator = std::set<dla::LayoutTypeSystemNode *>::iterator;
+  using nodes_iterator = dla::LayoutTypeSystem::LayoutIterator;
 
   static NodeRef getEntryNode(const dla::LayoutTypeSystem *) { return nullptr; }
 
@@ -593,7 +721,7 @@ struct llvm::GraphTraits<dla::LayoutTypeSystem *>
   : public llvm::GraphTraits<dla::LayoutTypeSystemNode *> {
 
 public:
-  using nodes_iterator = std::set<dla::LayoutTypeSystemNode *>::iterator;
+  using nodes_iterator = dla::LayoutTypeSystem::LayoutIterator;
 
   static NodeRef getEntryNode(const dla::LayoutTypeSystem *) { return nullptr; }
 
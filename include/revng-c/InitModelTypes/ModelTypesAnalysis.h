@@ -0,0 +1,74 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <map>
+#include <optional>
+
+#include "llvm/Pass.h"
+
+#include "revng/Model/Binary.h"
+#include "revng/Support/Assert.h"
+
+/// Legacy pass manager analysis caching the results of `initModelTypes`.
+///
+/// The types are computed lazily, the first time a pass asks for them, and are
+/// then reused by all the following passes, as long as they preserve this
+/// analysis. A pass that rewrites instructions can still preserve it, provided
+/// that it reports the values it erased with `forget` and the instructions it
+/// created or changed with `update`.
+///
+/// The maps are not updated incrementally. Erasing a value only drops its
+/// entry, while creating or changing an instruction drops the whole maps,
+/// which are recomputed from scratch the next time they are requested. The
+/// `-verify-model-types` option checks that the maps kept after erasing values
+/// match a full recomputation, every time they are requested.
+class ModelTypesWrapperPass : public llvm::FunctionPass {
+public:
+  static char ID;
+
+  using ModelTypesMap = std::map<const llvm::Value *,
+                                 const model::UpcastableType>;
+
+private:
+  const llvm::Function *F = nullptr;
+  const model::Function *ModelF = nullptr;
+  const model::Binary *Model = nullptr;
+  std::optional<ModelTypesMap> AllTypes;
+  std::optional<ModelTypesMap> PointerTypes;
+  /// Whether entries have been dropped from the cached maps with `forget`
+  bool Updated = false;
+
+public:
+  ModelTypesWrapperPass() : llvm::FunctionPass(ID) {}
+
+  bool runOnFunction(llvm::Function &F) override;
+
+  void getAnalysisUsage(llvm::AnalysisUsage &AU) const override;
+
+  void releaseMemory() override;
+
+public:
+  /// The model function corresponding to the function being analyzed, so that
+  /// passes requiring this analysis don't have to look it up again
+  const model::Function *getModelFunction() const {
+    revng_assert(F != nullptr);
+    return ModelF;
+  }
+
+  /// Same as `initModelTypes(F, ModelF, Model, false)`
+  const ModelTypesMap &getTypes();
+
+  /// Same as `initModelTypes(F, ModelF, Model, true)`
+  const ModelTypesMap &getPointerTypes();
+
+  /// Drop \p V from the cached maps. Must be called before \p V is erased.
+  void forget(const llvm::Value *V);
+
+  /// Report that \p I has been created, or that its operands have changed.
+  /// This drops the cached maps, since the types of all the transitive users
+  /// of \p I might change.
+  void update(const llvm::Instruction &I);
+};
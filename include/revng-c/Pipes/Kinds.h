@@ -58,6 +58,8 @@ inline pipeline::SingleElementKind
 
 inline FunctionKind MLIRFunctionKind("mlir-module", ranks::Function, {}, {});
 
+inline FunctionKind GHAST("ghast", ranks::Function, {}, {});
+
 inline pipeline::SingleElementKind DecompiledToC("decompiled-to-c",
                                                  Binary,
                                                  ranks::Binary,
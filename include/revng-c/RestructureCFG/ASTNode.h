@@ -102,6 +102,8 @@ public:
 
   unsigned getID() const { return ID; }
 
+  const std::string &getNameStr() const { return Name; }
+
   llvm::BasicBlock *getBB() const { return BB; }
 
   ASTNode *getSuccessor() const { return Successor; }
@@ -140,6 +142,10 @@ public:
   CodeNode(BasicBlockNodeBB *CFGNode, ASTNode *Successor) :
     ASTNode(NK_Code, CFGNode, Successor) {}
 
+  // Constructor used when deserializing a GHAST
+  CodeNode(const std::string &Name, llvm::BasicBlock *BB) :
+    ASTNode(NK_Code, Name, BB) {}
+
 protected:
   CodeNode(const CodeNode &) = default;
   CodeNode(CodeNode &&) = delete;
@@ -303,6 +309,10 @@ public:
   ScsNode(BasicBlockNodeBB *CFGNode, ASTNode *Body, ASTNode *Successor) :
     ASTNode(NK_Scs, CFGNode, Successor), Body(Body) {}
 
+  // Constructor used when deserializing a GHAST
+  ScsNode(const std::string &Name, llvm::BasicBlock *BB, ASTNode *Body) :
+    ASTNode(NK_Scs, Name, BB), Body(Body) {}
+
 protected:
   ScsNode(const ScsNode &) = default;
   ScsNode(ScsNode &&) = delete;
@@ -432,6 +442,10 @@ private:
 public:
   ContinueNode(BasicBlockNodeBB *CFGNode) : ASTNode(NK_Continue, CFGNode) {}
 
+  // Constructor used when deserializing a GHAST
+  ContinueNode(const std::string &Name, llvm::BasicBlock *BB) :
+    ASTNode(NK_Continue, Name, BB) {}
+
 protected:
   ContinueNode(const ContinueNode &) = default;
   ContinueNode(ContinueNode &&) = delete;
@@ -467,6 +481,10 @@ class BreakNode : public ASTNode {
 public:
   BreakNode(BasicBlockNodeBB *CFGNode) : ASTNode(NK_Break, CFGNode) {}
 
+  // Constructor used when deserializing a GHAST
+  BreakNode(const std::string &Name, llvm::BasicBlock *BB) :
+    ASTNode(NK_Break, Name, BB) {}
+
   static bool classof(const ASTNode *N) { return N->getKind() == NK_Break; }
 
 protected:
@@ -523,6 +541,15 @@ public:
     }
   }
 
+  // Constructor used when deserializing a GHAST
+  SetNode(const std::string &Name,
+          llvm::BasicBlock *BB,
+          unsigned StateVariableValue,
+          DispatcherKind DKind) :
+    ASTNode(NK_Set, Name, BB),
+    StateVariableValue(StateVariableValue),
+    DKind(DKind) {}
+
 protected:
   SetNode(const SetNode &) = default;
   SetNode(SetNode &&) = delete;
@@ -588,6 +615,20 @@ public:
     }
   }
 
+  // Constructor used when deserializing a GHAST. \p DKind is only meaningful
+  // for dispatchers, which have no \p Cond.
+  SwitchNode(const std::string &Name,
+             llvm::BasicBlock *BB,
+             llvm::Value *Cond,
+             case_container &&LabeledCases,
+             bool IsWeaved,
+             DispatcherKind DKind) :
+    ASTNode(NK_Switch, Name, BB),
+    Condition(Cond),
+    LabelCaseVec(std::move(LabeledCases)),
+    IsWeaved(IsWeaved),
+    DKind(DKind) {}
+
   SwitchNode(const SwitchNode &) = default;
   SwitchNode(SwitchNode &&) = delete;
   ~SwitchNode() = default;
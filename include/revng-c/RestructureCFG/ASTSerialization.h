@@ -0,0 +1,30 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng-c/RestructureCFG/ASTTree.h"
+
+namespace llvm {
+class Function;
+} // namespace llvm
+
+/// Serialize \p AST, which has been built on \p F, to \p OS.
+///
+/// Basic blocks and values are referred to through their position in \p F,
+/// and the changes that beautification made to the IR of \p F are recorded
+/// too, so that the AST can be restored on any copy of the function taken
+/// before restructuring.
+void serializeAST(ASTTree &AST, const llvm::Function &F, llvm::raw_ostream &OS);
+
+/// Restore on \p F an AST serialized by serializeAST.
+///
+/// \p F has to be identical to the function that was restructured, as it was
+/// before beautification: the changes beautification made to its IR are
+/// replayed on \p F.
+/// \note like beautification, this mutates the IR of \p F.
+ASTTree deserializeAST(llvm::StringRef Buffer, llvm::Function &F);
@@ -6,6 +6,8 @@
 
 #include <cstdlib>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "revng-c/RestructureCFG/ASTNode.h"
 
@@ -50,6 +52,17 @@ public:
   using BasicBlockNodeBB = ASTNode::BasicBlockNodeBB;
   using BBNodeMap = ASTNode::BBNodeMap;
 
+  /// How the condition of a conditional branch on the IR has been negated
+  enum class NotKind {
+    /// The predicate of the `icmp` has been inverted
+    SimpleIR,
+
+    /// The call to `boolean_not` has been replaced by an `icmp ne 0`
+    BooleanNot
+  };
+
+  using IRFlip = std::pair<llvm::BasicBlock *, NotKind>;
+
   links_iterator begin() {
     return llvm::map_iterator(ASTNodeList.begin(), getPointer);
   }
@@ -66,8 +79,13 @@ private:
   std::map<ASTNode *, BasicBlockNodeBB *> ASTBBMap = {};
   ASTNode *RootNode = nullptr;
   unsigned IDCounter = 0;
+  /// Incremental counter used to give names to sequence nodes
+  unsigned SequenceCounter = 1;
   links_container_expr CondExprList = {};
 
+  /// The negations performed on the IR while simplifying the AST, in order
+  std::vector<IRFlip> IRFlips = {};
+
 public:
   ASTTree() = default;
 
@@ -127,4 +145,10 @@ public:
                                     const std::string &FileName) const;
 
   ExprNode *addCondExpr(expr_unique_ptr &&Expr);
+
+  void addIRFlip(llvm::BasicBlock *BB, NotKind Kind) {
+    IRFlips.push_back({ BB, Kind });
+  }
+
+  const std::vector<IRFlip> &irFlips() const { return IRFlips; }
 };
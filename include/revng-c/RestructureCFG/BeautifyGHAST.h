@@ -11,6 +11,12 @@ class Function;
 } // end namespace llvm
 
 class ASTTree;
+struct RestructureContext;
 
-extern void
-beautifyAST(const model::Binary &Model, llvm::Function &F, ASTTree &CombedAST);
+/// \note this mutates the IR of \p F (and the use lists of the constants and
+///       functions it references), so it must not run concurrently with other
+///       transformations of the same module.
+extern void beautifyAST(const model::Binary &Model,
+                        llvm::Function &F,
+                        ASTTree &CombedAST,
+                        RestructureContext &Context);
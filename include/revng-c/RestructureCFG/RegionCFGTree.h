@@ -19,6 +19,7 @@
 
 #include "revng-c/RestructureCFG/ASTTree.h"
 #include "revng-c/RestructureCFG/BasicBlockNodeBB.h"
+#include "revng-c/RestructureCFG/RestructureContext.h"
 #include "revng-c/RestructureCFG/Utils.h"
 
 template<class NodeT>
@@ -137,6 +138,9 @@ private:
   llvm::DominatorTreeBase<BasicBlockNodeT, false> DT;
   FPostDomTree IFPDT;
 
+  /// Metrics about the combing of this region
+  CombingStatistics Statistics;
+
 private:
   template<typename GraphNodeT>
   void addSuccessorEdges(GraphNodeT N,
@@ -385,6 +389,8 @@ public:
 
   bool isTopologicallyEquivalent(RegionCFG &Other) const;
 
+  const CombingStatistics &getStatistics() const { return Statistics; }
+
   void weave();
 
   void markUnreachableAsInlined();
@@ -443,8 +449,3 @@ struct GraphTraits<Inverse<RegionCFG<NodeT> *>>
 };
 
 } // namespace llvm
-
-extern unsigned DuplicationCounter;
-
-extern unsigned UntangleTentativeCounter;
-extern unsigned UntanglePerformedCounter;
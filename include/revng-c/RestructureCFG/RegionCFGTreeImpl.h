@@ -622,10 +622,10 @@ inline void RegionCFG<NodeT>::untangle() {
       revng_log(CombLogger, "UntangleElseCost:" << UntangleElseCost);
 
       // Register a tentative untangle in the dedicated counter.
-      UntangleTentativeCounter++;
+      Statistics.UntangleTentative++;
 
       // Register an actual untangle in the dedicated counter.
-      UntanglePerformedCounter++;
+      Statistics.UntanglePerformed++;
       revng_log(CombLogger, "Actually splitting node");
 
       auto *ToUntangle = (UntangleThenCost > UntangleElseCost) ? ElseChild :
@@ -1036,7 +1036,7 @@ inline void RegionCFG<NodeT>::inflate() {
       } else {
 
         // Duplicate node.
-        DuplicationCounter++;
+        Statistics.Duplications++;
         revng_log(CombLogger, "Duplicating node " << Candidate->getNameStr());
 
         BasicBlockNode<NodeT> *Duplicated = Graph.cloneNode(*Candidate);
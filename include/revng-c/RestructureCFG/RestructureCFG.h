@@ -7,6 +7,8 @@
 #include "llvm/IR/Function.h"
 #include "llvm/Pass.h"
 
+#include "revng-c/RestructureCFG/RestructureContext.h"
+
 class ASTTree;
 
 class RestructureCFG : public llvm::FunctionPass {
@@ -22,4 +24,10 @@ public:
   void getAnalysisUsage(llvm::AnalysisUsage &AU) const override;
 };
 
-bool restructureCFG(llvm::Function &F, ASTTree &AST);
+/// Restructure \p F into \p AST.
+///
+/// All the state mutated during the process is owned by \p AST and
+/// \p Context, so different functions can be restructured concurrently.
+bool restructureCFG(llvm::Function &F,
+                    ASTTree &AST,
+                    RestructureContext &Context);
@@ -0,0 +1,44 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+/// Metrics about the transformations applied while combing a `RegionCFG`.
+struct CombingStatistics {
+  /// Number of nodes duplicated by the comb
+  unsigned Duplications = 0;
+
+  /// Number of candidates considered by untangle
+  unsigned UntangleTentative = 0;
+
+  /// Number of untangle transformations actually performed
+  unsigned UntanglePerformed = 0;
+
+  CombingStatistics &operator+=(const CombingStatistics &Other) {
+    Duplications += Other.Duplications;
+    UntangleTentative += Other.UntangleTentative;
+    UntanglePerformed += Other.UntanglePerformed;
+    return *this;
+  }
+
+  bool operator==(const CombingStatistics &) const = default;
+};
+
+/// Per-function state of the restructuring and beautification of a function.
+///
+/// Everything that is mutated while restructuring a function lives either
+/// here, or in the `RegionCFG`s and `ASTTree` of the function itself, so that
+/// different functions can be restructured concurrently, as long as each of
+/// them has its own `RestructureContext`.
+struct RestructureContext {
+  /// Metrics about the combing of all the regions of the function
+  CombingStatistics Combing;
+
+  /// Number of short-circuit simplifications performed by `beautifyAST`
+  unsigned ShortCircuits = 0;
+
+  /// Number of trivial short-circuit simplifications performed by
+  /// `beautifyAST`
+  unsigned TrivialShortCircuits = 0;
+};
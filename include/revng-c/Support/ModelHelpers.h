@@ -4,6 +4,9 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <deque>
+
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/IR/Type.h"
 
@@ -42,6 +45,48 @@ extern model::UpcastableType fromLLVMString(llvm::Value *V,
 llvm::Constant *toLLVMString(const model::UpcastableType &Type,
                              llvm::Module &M);
 
+/// Interning table for the model types attached to the IR as strings (see
+/// `toLLVMString`).
+///
+/// `toLLVMString` emits a single global for each distinct serialized type, so
+/// the global itself identifies the type. The first time a global is looked
+/// up, the table deserializes it and assigns it a compact integer handle.
+/// Later lookups of the same global only cost a hash table probe.
+///
+/// Two strings get the same handle if and only if they represent the same
+/// type, so handles can also be compared instead of the types themselves.
+///
+/// \note the table caches types referring to the model: it must not outlive
+///       changes to the model, nor to the strings in the IR.
+class ModelTypeTable {
+private:
+  const model::Binary &Model;
+  llvm::DenseMap<const llvm::Value *, unsigned> Handles;
+  /// A deque, so that references to the types are stable across insertions
+  std::deque<model::UpcastableType> Types;
+
+public:
+  explicit ModelTypeTable(const model::Binary &Model) : Model(Model) {}
+
+public:
+  const model::Binary &getModel() const { return Model; }
+
+  /// Get the handle of the type serialized in \p V, which must be a pointer
+  /// to a string created by `toLLVMString`.
+  unsigned getHandle(llvm::Value *V);
+
+  const model::UpcastableType &get(unsigned Handle) const {
+    return Types.at(Handle);
+  }
+
+  /// Same as `fromLLVMString`, but deserializes each distinct type only once.
+  const model::UpcastableType &get(llvm::Value *V) {
+    return get(getHandle(V));
+  }
+
+  size_t size() const { return Types.size(); }
+};
+
 /// Return an LLVM IntegerType that has the size of a pointer in the given
 /// architecture.
 inline llvm::IntegerType *getPointerSizedInteger(llvm::LLVMContext &C,
@@ -56,7 +101,7 @@ inline llvm::IntegerType *getPointerSizedInteger(llvm::LLVMContext &C,
 /// \return nothing if no information could be deduced locally on Inst
 /// \return one or more types associated to the instruction
 extern RecursiveCoroutine<llvm::SmallVector<model::UpcastableType, 8>>
-getStrongModelInfo(const llvm::Instruction *Inst, const model::Binary &Model);
+getStrongModelInfo(const llvm::Instruction *Inst, ModelTypeTable &Types);
 
 /// If possible, deduce the expected model type of an operand (e.g. the base
 /// operand of a ModelGEP) by looking only at the User. Note that, in the case
@@ -65,7 +110,7 @@ getStrongModelInfo(const llvm::Instruction *Inst, const model::Binary &Model);
 /// \return nothing if no information could be deduced locally on U
 /// \return one or more types associated to the use
 extern llvm::SmallVector<model::UpcastableType>
-getExpectedModelType(const llvm::Use *U, const model::Binary &Model);
+getExpectedModelType(const llvm::Use *U, ModelTypeTable &Types);
 
 extern llvm::SmallVector<model::UpcastableType>
 flattenReturnTypes(const abi::FunctionType::Layout &Layout,
@@ -4,6 +4,7 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <array>
 #include <type_traits>
 
 #include "llvm/ADT/APInt.h"
@@ -56,6 +57,7 @@ public:
     BinaryNot,
     UnaryMinus,
   };
+  static constexpr size_t OperatorCount = size_t(Operator::UnaryMinus) + 1;
 
   enum class Keyword {
     Const,
@@ -74,6 +76,7 @@ public:
     Union,
     Enum,
   };
+  static constexpr size_t KeywordCount = size_t(Keyword::Enum) + 1;
 
   enum class Scopes {
     Scope,
@@ -98,6 +101,7 @@ public:
     EndIf,
     Attribute,
   };
+  static constexpr size_t DirectiveCount = size_t(Directive::Attribute) + 1;
 
 public:
   CBuilder(ptml::MarkupBuilder B = {}) : ptml::MarkupBuilder(B) {}
@@ -301,10 +305,43 @@ private:
     return tokenTag(Str, ptml::c::tokens::Directive);
   }
 
+  /// The operators, keywords and directives, already rendered, so that
+  /// emitting them doesn't require building a Tag every time.
+  struct FixedTokens {
+    std::array<std::string, OperatorCount> Operators;
+    std::array<std::string, KeywordCount> Keywords;
+    std::array<std::string, DirectiveCount> Directives;
+
+    explicit FixedTokens(const CBuilder &B) {
+      for (size_t I = 0; I < OperatorCount; ++I) {
+        auto TheOperator = static_cast<Operator>(I);
+        Operators[I] = B.operatorTagHelper(B.toString(TheOperator)).toString();
+      }
+
+      for (size_t I = 0; I < KeywordCount; ++I) {
+        auto TheKeyword = static_cast<Keyword>(I);
+        Keywords[I] = B.keywordTagHelper(B.toString(TheKeyword)).toString();
+      }
+
+      for (size_t I = 0; I < DirectiveCount; ++I) {
+        auto TheDirective = static_cast<Directive>(I);
+        Directives[I] = B.directiveTagHelper(B.toString(TheDirective))
+                          .toString();
+      }
+    }
+  };
+
+  const FixedTokens &getFixedTokens() const {
+    // Only the tagless mode affects how these tokens are rendered
+    static const FixedTokens WithTags(CBuilder(false));
+    static const FixedTokens Tagless(CBuilder(true));
+    return IsInTaglessMode ? Tagless : WithTags;
+  }
+
 public:
   // Operators.
-  Tag getOperator(Operator OperatorOp) const {
-    return operatorTagHelper(toString(OperatorOp));
+  const std::string &getOperator(Operator OperatorOp) const {
+    return getFixedTokens().Operators[static_cast<size_t>(OperatorOp)];
   }
 
   // Constants.
@@ -354,11 +391,11 @@ public:
   }
 
   // Keywords.
-  Tag getKeyword(Keyword TheKeyword) const {
-    return keywordTagHelper(toString(TheKeyword));
+  const std::string &getKeyword(Keyword TheKeyword) const {
+    return getFixedTokens().Keywords[static_cast<size_t>(TheKeyword)];
   }
 
-  ptml::Tag getTypeKeyword(const model::TypeDefinition &T) const {
+  const std::string &getTypeKeyword(const model::TypeDefinition &T) const {
     if (llvm::isa<model::EnumDefinition>(T))
       return getKeyword(ptml::CBuilder::Keyword::Enum);
 
@@ -404,8 +441,8 @@ public:
   }
 
   // Directives.
-  Tag getDirective(Directive TheDirective) const {
-    return directiveTagHelper(toString(TheDirective));
+  const std::string &getDirective(Directive TheDirective) const {
+    return getFixedTokens().Directives[static_cast<size_t>(TheDirective)];
   }
 
   // Helpers.
@@ -0,0 +1,39 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <cstdint>
+#include <vector>
+
+#include "revng/Model/Binary.h"
+
+/// An immutable index over the segments of a model::Binary, answering which
+/// segment contains a given generic address in O(log n).
+///
+/// The index refers to the segments of the binary it has been built from, so
+/// it must not outlive it, and it must be rebuilt if the segments change.
+class SegmentIndex {
+private:
+  struct Entry {
+    uint64_t Start = 0;
+    uint64_t End = 0;
+    /// The largest End of this entry and all the ones preceding it, used to
+    /// stop looking for overlapping segments
+    uint64_t MaxEnd = 0;
+    const model::Segment *Segment = nullptr;
+  };
+
+private:
+  std::vector<Entry> Entries;
+
+public:
+  explicit SegmentIndex(const model::Binary &Binary);
+
+public:
+  /// \return the segment containing \p Address, or nullptr if there is none.
+  ///
+  /// \note asserts if more than one segment contains \p Address.
+  const model::Segment *find(uint64_t Address) const;
+};
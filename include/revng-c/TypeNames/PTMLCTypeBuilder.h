@@ -4,12 +4,35 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <memory>
+#include <set>
+
 #include "revng-c/Backend/DecompiledCCodeIndentation.h"
 #include "revng-c/Support/PTMLC.h"
 #include "revng-c/TypeNames/DependencyGraph.h"
 
 namespace ptml {
 
+/// The results of `CTypeBuilder::collectInlinableTypes`, which only depend on
+/// the model.
+struct InlinableTypes {
+  /// The dependency graph of all the type definitions
+  DependencyGraph Dependencies;
+
+  /// The keys of the types that should be inlined into their only user
+  std::set<model::TypeDefinition::Key> TypesToInline;
+
+  /// The keys of the stack frame types of all the functions
+  std::set<model::TypeDefinition::Key> StackFrameTypes;
+};
+
+/// Compute the InlinableTypes of \p Model.
+///
+/// The result can be shared by all the builders working on \p Model, as long
+/// as its type definitions and stack frames do not change.
+std::shared_ptr<const InlinableTypes>
+getInlinableTypes(const model::Binary &Model);
+
 class CTypeBuilder : public CBuilder {
 public:
   using OutStream = ptml::IndentedOstream;
@@ -59,17 +82,12 @@ private:
   /// wrappers).
   std::map<model::UpcastableType, std::string> ArtificialNameCache = {};
 
-  /// This is the cache containing the dependency data for the types.
-  /// It is here so that we don't have to recompute it with multiple invocations
-  std::optional<DependencyGraph> DependencyCache = std::nullopt;
-
-  /// This is the cache containing the keys of the types that should be inlined
-  /// into their only user.
-  std::set<model::TypeDefinition::Key> TypesToInlineCache = {};
-
-  /// This is the cache containing the keys of the stack frame types that
-  /// should be inlined into the functions they belong to.
-  std::set<model::TypeDefinition::Key> StackFrameTypeCache = {};
+  /// This is the cache containing the dependency data for the types, and the
+  /// types that should be inlined.
+  /// It is here so that we don't have to recompute it with multiple
+  /// invocations. It is shared with all the other builders working on the
+  /// same model.
+  std::shared_ptr<const InlinableTypes> InlinableCache = nullptr;
 
   /// Is only set to true if \ref collectInlinableTypes was invoked.
   bool InlinableCacheIsReady = false;
@@ -80,17 +98,26 @@ public:
   /// \ref printTypeDefinition.
   void collectInlinableTypes(const model::Binary &Model);
 
+  /// Same as \ref collectInlinableTypes, but reuse \p Types, obtained from
+  /// `getInlinableTypes`. This avoids computing them again when many builders
+  /// are created for the same model.
+  void collectInlinableTypes(std::shared_ptr<const InlinableTypes> Types) {
+    revng_assert(Types != nullptr);
+    InlinableCache = std::move(Types);
+    InlinableCacheIsReady = true;
+  }
+
   bool shouldInline(model::TypeDefinition::Key Key) const {
     revng_assert(InlinableCacheIsReady,
                  "`shouldInline` must not be called before "
                  "`collectInlinableTypes`.");
 
-    if (not TypesToInlineCache.contains(Key)) {
+    if (not InlinableCache->TypesToInline.contains(Key)) {
       // This type is not allowed be inlined.
       return false;
     }
 
-    if (StackFrameTypeCache.contains(Key)) {
+    if (InlinableCache->StackFrameTypes.contains(Key)) {
       // This is a stack frame.
       return Configuration.EnableStackFrameInlining;
 
@@ -143,6 +170,7 @@ public:
 
 public:
   void append(std::string &&Text) { *Out << std::move(Text); }
+  void append(const std::string &Text) { *Out << Text; }
   void appendLineComment(std::string &&Text) {
     append(getLineComment(std::move(Text)));
   }
@@ -4,6 +4,7 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <memory>
 #include <optional>
 
 #include "mlir/IR/MLIRContext.h"
@@ -33,4 +34,37 @@ importModelType(llvm::function_ref<mlir::InFlightDiagnostic()> EmitError,
                 mlir::MLIRContext &Context,
                 const model::Type &ModelType);
 
+/// Converts model types to Clift types in the specified context, remembering
+/// the type definitions already converted, so that converting many types
+/// sharing the same definitions converts each of them only once.
+///
+/// \p EmitError must outlive the importer.
+class ModelTypeImporter {
+  class Implementation;
+  std::unique_ptr<Implementation> Impl;
+
+public:
+  ModelTypeImporter(llvm::function_ref<mlir::InFlightDiagnostic()> EmitError,
+                    mlir::MLIRContext &Context);
+  ~ModelTypeImporter();
+
+  ModelTypeImporter(const ModelTypeImporter &) = delete;
+  ModelTypeImporter &operator=(const ModelTypeImporter &) = delete;
+
+  /// \return The corresponding Clift ValueType, or null on failure.
+  ValueType importType(const model::TypeDefinition &ModelType);
+
+  /// \return The corresponding Clift ValueType, or null on failure.
+  ValueType importType(const model::Type &ModelType);
+
+  /// Make the importer read again from the model the definitions it has
+  /// already converted, the first time each of them is imported after this
+  /// call. The imported types are the same.
+  ///
+  /// Users tracking the accesses to the model can use this to record, for each
+  /// import, the dependencies on the definitions converted earlier. Each
+  /// definition is still verified only once.
+  void forgetReads();
+};
+
 } // namespace mlir::clift
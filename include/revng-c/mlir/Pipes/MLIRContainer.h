@@ -23,18 +23,48 @@ public:
   static constexpr auto MIMEType = "application/x.mlir.bc";
 
 private:
-  // unique_ptr is used to allow moving the context.
-  std::unique_ptr<mlir::MLIRContext> Context;
+  // shared_ptr is used to allow moving the context, and to share it with the
+  // containers created by cloneFiltered, so that operations can be moved
+  // between them without serializing them.
+  std::shared_ptr<mlir::MLIRContext> Context;
   mlir::OwningOpRef<mlir::ModuleOp> Module;
 
+  // The number of functions erased or made external since the types and
+  // attributes of the context have been last garbage collected.
+  size_t RemovedSinceCollection = 0;
+
+  // The reader of the bytecode the module has been deserialized from, if the
+  // bodies of some of its functions have not been loaded yet. It's declared
+  // after Module, since it refers to its operations.
+  struct LazyBytecode;
+  mutable std::unique_ptr<LazyBytecode> Lazy;
+
 public:
   explicit MLIRContainer(const llvm::StringRef Name) :
     pipeline::Container<MLIRContainer>(Name) {
     clear();
   }
 
+  ~MLIRContainer() override;
+
+private:
+  MLIRContainer(const llvm::StringRef Name,
+                std::shared_ptr<mlir::MLIRContext> SharedContext);
+
+  void collectGarbage();
+
+  void pruneSymbols();
+
+  bool isDefined(mlir::FunctionOpInterface F) const;
+  void materialize(mlir::Operation *Op) const;
+  void materializeAll() const;
+
+public:
   mlir::MLIRContext *getContext() { return Context.get(); }
-  mlir::ModuleOp getModule() { return *Module; }
+
+  // Loads the bodies of all the functions which have not been loaded yet.
+  mlir::ModuleOp getModule();
+
   void setModule(mlir::OwningOpRef<mlir::ModuleOp> &&NewModule);
 
   std::unique_ptr<pipeline::ContainerBase>
@@ -4,6 +4,7 @@
 
 #include <utility>
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
@@ -24,10 +25,13 @@
 #include "llvm/IR/Type.h"
 #include "llvm/IR/Value.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/Progress.h"
 #include "llvm/Support/YAMLTraits.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
 
 #include "revng/ABI/FunctionType/Layout.h"
 #include "revng/EarlyFunctionAnalysis/ControlFlowGraphCache.h"
@@ -57,6 +61,7 @@
 #include "revng-c/Pipes/Ranks.h"
 #include "revng-c/RestructureCFG/ASTNode.h"
 #include "revng-c/RestructureCFG/ASTNodeUtils.h"
+#include "revng-c/RestructureCFG/ASTSerialization.h"
 #include "revng-c/RestructureCFG/ASTTree.h"
 #include "revng-c/RestructureCFG/BeautifyGHAST.h"
 #include "revng-c/RestructureCFG/RestructureCFG.h"
@@ -101,6 +106,12 @@ static constexpr const char *StackFrameVarName = "_stack";
 static Logger<> Log{ "c-backend" };
 static Logger<> VisitLog{ "c-backend-visit-order" };
 
+static llvm::cl::opt<bool>
+  MemoizeExpressions("c-backend-memoize-expressions",
+                     llvm::cl::desc("Emit each expression only once, and "
+                                    "reuse its token at each use"),
+                     llvm::cl::init(true));
+
 static bool isStackFrameDecl(const llvm::Value *I) {
   auto *Call = dyn_cast_or_null<llvm::CallInst>(I);
   if (not Call)
@@ -250,6 +261,9 @@ private:
   /// A map containing a model type for each LLVM value in the function
   const ModelTypesMap TypeMap;
 
+  /// The model types serialized in the IR, deserialized lazily and only once
+  mutable ModelTypeTable Types;
+
   /// Helper for outputting the decompiled C code
   ptml::CTypeBuilder &B;
 
@@ -268,6 +282,9 @@ private:
   ///       getCallEdge.
   ControlFlowGraphCache &Cache;
 
+  /// Where to record the parts of the model the C code depends on, if any
+  ModelReads *Reads = nullptr;
+
 private:
   class VarNameGenerator {
   private:
@@ -287,11 +304,17 @@ private:
   VarNameGenerator NameGenerator;
 
   /// Keep track of the names associated with function arguments, and local
-  /// variables. In the past it also kept track of intermediate expressions, but
-  /// with the new design all the tokens corresponding to instructions that
-  /// don't represent local variables are recomputed every time.
+  /// variables.
   TokenMapT TokenMap;
 
+  /// The tokens of the expressions that have already been emitted, so that
+  /// expressions used many times are rendered only once. Instructions with a
+  /// single use are not kept: their token is spliced into that of their user,
+  /// and keeping it too would make long chains quadratic in memory. Tokens
+  /// might refer to the names in TokenMap, so they are dropped if any of
+  /// those changes.
+  mutable llvm::DenseMap<const llvm::Value *, std::string> ExpressionTokens;
+
 private:
   /// Name of the local variable used to break out from loops
   std::string LoopStateVar;
@@ -301,13 +324,32 @@ private:
   /// Emission of parentheses may change whether the OPRP is enabled or not
   bool IsOperatorPrecedenceResolutionPassEnabled = false;
 
+private:
+  /// Record that the C code depends on \p Entity, if reads are recorded
+  template<typename T>
+  void recordRead(const T &Entity) const {
+    if (Reads != nullptr)
+      Reads->read(Entity);
+  }
+
+  /// Record that the C code depends on the function called by \p Call
+  void recordCalleeRead(const llvm::CallInst *Call) const;
+
+  /// Get the model type serialized in \p V, and record the read
+  const model::UpcastableType &getSerializedType(llvm::Value *V) const {
+    const model::UpcastableType &Result = Types.get(V);
+    recordRead(*Result);
+    return Result;
+  }
+
 public:
   CCodeGenerator(ControlFlowGraphCache &Cache,
                  const Binary &Model,
                  const llvm::Function &LLVMFunction,
                  const ASTTree &GHAST,
                  const ASTVarDeclMap &VarToDeclare,
-                 ptml::CTypeBuilder &B) :
+                 ptml::CTypeBuilder &B,
+                 ModelReads *Reads) :
     Model(Model),
     LLVMFunction(LLVMFunction),
     ModelFunction(*llvmToModelFunction(Model, LLVMFunction)),
@@ -318,9 +360,16 @@ public:
                            &ModelFunction,
                            Model,
                            /* PointersOnly = */ false)),
+    Types(Model),
     B(B),
     SwitchStateVars(),
-    Cache(Cache) {
+    Cache(Cache),
+    Reads(Reads) {
+    recordRead(ModelFunction);
+    recordRead(Prototype);
+    for (const auto &[Value, Type] : TypeMap)
+      recordRead(*Type);
+
     // TODO: don't use a global loop state variable
     static const char *LoopStateVarName = "_loop_state_var";
     LoopStateVar = B.getVariableLocationReference(LoopStateVarName,
@@ -414,7 +463,10 @@ private:
                  or isCallStackArgumentDecl(I));
     std::string VarName = NameGenerator.nextVarName();
     // This may override the entry for I, if I belongs to a "duplicated"
-    // BasicBlock that is reachable from many paths on the GHAST.
+    // BasicBlock that is reachable from many paths on the GHAST. In that case
+    // the expressions emitted so far might refer to the old name.
+    if (TokenMap.contains(I))
+      ExpressionTokens.clear();
     TokenMap[I] = B.getVariableLocationReference(VarName, ModelFunction);
     return B.getVariableLocationDefinition(VarName, ModelFunction);
   }
@@ -590,7 +642,7 @@ CCodeGenerator::getModelGEPToken(const llvm::CallInst *Call) const {
 
   // First argument is a string containing the base type
   auto *CurArg = Call->arg_begin();
-  model::UpcastableType CurType = fromLLVMString(CurArg->get(), Model);
+  model::UpcastableType CurType = getSerializedType(CurArg->get());
 
   // Second argument is the base llvm::Value
   ++CurArg;
@@ -682,8 +734,8 @@ CCodeGenerator::getModelGEPToken(const llvm::CallInst *Call) const {
 
   std::string CurExpr = addParentheses(BaseString);
   using PTMLOperator = ptml::CBuilder::Operator;
-  Tag Deref = UseArrow ? B.getOperator(PTMLOperator::Arrow) :
-                         B.getOperator(PTMLOperator::Dot);
+  llvm::StringRef Deref = UseArrow ? B.getOperator(PTMLOperator::Arrow) :
+                                     B.getOperator(PTMLOperator::Dot);
 
   // Traverse the model to decide whether to emit "." or "[]"
   for (; CurArg != Call->arg_end(); ++CurArg) {
@@ -695,7 +747,7 @@ CCodeGenerator::getModelGEPToken(const llvm::CallInst *Call) const {
       auto *FieldIdxConst = cast<llvm::ConstantInt>(CurArg->get());
       uint64_t FieldIdx = FieldIdxConst->getValue().getLimitedValue();
 
-      CurExpr += Deref.toString();
+      CurExpr += Deref;
 
       // Find the field name
       const model::TypeDefinition &Definition = D->unwrap();
@@ -758,7 +810,7 @@ CCodeGenerator::getCustomOpcodeToken(const llvm::CallInst *Call) const {
   if (isCallToTagged(Call, FunctionTags::ModelCast)) {
     // First argument is a string containing the base type
     auto *CurArg = Call->arg_begin();
-    model::UpcastableType CurType = fromLLVMString(CurArg->get(), Model);
+    const model::UpcastableType &CurType = getSerializedType(CurArg->get());
 
     // Second argument is the base llvm::Value
     ++CurArg;
@@ -777,8 +829,8 @@ CCodeGenerator::getCustomOpcodeToken(const llvm::CallInst *Call) const {
   if (isCallToTagged(Call, FunctionTags::AddressOf)) {
     // First operand is the type of the value being addressed (should not
     // introduce casts)
-    const model::UpcastableType ArgType = fromLLVMString(Call->getArgOperand(0),
-                                                         Model);
+    const model::UpcastableType
+      &ArgType = getSerializedType(Call->getArgOperand(0));
 
     // Second argument is the value being addressed
     llvm::Value *Arg = Call->getArgOperand(1);
@@ -823,6 +875,8 @@ CCodeGenerator::getCustomOpcodeToken(const llvm::CallInst *Call) const {
     const llvm::Function *Callee = getCalledFunction(CallReturnsStruct);
     const auto &CalleePrototype = getCallSitePrototype(Model,
                                                        CallReturnsStruct);
+    if (CalleePrototype)
+      recordRead(*CalleePrototype);
 
     std::string StructFieldRef;
     if (not CalleePrototype) {
@@ -845,7 +899,9 @@ CCodeGenerator::getCustomOpcodeToken(const llvm::CallInst *Call) const {
     auto *Callee = getCalledFunction(Call);
     const auto &[StartAddress,
                  VirtualSize] = extractSegmentKeyFromMetadata(*Callee);
-    model::Segment Segment = Model.Segments().at({ StartAddress, VirtualSize });
+    const model::Segment &Segment = Model.Segments().at({ StartAddress,
+                                                          VirtualSize });
+    recordRead(Segment);
     auto Name = Segment.name();
 
     rc_return B.getLocationReference(Segment);
@@ -894,6 +950,21 @@ CCodeGenerator::getCustomOpcodeToken(const llvm::CallInst *Call) const {
   rc_return "";
 }
 
+void CCodeGenerator::recordCalleeRead(const llvm::CallInst *Call) const {
+  if (Reads == nullptr)
+    return;
+
+  const auto &[CallEdge, _] = Cache.getCallEdge(Model, Call);
+  revng_assert(CallEdge);
+  if (not CallEdge->DynamicFunction().empty()) {
+    auto &DynFuncID = CallEdge->DynamicFunction();
+    recordRead(Model.ImportedDynamicFunctions().at(DynFuncID));
+  } else if (const llvm::Function *Callee = getCalledFunction(Call)) {
+    if (const model::Function *ModelFunc = llvmToModelFunction(Model, *Callee))
+      recordRead(*ModelFunc);
+  }
+}
+
 RecursiveCoroutine<std::string>
 CCodeGenerator::getIsolatedCallToken(const llvm::CallInst *Call) const {
 
@@ -912,6 +983,7 @@ CCodeGenerator::getIsolatedCallToken(const llvm::CallInst *Call) const {
       // Dynamic Function
       auto &DynFuncID = CallEdge->DynamicFunction();
       auto &DynamicFunc = Model.ImportedDynamicFunctions().at(DynFuncID);
+      recordRead(DynamicFunc);
       std::string Location = locationString(ranks::DynamicFunction,
                                             DynamicFunc.key());
       CalleeToken = B.getTag(ptml::tags::Span, DynamicFunc.name().str())
@@ -926,6 +998,7 @@ CCodeGenerator::getIsolatedCallToken(const llvm::CallInst *Call) const {
       const model::Function *ModelFunc = llvmToModelFunction(Model,
                                                              *CalledFunc);
       revng_assert(ModelFunc);
+      recordRead(*ModelFunc);
       std::string Location = locationString(ranks::Function, ModelFunc->key());
       CalleeToken = B.getTag(ptml::tags::Span, ModelFunc->name().str())
                       .addAttribute(attributes::Token, tokens::Function)
@@ -938,6 +1011,8 @@ CCodeGenerator::getIsolatedCallToken(const llvm::CallInst *Call) const {
   // Build the call expression
   revng_assert(not CalleeToken.empty());
   const auto *Prototype = getCallSitePrototype(Model, Call);
+  if (Prototype != nullptr)
+    recordRead(*Prototype);
   rc_return rc_recur getCallToken(Call, CalleeToken, Prototype);
 }
 
@@ -981,7 +1056,7 @@ static std::string addDebugInfo(const llvm::Instruction *I,
 /// Return the string that represents the given binary operator in C
 static const std::string getBinOpString(const llvm::BinaryOperator *BinOp,
                                         const ptml::CBuilder &B) {
-  const Tag Op = [&BinOp, &B]() {
+  const std::string &Op = [&BinOp, &B]() -> const std::string & {
     bool IsBool = BinOp->getType()->isIntegerTy(1);
 
     using PTMLOperator = ptml::CBuilder::Operator;
@@ -1023,7 +1098,7 @@ static const std::string getBinOpString(const llvm::BinaryOperator *BinOp,
 static const std::string getCmpOpString(const llvm::CmpInst::Predicate &Pred,
                                         const ptml::CBuilder &B) {
   using llvm::CmpInst;
-  const Tag Op = [&Pred, &B]() {
+  const std::string &Op = [&Pred, &B]() -> const std::string & {
     switch (Pred) {
     case CmpInst::ICMP_EQ: ///< equal
       return B.getOperator(ptml::CBuilder::Operator::CmpEq);
@@ -1140,8 +1215,7 @@ CCodeGenerator::getInstructionToken(const llvm::Instruction *I) const {
 
   case llvm::Instruction::Ret: {
 
-    std::string Result = B.getKeyword(ptml::CBuilder::Keyword::Return)
-                           .toString();
+    std::string Result = B.getKeyword(ptml::CBuilder::Keyword::Return);
     if (auto *Ret = llvm::cast<llvm::ReturnInst>(I);
         llvm::Value *ReturnedVal = Ret->getReturnValue())
       Result += " " + rc_recur getToken(ReturnedVal);
@@ -1206,17 +1280,29 @@ CCodeGenerator::getToken(const llvm::Value *V) const {
                and not isArtificialAggregateLocalVarDecl(V)
                and not isHelperAggregateLocalVarDecl(V));
 
-  if (isCConstant(V))
-    rc_return rc_recur getConstantToken(V);
-
-  if (auto *I = dyn_cast<llvm::Instruction>(V))
-    rc_return rc_recur getInstructionToken(I);
+  if (MemoizeExpressions and isa<llvm::Instruction>(V)) {
+    if (auto CachedIt = ExpressionTokens.find(V);
+        CachedIt != ExpressionTokens.end()) {
+      revng_log(Log, "Already emitted");
+      rc_return CachedIt->second;
+    }
+  }
 
-  std::string Error = "Cannot get token for llvm::Value: ";
-  Error += dumpToString(V).c_str();
-  revng_abort(Error.c_str());
+  std::string Token;
+  if (isCConstant(V)) {
+    Token = rc_recur getConstantToken(V);
+  } else if (auto *I = dyn_cast<llvm::Instruction>(V)) {
+    Token = rc_recur getInstructionToken(I);
+  } else {
+    std::string Error = "Cannot get token for llvm::Value: ";
+    Error += dumpToString(V).c_str();
+    revng_abort(Error.c_str());
+  }
 
-  rc_return "";
+  if (MemoizeExpressions and isa<llvm::Instruction>(V)
+      and V->hasNUsesOrMore(2))
+    ExpressionTokens[V] = Token;
+  rc_return Token;
 }
 
 RecursiveCoroutine<std::string>
@@ -1330,6 +1416,7 @@ void CCodeGenerator::emitBasicBlock(const llvm::BasicBlock *BB,
     }
 
     if (Call != nullptr and isCallToIsolatedFunction(Call)) {
+      recordCalleeRead(Call);
       const auto &[CallEdge, _] = Cache.getCallEdge(Model, Call);
       if (CallEdge->hasAttribute(Model, model::FunctionAttribute::NoReturn))
         B.append("// The previous function call does not return\n");
@@ -1413,11 +1500,11 @@ CCodeGenerator::buildGHASTCondition(const ExprNode *E, bool EmitBB) {
       using Operator = ptml::CBuilder::Operator;
       switch (Comparison) {
       case CompareNode::ComparisonKind::Comparison_Equal: {
-        auto CmpString = B.getOperator(Operator::CmpEq);
+        const auto &CmpString = B.getOperator(Operator::CmpEq);
         CompareNodeString += " " + CmpString;
       } break;
       case CompareNode::ComparisonKind::Comparison_NotEqual: {
-        auto CmpString = B.getOperator(Operator::CmpNeq);
+        const auto &CmpString = B.getOperator(Operator::CmpNeq);
         CompareNodeString += " " + CmpString;
       } break;
       default: {
@@ -1497,10 +1584,10 @@ CCodeGenerator::buildGHASTCondition(const ExprNode *E, bool EmitBB) {
     std::string Child1Token = rc_recur buildGHASTCondition(Child1, EmitBB);
     std::string Child2Token = rc_recur buildGHASTCondition(Child2, EmitBB);
     using PTMLOperator = ptml::CBuilder::Operator;
-    const Tag &OpToken = E->getKind() == NodeKind::NK_And ?
-                           B.getOperator(PTMLOperator::BoolAnd) :
-                           B.getOperator(PTMLOperator::BoolOr);
-    rc_return addAlwaysParentheses(Child1Token) + " " + OpToken.toString() + " "
+    const std::string &OpToken = E->getKind() == NodeKind::NK_And ?
+                                   B.getOperator(PTMLOperator::BoolAnd) :
+                                   B.getOperator(PTMLOperator::BoolOr);
+    rc_return addAlwaysParentheses(Child1Token) + " " + OpToken + " "
       + addAlwaysParentheses(Child2Token);
   } break;
 
@@ -1512,7 +1599,7 @@ CCodeGenerator::buildGHASTCondition(const ExprNode *E, bool EmitBB) {
 static std::string makeWhile(const ptml::CBuilder &B,
                              const std::string &CondExpr) {
   revng_assert(not CondExpr.empty());
-  return B.getKeyword(ptml::CBuilder::Keyword::While).toString() + " ("
+  return B.getKeyword(ptml::CBuilder::Keyword::While) + " ("
          + CondExpr + ")";
 }
 
@@ -1550,6 +1637,7 @@ RecursiveCoroutine<void> CCodeGenerator::emitGHASTNode(const ASTNode *N) {
         revng_assert(not VarName.empty());
         const auto *Prototype = getCallSitePrototype(Model, VarDeclCall);
         revng_assert(Prototype != nullptr);
+        recordRead(*Prototype);
 
         auto Named = B.getNamedInstanceOfReturnType(*Prototype, VarName, false);
         B.append(Named.str().str() + ";\n");
@@ -1754,7 +1842,7 @@ RecursiveCoroutine<void> CCodeGenerator::emitGHASTNode(const ASTNode *N) {
     revng_assert(not SwitchVarToken.empty());
 
     // Generate the switch statement
-    B.append(B.getKeyword(ptml::CBuilder::Keyword::Switch).toString() + " ("
+    B.append(B.getKeyword(ptml::CBuilder::Keyword::Switch) + " ("
              + SwitchVarToken.str().str() + ") ");
     {
       Scope TheScope = B.getCurvedBracketScope();
@@ -1775,10 +1863,13 @@ RecursiveCoroutine<void> CCodeGenerator::emitGHASTNode(const ASTNode *N) {
           if (SwitchVar) {
             llvm::Type *SwitchVarT = SwitchVar->getType();
             auto *IntType = cast<llvm::IntegerType>(SwitchVarT);
-            auto *CaseConst = llvm::ConstantInt::get(IntType, CaseVal);
+            // Build the APInt directly instead of going through a
+            // ConstantInt: the LLVMContext must not be touched here, since
+            // functions can be emitted concurrently.
+            llvm::APInt CaseConst(IntType->getBitWidth(), CaseVal);
             // TODO: assigned the signedness based on the signedness of the
             // condition
-            B.append(B.getNumber(CaseConst->getValue()).toString());
+            B.append(B.getNumber(CaseConst).toString());
           } else {
             B.append(B.getNumber(CaseVal).toString());
           }
@@ -1960,13 +2051,20 @@ static std::string decompileFunction(ControlFlowGraphCache &Cache,
                                      const Binary &Model,
                                      const ASTVarDeclMap &VarToDeclare,
                                      bool NeedsLocalStateVar,
-                                     ptml::CTypeBuilder &B) {
+                                     ptml::CTypeBuilder &B,
+                                     ModelReads *Reads) {
   std::string Result;
 
   llvm::raw_string_ostream Out(Result);
   B.setOutputStream(Out);
 
-  CCodeGenerator Backend(Cache, Model, LLVMFunc, CombedAST, VarToDeclare, B);
+  CCodeGenerator Backend(Cache,
+                         Model,
+                         LLVMFunc,
+                         CombedAST,
+                         VarToDeclare,
+                         B,
+                         Reads);
   Backend.emitFunction(NeedsLocalStateVar);
   Out.flush();
 
@@ -2006,28 +2104,28 @@ static ASTVarDeclMap computeVariableDeclarationScope(const llvm::Function &F,
   return computeVarDeclMap(GHAST, PendingVariables);
 }
 
-std::string decompile(ControlFlowGraphCache &Cache,
-                      llvm::Function &F,
-                      const model::Binary &Model,
-                      ptml::CTypeBuilder &B) {
-  using namespace llvm;
-  Task T2(3, Twine("decompile Function: ") + Twine(F.getName()));
-
-  // TODO: this will eventually become a GHASTContainer for revng pipeline
-  ASTTree GHAST;
+static void buildGHAST(llvm::Function &F,
+                       const model::Binary &Model,
+                       ASTTree &GHAST,
+                       llvm::Task &T) {
+  RestructureContext Context;
 
   // Generate the GHAST and beautify it.
-  {
-    T2.advance("restructureCFG");
-    restructureCFG(F, GHAST);
-    // TODO: beautification should be optional, but at the moment it's not
-    // truly so (if disabled, things crash). We should strive to make it
-    // optional for real.
-    T2.advance("beautifyAST");
-    beautifyAST(Model, F, GHAST);
-  }
+  T.advance("restructureCFG");
+  restructureCFG(F, GHAST, Context);
+  // TODO: beautification should be optional, but at the moment it's not
+  // truly so (if disabled, things crash). We should strive to make it
+  // optional for real.
+  T.advance("beautifyAST");
+  beautifyAST(Model, F, GHAST, Context);
+}
 
-  T2.advance("decompileFunction");
+static std::string emitC(ControlFlowGraphCache &Cache,
+                         const llvm::Function &F,
+                         const ASTTree &GHAST,
+                         const model::Binary &Model,
+                         ptml::CTypeBuilder &B,
+                         ModelReads *Reads = nullptr) {
   if (Log.isEnabled()) {
     GHAST.dumpASTOnFile(F.getName().str(),
                         "ast-backend",
@@ -2043,5 +2141,76 @@ std::string decompile(ControlFlowGraphCache &Cache,
                            Model,
                            VariablesToDeclare,
                            NeedsLoopStateVar,
-                           B);
+                           B,
+                           Reads);
+}
+
+std::string decompile(ControlFlowGraphCache &Cache,
+                      llvm::Function &F,
+                      const model::Binary &Model,
+                      ptml::CTypeBuilder &B) {
+  using namespace llvm;
+  Task T2(3, Twine("decompile Function: ") + Twine(F.getName()));
+
+  ASTTree GHAST;
+  buildGHAST(F, Model, GHAST, T2);
+
+  T2.advance("decompileFunction");
+  return emitC(Cache, F, GHAST, Model, B);
+}
+
+std::string restructure(llvm::Function &F, const model::Binary &Model) {
+  using namespace llvm;
+  Task T(2, Twine("restructure Function: ") + Twine(F.getName()));
+
+  // Beautification mutates the IR, restructure a temporary copy of F so that
+  // F stays as it is. The changes are recorded in the GHAST, and replayed on
+  // F when it gets decompiled.
+  ValueToValueMapTy VMap;
+  Function *Clone = CloneFunction(&F, VMap);
+
+  std::string Result;
+  {
+    ASTTree GHAST;
+    buildGHAST(*Clone, Model, GHAST, T);
+
+    raw_string_ostream Out(Result);
+    serializeAST(GHAST, *Clone, Out);
+  }
+
+  Clone->eraseFromParent();
+  return Result;
+}
+
+std::string decompile(ControlFlowGraphCache &Cache,
+                      llvm::Function &F,
+                      const model::Binary &Model,
+                      llvm::StringRef SerializedGHAST,
+                      ptml::CTypeBuilder &B) {
+  using namespace llvm;
+  Task T2(2, Twine("decompile Function: ") + Twine(F.getName()));
+
+  T2.advance("deserializeAST");
+  ASTTree GHAST = deserializeAST(SerializedGHAST, F);
+
+  T2.advance("decompileFunction");
+  return emitC(Cache, F, GHAST, Model, B);
+}
+
+void ModelReads::read(const model::Type &Type) {
+  if (const auto *Defined = llvm::dyn_cast<model::DefinedType>(&Type))
+    read(Defined->unwrap());
+  else if (const auto *Array = llvm::dyn_cast<model::ArrayType>(&Type))
+    read(*Array->ElementType());
+  else if (const auto *Pointer = llvm::dyn_cast<model::PointerType>(&Type))
+    read(*Pointer->PointeeType());
+}
+
+std::string decompileConcurrently(ControlFlowGraphCache &Cache,
+                                  const llvm::Function &F,
+                                  const ASTTree &GHAST,
+                                  const model::Binary &Model,
+                                  ptml::CTypeBuilder &B,
+                                  ModelReads &Reads) {
+  return emitC(Cache, F, GHAST, Model, B, &Reads);
 }
@@ -2,6 +2,16 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <atomic>
+#include <map>
+#include <vector>
+
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+
 #include "revng/Model/Binary.h"
 #include "revng/Pipeline/AllRegistries.h"
 #include "revng/Pipes/Kinds.h"
@@ -12,34 +22,227 @@
 #include "revng-c/Backend/DecompilePipe.h"
 #include "revng-c/HeadersGeneration/Options.h"
 #include "revng-c/Pipes/Kinds.h"
+#include "revng-c/RestructureCFG/ASTSerialization.h"
 #include "revng-c/TypeNames/PTMLCTypeBuilder.h"
 
+static llvm::cl::opt<unsigned> DecompileThreads("decompile-threads",
+                                                llvm::cl::desc("Number of "
+                                                               "threads used "
+                                                               "to decompile "
+                                                               "functions. 0 "
+                                                               "means one per "
+                                                               "hardware "
+                                                               "thread."),
+                                                llvm::cl::init(1));
+
 namespace revng::pipes {
 
 using namespace pipeline;
 static RegisterDefaultConstructibleContainer<DecompileStringMap> Reg;
 
+static ptml::CTypeBuilder::ConfigurationOptions getConfiguration() {
+  namespace options = revng::options;
+  return { .EnableTypeInlining = options::EnableTypeInlining,
+           .EnableStackFrameInlining = !options::DisableStackFrameInlining };
+}
+
+/// Read, on the tracked \p Model, everything the C code of a function has been
+/// emitted from, including all the types it refers to.
+class DependencyRecorder {
+  const model::Binary &Model;
+  llvm::DenseSet<const model::TypeDefinition *> Visited;
+
+public:
+  explicit DependencyRecorder(const model::Binary &Model) : Model(Model) {}
+
+public:
+  void read(const ModelReads &Reads) {
+    Model.Architecture();
+    Model.DefaultABI();
+    Model.Configuration();
+
+    for (const auto &Key : Reads.Functions)
+      read(Model.Functions().at(Key));
+
+    for (const auto &Key : Reads.DynamicFunctions)
+      read(Model.ImportedDynamicFunctions().at(Key));
+
+    for (const auto &Key : Reads.Segments)
+      read(Model.Segments().at(Key));
+
+    for (const auto &Key : Reads.TypeDefinitions)
+      read(*Model.TypeDefinitions().at(Key));
+  }
+
+private:
+  void read(const model::TypeDefinition &Root) {
+    llvm::SmallVector<const model::TypeDefinition *, 16> Worklist;
+    Worklist.push_back(&Root);
+    while (not Worklist.empty()) {
+      const model::TypeDefinition *T = Worklist.pop_back_val();
+      if (not Visited.insert(T).second)
+        continue;
+
+      T->verify();
+      T->name();
+      for (const model::Type *Edge : T->edges()) {
+        ModelReads Reached;
+        Reached.read(*Edge);
+        for (const auto &Key : Reached.TypeDefinitions)
+          Worklist.push_back(Model.TypeDefinitions().at(Key).get());
+      }
+    }
+  }
+
+  void read(const model::Type &Type) {
+    ModelReads Reached;
+    Reached.read(Type);
+    for (const auto &Key : Reached.TypeDefinitions)
+      read(*Model.TypeDefinitions().at(Key));
+  }
+
+  void read(const model::Function &Function) {
+    Function.verify();
+    Function.name();
+    read(*Model.prototypeOrDefault(Function.prototype()));
+    if (const model::TypeDefinition *StackFrame = Function.stackFrameType())
+      read(*StackFrame);
+  }
+
+  void read(const model::DynamicFunction &Function) {
+    Function.verify();
+    Function.name();
+    read(*Model.prototypeOrDefault(Function.prototype()));
+  }
+
+  void read(const model::Segment &Segment) {
+    Segment.verify();
+    Segment.name();
+    if (not Segment.Type().isEmpty())
+      read(*Segment.Type());
+  }
+};
+
+/// Decompile all the requested functions using a pool of workers.
+///
+/// Each worker owns a ControlFlowGraphCache and a ptml::CTypeBuilder, and
+/// picks the next function to decompile from a shared counter. All the workers
+/// read the same copy of the model, made on the main thread before they start,
+/// so that they never read the tracked model.
+/// The GHASTs are read from \p GHASTs, so that no function is restructured,
+/// and their changes to the IR are replayed serially before the workers
+/// start, since they mutate state shared across the whole module.
+///
+/// Once all the functions have been decompiled, the targets are committed one
+/// at a time through getFunctionsAndCommit. Since the reads of the workers
+/// are not tracked, the backend records in a ModelReads what it reads while
+/// decompiling each function, and the main thread replays those reads on the
+/// tracked model (see DependencyRecorder).
+static void decompileInParallel(pipeline::ExecutionContext &EC,
+                                llvm::Module &Module,
+                                const model::Binary &Model,
+                                const revng::pipes::CFGMap &CFGMap,
+                                const GHASTStringMap &GHASTs,
+                                DecompileStringMap &DecompiledFunctions) {
+  struct Job {
+    llvm::Function *F = nullptr;
+    ASTTree GHAST;
+    std::string CCode;
+    ModelReads Reads;
+  };
+
+  std::map<MetaAddress, Job> Jobs;
+  for (const pipeline::Target &Target :
+       EC.getRequestedTargetsFor(DecompiledFunctions)) {
+    auto Entry = MetaAddress::fromString(Target.getPathComponents()[0]);
+    const model::Function &Function = Model.Functions().at(Entry);
+    llvm::Function *F = Module.getFunction(getLLVMFunctionName(Function));
+    revng_assert(F != nullptr);
+    auto It = GHASTs.find(Entry);
+    revng_assert(It != GHASTs.end());
+
+    // Replaying the beautification on the IR is not thread-safe
+    Jobs.insert({ Entry, Job{ F, deserializeAST(It->second, *F), {}, {} } });
+  }
+
+  if (Jobs.empty())
+    return;
+
+  std::vector<Job *> Queue;
+  for (auto &[Entry, Current] : Jobs)
+    Queue.push_back(&Current);
+
+  auto Strategy = llvm::hardware_concurrency(DecompileThreads);
+  unsigned WorkerCount = Strategy.compute_thread_count();
+  if (WorkerCount > Queue.size())
+    WorkerCount = Queue.size();
+
+  // The inlinable types only depend on the model, share them among workers
+  auto Inlinable = ptml::getInlinableTypes(Model);
+
+  TupleTree<model::Binary> Snapshot = getModelFromContext(EC);
+
+  std::atomic<size_t> NextJob = 0;
+  {
+    llvm::ThreadPool Pool(Strategy);
+    for (unsigned I = 0; I < WorkerCount; ++I) {
+      Pool.async([&]() {
+        ControlFlowGraphCache Cache(CFGMap);
+        ptml::CTypeBuilder B(llvm::nulls(),
+                             /* EnableTaglessMode = */ false,
+                             getConfiguration());
+        B.collectInlinableTypes(Inlinable);
+
+        for (size_t Index = NextJob++; Index < Queue.size();
+             Index = NextJob++) {
+          Job &Current = *Queue[Index];
+          Current.CCode = decompileConcurrently(Cache,
+                                                *Current.F,
+                                                Current.GHAST,
+                                                *Snapshot,
+                                                B,
+                                                Current.Reads);
+        }
+      });
+    }
+    Pool.wait();
+  }
+
+  for (const model::Function &Function :
+       getFunctionsAndCommit(EC, DecompiledFunctions.name())) {
+    Job &Current = Jobs.at(Function.Entry());
+    DependencyRecorder(Model).read(Current.Reads);
+    DecompiledFunctions.insert_or_assign(Function.Entry(),
+                                         std::move(Current.CCode));
+  }
+}
+
 void Decompile::run(pipeline::ExecutionContext &EC,
                     pipeline::LLVMContainer &IRContainer,
                     const revng::pipes::CFGMap &CFGMap,
+                    const GHASTStringMap &GHASTs,
                     DecompileStringMap &DecompiledFunctions) {
 
   llvm::Module &Module = IRContainer.getModule();
   const model::Binary &Model = *getModelFromContext(EC);
-  ControlFlowGraphCache Cache(CFGMap);
 
-  namespace options = revng::options;
-  ptml::CTypeBuilder
-    B(llvm::nulls(),
-      /* EnableTaglessMode = */ false,
-      { .EnableTypeInlining = options::EnableTypeInlining,
-        .EnableStackFrameInlining = !options::DisableStackFrameInlining });
+  if (DecompileThreads != 1) {
+    decompileInParallel(EC, Module, Model, CFGMap, GHASTs, DecompiledFunctions);
+    return;
+  }
+
+  ControlFlowGraphCache Cache(CFGMap);
+  ptml::CTypeBuilder B(llvm::nulls(),
+                       /* EnableTaglessMode = */ false,
+                       getConfiguration());
   B.collectInlinableTypes(Model);
 
   for (const model::Function &Function :
        getFunctionsAndCommit(EC, DecompiledFunctions.name())) {
     llvm::Function *F = Module.getFunction(getLLVMFunctionName(Function));
-    std::string CCode = decompile(Cache, *F, Model, B);
+    auto It = GHASTs.find(Function.Entry());
+    revng_assert(It != GHASTs.end());
+    std::string CCode = decompile(Cache, *F, Model, It->second, B);
     DecompiledFunctions.insert_or_assign(Function.Entry(), std::move(CCode));
   }
 }
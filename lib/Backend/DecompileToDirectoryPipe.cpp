@@ -2,7 +2,14 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <vector>
+
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include "revng/EarlyFunctionAnalysis/ControlFlowGraphCache.h"
@@ -16,6 +23,7 @@
 #include "revng-c/HeadersGeneration/Options.h"
 #include "revng-c/HeadersGeneration/PTMLHeaderBuilder.h"
 #include "revng-c/Support/PTMLC.h"
+#include "revng-c/TypeNames/PTMLCTypeBuilder.h"
 
 namespace revng::pipes {
 
@@ -47,27 +55,48 @@ void DecompileToDirectory::run(pipeline::ExecutionContext &EC,
   B.collectInlinableTypes(Model);
 
   {
-    ControlFlowGraphCache Cache{ CFGMap };
-    DecompileStringMap DecompiledFunctions("tmp");
-    for (pipeline::Target &Target : CFGMap.enumerate()) {
-      auto Entry = MetaAddress::fromString(Target.getPathComponents()[0]);
-      llvm::Function *F = Module.getFunction(getLLVMFunctionName(Model
-                                                                   .Functions()
-                                                                   .at(Entry)));
-      std::string CCode = decompile(Cache, *F, Model, B);
-      DecompiledFunctions.insert_or_assign(Entry, std::move(CCode));
+    // The functions are sorted by entry address, as in a DecompileStringMap
+    std::vector<MetaAddress> Entries;
+    for (pipeline::Target &Target : CFGMap.enumerate())
+      Entries.push_back(MetaAddress::fromString(Target.getPathComponents()[0]));
+    llvm::sort(Entries);
+
+    // The size of a tar entry has to be known before its content is written,
+    // so the C code is streamed to a temporary file first. In this way, the
+    // body of each function is dropped as soon as it has been printed.
+    int FD = -1;
+    llvm::SmallString<128> FunctionsPath;
+    ErrorCode = llvm::sys::fs::createTemporaryFile("decompiled-functions",
+                                                   "c",
+                                                   FD,
+                                                   FunctionsPath);
+    if (ErrorCode)
+      revng_abort(ErrorCode.message().c_str());
+    llvm::FileRemover RemoveFunctions(FunctionsPath);
+
+    {
+      llvm::raw_fd_ostream Out{ FD, /* shouldClose */ true };
+      ptml::CTypeBuilder FileBuilder(Out, /* EnableTaglessMode = */ false);
+      ControlFlowGraphCache Cache{ CFGMap };
+      printSingleCFile(FileBuilder, [&](FunctionBodyPrinter Print) {
+        for (const MetaAddress &Entry : Entries) {
+          const model::Function &Function = Model.Functions().at(Entry);
+          llvm::Function *F = Module.getFunction(getLLVMFunctionName(Function));
+          Print(decompile(Cache, *F, Model, B));
+        }
+      });
     }
 
-    std::string DecompiledC;
-    llvm::raw_string_ostream Out{ DecompiledC };
-    B.setOutputStream(Out);
-    printSingleCFile(B, DecompiledFunctions, {} /* Targets */);
-
-    Out.flush();
+    auto BufferOrError = llvm::MemoryBuffer::getFile(FunctionsPath);
+    if (std::error_code ReadError = BufferOrError.getError()) {
+      std::string Message = "Cannot read " + FunctionsPath.str().str() + ": "
+                            + ReadError.message();
+      revng_abort(Message.c_str());
+    }
+    std::unique_ptr<llvm::MemoryBuffer> Buffer = std::move(*BufferOrError);
 
     TarWriter.append("decompiled/functions.c",
-                     llvm::ArrayRef{ DecompiledC.data(),
-                                     DecompiledC.length() });
+                     { Buffer->getBufferStart(), Buffer->getBufferSize() });
   }
 
   {
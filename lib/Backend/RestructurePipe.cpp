@@ -0,0 +1,36 @@
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include "revng/Model/Binary.h"
+#include "revng/Pipeline/AllRegistries.h"
+#include "revng/Pipes/Kinds.h"
+#include "revng/Pipes/ModelGlobal.h"
+#include "revng/Pipes/StringMap.h"
+
+#include "revng-c/Backend/DecompileFunction.h"
+#include "revng-c/Backend/RestructurePipe.h"
+#include "revng-c/Pipes/Kinds.h"
+
+namespace revng::pipes {
+
+using namespace pipeline;
+static RegisterDefaultConstructibleContainer<GHASTStringMap> Reg;
+
+void Restructure::run(pipeline::ExecutionContext &EC,
+                      pipeline::LLVMContainer &IRContainer,
+                      GHASTStringMap &GHASTContainer) {
+
+  llvm::Module &Module = IRContainer.getModule();
+  const model::Binary &Model = *getModelFromContext(EC);
+
+  for (const model::Function &Function :
+       getFunctionsAndCommit(EC, GHASTContainer.name())) {
+    llvm::Function *F = Module.getFunction(getLLVMFunctionName(Function));
+    GHASTContainer.insert_or_assign(Function.Entry(), restructure(*F, Model));
+  }
+}
+
+} // end namespace revng::pipes
+
+static pipeline::RegisterPipe<revng::pipes::Restructure> Y;
@@ -0,0 +1,499 @@
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <compare>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/InstIterator.h"
+
+#include "revng/MFP/MFP.h"
+#include "revng/Support/Debug.h"
+#include "revng/Support/FunctionTags.h"
+
+#include "revng-c/Support/DecompilationHelpers.h"
+#include "revng-c/Support/FunctionTags.h"
+
+#include "AvailableExpressions.h"
+
+static Logger<> Log{ "available-expressions" };
+
+using namespace llvm;
+
+// A set of AvailableExpressions, each represented by its index in an
+// ExpressionIndex
+using AvailableSet = BitVector;
+
+bool isStatement(const Instruction *I) {
+  // TODO: this is workaround for SelectInst being often involved in nasty
+  // huge dataflows.
+  // In the future we should drop this from here and add a separate pass after
+  // this, that takes care of forcing local variables for nasty dataflows.
+  if (isa<SelectInst>(I))
+    return true;
+
+  return hasSideEffects(*I);
+}
+
+// Program points are the only instructions that can change the set of
+// available expressions
+static bool isProgramPoint(const Instruction *I) {
+
+  // TODO: In the future this pass will have to be updated to handle
+  // Load/Store/Alloca instead of Copy/Assign/LocalVariable, in order to be
+  // able to use LLVM's alias analysis.
+  // For now we just assume that we don't have Load/Store/Alloca at all.
+  // Whenever we'll do the switchover, we'll have to replace all the logic
+  // of Copy/Assign/LocalVariable with Load/Store/Alloca, and just drop
+  // everything related to Copy/Assign/LocalVariable.
+  // PHINodes will have to be dealt with if/when we move this pass before
+  // ExitSSA.
+  revng_assert(not isa<LoadInst>(I) and not isa<StoreInst>(I)
+               and not isa<AllocaInst>(I) and not isa<PHINode>(I));
+
+  return isStatement(I) or mayReadMemory(*I);
+}
+
+static RecursiveCoroutine<std::optional<const Value *>>
+getAccessedLocalVariableFromModelGEP(const CallInst *ModelGEPRefCall) {
+  revng_assert(isCallToTagged(ModelGEPRefCall, FunctionTags::ModelGEPRef));
+
+  revng_assert(ModelGEPRefCall->arg_size() >= 2);
+
+  // If the ModelGEPRefCall has more than 2 arguments, and some of them are not
+  // constants, we cannot figure out all the list of potentially accessed local
+  // variables, so we just return nullptr.
+  for (const Use &GEPArg : llvm::drop_begin(ModelGEPRefCall->args(), 2)) {
+    if (not isa<Constant>(GEPArg.get()))
+      rc_return nullptr;
+  }
+
+  // If the Base argument of the ModelGEPRefCall isn't a LocalVariable, nor an
+  // Argument, nor another ModelGEPRef, we just return nullopt, meaning that
+  // this thing doesn't really access any local variable.
+  auto *GEPBase = ModelGEPRefCall->getArgOperand(1);
+  // If the GEPBase is directly an argument, we're done
+  if (isa<Argument>(GEPBase))
+    rc_return GEPBase;
+
+  // If the GEPBase is directly a LocalVariable, we're done
+  if (isCallToTagged(GEPBase, FunctionTags::AllocatesLocalVariable))
+    rc_return GEPBase;
+
+  // If the GEPBase is another ModelGEPRef we recur.
+  // Notice that we don't recur on ModelGEP, only on ModelGEPRef, because simple
+  // ModelGEP can have arbitrary base pointers, but they never access
+  // LocalVariables.
+  if (auto *NestedModelGEPRef = getCallToTagged(GEPBase,
+                                                FunctionTags::ModelGEPRef))
+    rc_return rc_recur getAccessedLocalVariableFromModelGEP(NestedModelGEPRef);
+
+  // Everything else cannot access local variables, so we return nullopt.
+  rc_return std::nullopt;
+}
+
+std::optional<const Value *> getAccessedLocalVariable(const Instruction *I) {
+
+  // If it's not a Copy not an Assign then it's not an access to a local
+  // variable.
+  const CallInst *CallToCopy = getCallToTagged(I, FunctionTags::Copy);
+  const CallInst *CallToAssign = getCallToTagged(I, FunctionTags::Assign);
+  if (not CallToCopy and not CallToAssign)
+    return std::nullopt;
+
+  const CallInst *AccessCall = CallToCopy ? CallToCopy : CallToAssign;
+
+  unsigned AccessArgumentNumber = CallToAssign ? 1 : 0;
+  const auto *Accessed = AccessCall->getArgOperand(AccessArgumentNumber);
+
+  // If the accessed thing is directly an Argument or a LocalVariable we're
+  // done.
+  if (isa<Argument>(Accessed)
+      or isCallToTagged(Accessed, FunctionTags::AllocatesLocalVariable)) {
+    return Accessed;
+  }
+
+  // If the accessed thing is not a ModelGEPRef, then it's not an access to a
+  // local variable.
+  auto *ModelGEPRef = getCallToTagged(Accessed, FunctionTags::ModelGEPRef);
+  if (not ModelGEPRef)
+    return std::nullopt;
+
+  return getAccessedLocalVariableFromModelGEP(ModelGEPRef);
+}
+
+// The information about an instruction that is required to tell whether it
+// might alias with another one.
+struct AliasInfo {
+  bool MayAccessMemory = false;
+
+  // The local variable accessed by the instruction, with the same semantics
+  // as the result of getAccessedLocalVariable.
+  std::optional<const Value *> LocalVariable;
+
+  bool operator==(const AliasInfo &) const = default;
+  std::strong_ordering operator<=>(const AliasInfo &) const = default;
+};
+
+static bool localVariablesNoAlias(const AliasInfo &I, const AliasInfo &J) {
+
+  // Copies from local variables never alias anyone else, except other
+  // instructions that copy or assign the same local variable
+  const std::optional<const Value *> &MayBeAccessedByI = I.LocalVariable;
+  const std::optional<const Value *> &MayBeAccessedByJ = J.LocalVariable;
+
+  // If either doesn't access a local variable, they are noAlias.
+  if (not MayBeAccessedByI.has_value() or not MayBeAccessedByJ.has_value())
+    return true;
+
+  const Value *AccessedByI = *MayBeAccessedByI;
+  const Value *AccessedByJ = *MayBeAccessedByJ;
+
+  // If either is nullptr, there is at least one among I and J that access many
+  // variables, and we just can't say with certainty that they are noAlias
+  if (nullptr == AccessedByI or nullptr == AccessedByJ)
+    return false;
+
+  // For all the other cases they are noAlias only if the accessed
+  // local variable is different.
+  return AccessedByI != AccessedByJ;
+}
+
+static bool doesNotAccessMemory(const Instruction *I) {
+  auto *Call = dyn_cast_or_null<CallInst>(I);
+  return Call and Call->getMemoryEffects().doesNotAccessMemory();
+}
+
+static AliasInfo getAliasInfo(const Instruction *I) {
+  // If the instruction doesn't access memory, the accessed local variable
+  // doesn't matter. Leave it empty, so that all such instructions share the
+  // same AliasInfo.
+  if (doesNotAccessMemory(I))
+    return AliasInfo{ .MayAccessMemory = false, .LocalVariable = std::nullopt };
+
+  return AliasInfo{ .MayAccessMemory = true,
+                    .LocalVariable = getAccessedLocalVariable(I) };
+}
+
+static bool noAlias(const AliasInfo &I, const AliasInfo &J) {
+  // If either instruction doesn't access memory, they are noAlias for sure.
+  if (not I.MayAccessMemory or not J.MayAccessMemory)
+    return true;
+
+  // Here both instructions access memory.
+
+  // First, handle LocalVariables specifically.
+  // TODO: this is a poor's man alias analysis, which only explicitly handles
+  // stuff that is frequent and that we care about. In the future we have plans
+  // to replace it with a full fledged AliasAnalysis from LLVM
+  if (localVariablesNoAlias(I, J))
+    return true;
+
+  // TODO: In all the other cases, to reason accurately about aliasing, we would
+  // need LLVM's alias analysis. At the moment this is out of scope, so we
+  // always fall back to false, meaning that we can't say for sure that I and J
+  // do not alias.
+  return false;
+}
+
+AvailableExpressionVector getGeneratedExpressions(Instruction *I) {
+  AvailableExpressionVector Result;
+
+  if (auto *Assign = getCallToTagged(I, FunctionTags::Assign)) {
+    if (isa<Instruction>(Assign->getArgOperand(0))) {
+      Result.push_back(AvailableExpression{
+        .Expression = cast<Instruction>(Assign->getArgOperand(0)),
+        .Assign = Assign,
+      });
+    }
+  }
+
+  if (mayReadMemory(*I)) {
+    Result.push_back(AvailableExpression{
+      .Expression = I,
+      .Assign = nullptr,
+    });
+  }
+
+  return Result;
+}
+
+// Assigns a dense index to all the AvailableExpressions that can be generated
+// in a function, so that sets of them can be represented as bit vectors.
+// Indices follow the ordering of AvailableExpression, so all the
+// AvailableExpressions of the same Expression have contiguous indices.
+class ExpressionIndex {
+private:
+  std::vector<AvailableExpression> Expressions;
+
+  // For each AliasInfo, the AvailableExpressions whose Expression or Assign
+  // have that AliasInfo
+  std::map<AliasInfo, AvailableSet> ByAliasInfo;
+
+  // For each AliasInfo of a statement, the AvailableExpressions it kills
+  std::map<AliasInfo, AvailableSet> KilledByAliasInfo;
+
+public:
+  ExpressionIndex(Function &F) {
+    for (Instruction &I : llvm::instructions(F))
+      for (const AvailableExpression &A : getGeneratedExpressions(&I))
+        Expressions.push_back(A);
+
+    llvm::sort(Expressions);
+    Expressions.erase(std::unique(Expressions.begin(), Expressions.end()),
+                      Expressions.end());
+
+    for (unsigned Index = 0; Index < Expressions.size(); ++Index) {
+      auto MarkTouched = [this, Index](const Instruction *I) {
+        AvailableSet &Touched = ByAliasInfo[getAliasInfo(I)];
+        Touched.resize(Expressions.size());
+        Touched.set(Index);
+      };
+      MarkTouched(Expressions[Index].Expression);
+      MarkTouched(Expressions[Index].Assign);
+    }
+  }
+
+public:
+  size_t size() const { return Expressions.size(); }
+
+  const AvailableExpression &operator[](unsigned Index) const {
+    return Expressions[Index];
+  }
+
+  unsigned indexOf(const AvailableExpression &A) const {
+    auto It = llvm::lower_bound(Expressions, A);
+    revng_assert(It != Expressions.end() and *It == A);
+    return It - Expressions.begin();
+  }
+
+  // The range of indices of the AvailableExpressions of \p I
+  std::pair<unsigned, unsigned> indicesOf(const Instruction *I) const {
+    auto Begin = llvm::partition_point(Expressions,
+                                       [I](const AvailableExpression &A) {
+                                         return A.Expression < I;
+                                       });
+    auto End = std::find_if(Begin,
+                            Expressions.end(),
+                            [I](const AvailableExpression &A) {
+                              return A.Expression != I;
+                            });
+    return { Begin - Expressions.begin(), End - Expressions.begin() };
+  }
+
+  // The AvailableExpressions that are not available anymore after the
+  // statement \p I. Since this only depends on the AliasInfo of \p I, the
+  // result is shared among all the statements with the same AliasInfo.
+  const AvailableSet &getKilledBy(const Instruction *I) {
+    AliasInfo Info = getAliasInfo(I);
+    auto [It, New] = KilledByAliasInfo.try_emplace(Info, Expressions.size());
+    if (New) {
+      for (const auto &[OtherInfo, Touched] : ByAliasInfo)
+        if (not noAlias(Info, OtherInfo))
+          It->second |= Touched;
+
+      revng_log(Log, "Statements aliasing with " << dumpToString(I) << " kill");
+      dump(It->second);
+    }
+
+    return It->second;
+  }
+
+  // Log all the AvailableExpressions in \p Set
+  void dump(const AvailableSet &Set) const {
+    if (not Log.isEnabled())
+      return;
+
+    LoggerIndent Indent{ Log };
+    for (unsigned Index : Set.set_bits()) {
+      const auto &[Available, Assign] = Expressions[Index];
+      revng_log(Log, "Available: " << dumpToString(Available));
+      revng_log(Log, "Assign: " << dumpToString(Assign));
+    }
+  }
+
+  // Update \p Available with the effects of \p I
+  void applyTransferFunction(Instruction *I, AvailableSet &Available) {
+    if (isStatement(I))
+      Available.reset(getKilledBy(I));
+
+    for (const AvailableExpression &A : getGeneratedExpressions(I))
+      Available.set(indexOf(A));
+  }
+};
+
+// The overall effect of a basic block on the available expressions: the
+// AvailableSet at the end of the block is (In - Killed) + Generated.
+struct BlockEffects {
+  AvailableSet Killed;
+  AvailableSet Generated;
+};
+
+using BlockEffectsMap = std::map<const BasicBlock *, BlockEffects>;
+
+struct AvailableExpressionsAnalysis;
+using ALA = AvailableExpressionsAnalysis;
+
+struct AvailableExpressionsAnalysis {
+  using GraphType = Function *;
+  using LatticeElement = AvailableSet;
+  using Label = BasicBlock *;
+  using MFPResult = MFP::MFPResult<ALA::LatticeElement>;
+
+  const BlockEffectsMap *Effects = nullptr;
+
+  // Intersection
+  ALA::LatticeElement combineValues(const ALA::LatticeElement &LHS,
+                                    const ALA::LatticeElement &RHS) const {
+    ALA::LatticeElement Result = LHS;
+    Result &= RHS;
+    return Result;
+  }
+
+  // Is LHS a superset of RHS?
+  bool isLessOrEqual(const ALA::LatticeElement &LHS,
+                     const ALA::LatticeElement &RHS) const {
+    return not RHS.test(LHS);
+  }
+
+  ALA::LatticeElement
+  applyTransferFunction(BasicBlock *BB, const ALA::LatticeElement &E) const {
+    const BlockEffects &Effect = Effects->at(BB);
+    ALA::LatticeElement Result = E;
+    Result.reset(Effect.Killed);
+    Result |= Effect.Generated;
+    return Result;
+  }
+};
+
+using MFPResult = ALA::MFPResult;
+using ResultMap = std::map<BasicBlock *, MFPResult>;
+
+// The MFP runs on basic blocks, using the overall effects of each of them.
+// The AvailableSet at each instruction is recomputed on demand, starting from
+// the beginning of its block, and cached for the whole block.
+class AvailableExpressions::Implementation {
+private:
+  ExpressionIndex Index;
+  BlockEffectsMap Effects;
+  ResultMap BlockResults;
+
+  struct BlockStates {
+    // The AvailableSet right after each program point of the block, preceded
+    // by the one at the beginning of the block
+    std::vector<AvailableSet> States;
+
+    // The index in States of the AvailableSet right before each instruction
+    std::unordered_map<const Instruction *, unsigned> StateBefore;
+  };
+
+  std::unordered_map<const BasicBlock *, BlockStates> InstructionResults;
+
+public:
+  Implementation(Function &F) : Index(F) {
+    revng_log(Log, "Found " << Index.size() << " AvailableExpressions");
+
+    for (BasicBlock &BB : F) {
+      BlockEffects &Effect = Effects[&BB];
+      Effect.Killed.resize(Index.size());
+      Effect.Generated.resize(Index.size());
+      for (Instruction &I : BB) {
+        if (not isProgramPoint(&I))
+          continue;
+
+        if (isStatement(&I)) {
+          const AvailableSet &Killed = Index.getKilledBy(&I);
+          Effect.Killed |= Killed;
+          Effect.Generated.reset(Killed);
+        }
+
+        for (const AvailableExpression &A : getGeneratedExpressions(&I))
+          Effect.Generated.set(Index.indexOf(A));
+      }
+
+      if (Log.isEnabled()) {
+        revng_log(Log, "Effects of block " << BB.getName());
+        LoggerIndent Indent{ Log };
+        revng_log(Log, "Killed");
+        Index.dump(Effect.Killed);
+        revng_log(Log, "Generated");
+        Index.dump(Effect.Generated);
+      }
+    }
+
+    AvailableSet Bottom(Index.size(), true);
+    AvailableSet Empty(Index.size());
+    BlockResults = MFP::getMaximalFixedPoint<ALA>({ .Effects = &Effects },
+                                                  &F,
+                                                  Bottom,
+                                                  Empty,
+                                                  { &F.getEntryBlock() });
+  }
+
+public:
+  AvailableExpressionVector getAvailableAt(Instruction *I, Instruction *Where) {
+    revng_log(Log, "IsAvailableAt");
+    revng_log(Log, "I: " << dumpToString(I));
+    revng_log(Log, "Where: " << dumpToString(Where));
+
+    const AvailableSet &Available = getAvailableSetAt(Where);
+    AvailableExpressionVector Result;
+    auto [Begin, End] = Index.indicesOf(I);
+    for (unsigned Current = Begin; Current < End; ++Current)
+      if (Available.test(Current))
+        Result.push_back(Index[Current]);
+
+    return Result;
+  }
+
+  bool isAvailableAt(Instruction *I, Instruction *Where) {
+    bool Result = not getAvailableAt(I, Where).empty();
+    revng_log(Log, "Result: " << Result);
+    return Result;
+  }
+
+private:
+  // The AvailableSet right before \p Where
+  const AvailableSet &getAvailableSetAt(Instruction *Where) {
+    BasicBlock *BB = Where->getParent();
+    auto [It, New] = InstructionResults.try_emplace(BB);
+    BlockStates &Block = It->second;
+    if (New) {
+      revng_log(Log, "Computing the AvailableSets of the block");
+      AvailableSet Available = BlockResults.at(BB).InValue;
+      Block.States.push_back(Available);
+      for (Instruction &I : *BB) {
+        Block.StateBefore[&I] = Block.States.size() - 1;
+        if (isProgramPoint(&I)) {
+          Index.applyTransferFunction(&I, Available);
+          Block.States.push_back(Available);
+        }
+      }
+    }
+
+    return Block.States[Block.StateBefore.at(Where)];
+  }
+};
+
+
+AvailableExpressions::AvailableExpressions(Function &F) :
+  Impl(std::make_unique<Implementation>(F)) {
+}
+
+AvailableExpressions::~AvailableExpressions() = default;
+
+AvailableExpressionVector
+AvailableExpressions::getAvailableAt(Instruction *I, Instruction *Where) {
+  return Impl->getAvailableAt(I, Where);
+}
+
+bool AvailableExpressions::isAvailableAt(Instruction *I, Instruction *Where) {
+  return Impl->isAvailableAt(I, Where);
+}
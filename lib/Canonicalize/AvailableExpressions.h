@@ -0,0 +1,73 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <compare>
+#include <memory>
+#include <optional>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instruction.h"
+#include "llvm/IR/Instructions.h"
+
+struct AvailableExpression {
+  // The expression that is available
+  llvm::Instruction *Expression = nullptr;
+
+  // The Assign call that has assigned the Expression to some location.
+  // It can be used to retrieve the address of the location itself.
+  // nullptr means that we don't have a specific address but the Expression
+  // itself can be computed at the given program point without breaking
+  // semantics.
+  // We need to assign a semantic to nullptr for CallInst and Copy, which are
+  // note necessarily assigned to any location by an Assign call.
+  llvm::CallInst *Assign = nullptr;
+
+  bool operator==(const AvailableExpression &) const = default;
+  std::strong_ordering operator<=>(const AvailableExpression &) const = default;
+};
+
+using AvailableExpressionVector = llvm::SmallVector<AvailableExpression, 2>;
+
+/// Is \p I a statement, i.e., an instruction that must be emitted on its own,
+/// and that might kill available expressions?
+bool isStatement(const llvm::Instruction *I);
+
+/// The local variable accessed by \p I, if \p I is a Copy or an Assign.
+///
+/// \return std::nullopt if \p I does not access a local variable, nullptr if
+///         it might access many local variables, or the accessed local
+///         variable (either an Argument or a call allocating it).
+std::optional<const llvm::Value *>
+getAccessedLocalVariable(const llvm::Instruction *I);
+
+/// The AvailableExpressions that become available right after \p I
+AvailableExpressionVector getGeneratedExpressions(llvm::Instruction *I);
+
+/// The results of the available expressions analysis on a function.
+///
+/// An AvailableExpression is available at a given instruction if, on all the
+/// paths from the entry, it has been generated, and no statement that might
+/// alias with its Expression or its Assign has been executed since then.
+class AvailableExpressions {
+  class Implementation;
+  std::unique_ptr<Implementation> Impl;
+
+public:
+  AvailableExpressions(llvm::Function &F);
+  ~AvailableExpressions();
+
+  AvailableExpressions(const AvailableExpressions &) = delete;
+  AvailableExpressions &operator=(const AvailableExpressions &) = delete;
+
+public:
+  /// The AvailableExpressions of \p I that are available right before
+  /// \p Where, ordered by their Assign.
+  AvailableExpressionVector getAvailableAt(llvm::Instruction *I,
+                                           llvm::Instruction *Where);
+
+  bool isAvailableAt(llvm::Instruction *I, llvm::Instruction *Where);
+};
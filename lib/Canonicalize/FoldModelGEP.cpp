@@ -53,7 +53,7 @@ inline llvm::Value *traverseTransparentInstructions(llvm::Value *V) {
 }
 
 static llvm::Value *getValueToSubstitute(llvm::Instruction &I,
-                                         const model::Binary &Model) {
+                                         ModelTypeTable &Types) {
   if (auto *Call = getCallToTagged(&I, FunctionTags::ModelGEP)) {
     revng_log(Log, "--------Call: " << dumpToString(I));
 
@@ -66,7 +66,7 @@ static llvm::Value *getValueToSubstitute(llvm::Instruction &I,
 
     // First argument is the model type of the base pointer
     llvm::Value *GEPFirstArg = Call->getArgOperand(0);
-    auto GEPBaseType = fromLLVMString(GEPFirstArg, Model);
+    unsigned GEPBaseType = Types.getHandle(GEPFirstArg);
 
     // Second argument is the base pointer
     llvm::Value *SecondArg = Call->getArgOperand(1);
@@ -93,7 +93,7 @@ static llvm::Value *getValueToSubstitute(llvm::Instruction &I,
 
     // First argument of the AddressOf is the pointer's base type
     llvm::Value *AddrOfFirstArg = AddrOfCall->getArgOperand(0);
-    auto AddrOfBaseType = fromLLVMString(AddrOfFirstArg, Model);
+    unsigned AddrOfBaseType = Types.getHandle(AddrOfFirstArg);
 
     // Skip if the ModelGEP is dereferencing the AddressOf with a
     // different type
@@ -123,12 +123,13 @@ bool FoldModelGEP::runOnFunction(llvm::Function &F) {
   revng_log(Log, "=========Function: " << F.getName());
 
   llvm::SmallVector<llvm::Instruction *, 32> ToErase;
+  ModelTypeTable Types(*Model);
 
   // Collect ModelGEPs
   for (auto *BB : llvm::ReversePostOrderTraversal(&F)) {
     for (auto &I : llvm::make_early_inc_range(*BB)) {
 
-      if (llvm::Value *ValueToSubstitute = getValueToSubstitute(I, *Model)) {
+      if (llvm::Value *ValueToSubstitute = getValueToSubstitute(I, Types)) {
         auto *CallToFold = cast<CallInst>(&I);
         revng_assert(isCallToTagged(CallToFold, FunctionTags::ModelGEP));
         Builder.SetInsertPoint(CallToFold);
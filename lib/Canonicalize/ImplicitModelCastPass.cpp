@@ -19,7 +19,7 @@
 #include "revng/Support/FunctionTags.h"
 #include "revng/Support/YAMLTraits.h"
 
-#include "revng-c/InitModelTypes/InitModelTypes.h"
+#include "revng-c/InitModelTypes/ModelTypesAnalysis.h"
 #include "revng-c/Support/FunctionTags.h"
 #include "revng-c/Support/IRHelpers.h"
 #include "revng-c/Support/ModelHelpers.h"
@@ -28,7 +28,7 @@
 
 static Logger<> Log{ "implicit-model-cast" };
 
-using ValueTypeMap = std::map<const llvm::Value *, const model::UpcastableType>;
+using ValueTypeMap = ModelTypesWrapperPass::ModelTypesMap;
 using ModelPromotedTypesMap = std::map<const llvm::Instruction *, ValueTypeMap>;
 
 struct ImplicitModelCastPass : public llvm::FunctionPass {
@@ -42,6 +42,9 @@ public:
   void getAnalysisUsage(llvm::AnalysisUsage &AU) const override {
     AU.setPreservesCFG();
     AU.addRequired<LoadModelWrapperPass>();
+    // Marking casts as implicit does not change the types of any value
+    AU.addRequired<ModelTypesWrapperPass>();
+    AU.addPreserved<ModelTypesWrapperPass>();
   }
 
   bool process(llvm::Function &F, const model::Binary &Model);
@@ -58,7 +61,8 @@ private:
                                                  const model::Binary &Model);
 
 private:
-  ValueTypeMap TypeMap;
+  const ValueTypeMap *TypeMap = nullptr;
+  std::optional<ModelTypeTable> TypeTable;
   ModelPromotedTypesMap PromotedTypes;
 };
 
@@ -300,7 +304,7 @@ ImplicitModelCastPass::getOperandsToPromote(llvm::Instruction *I,
     auto *CastedValue = CallToModelCast->getArgOperand(1);
     // Expected Type for the casted operand is the type of the cast, since the
     // MakeModelCast already made the cast.
-    const model::Type &ExpectedType = *TypeMap.at(CallToModelCast);
+    const model::Type &ExpectedType = *TypeMap->at(CallToModelCast);
 
     // Check if shift count < width of type.
     if (isShiftLikeInstruction(I) and Op.getOperandNo() == 0
@@ -313,7 +317,7 @@ ImplicitModelCastPass::getOperandsToPromote(llvm::Instruction *I,
       continue;
 
     auto PromotedTypeForCastedValue = PromotedTypesForInstruction[CastedValue];
-    const model::Type &CastedValueType = *TypeMap.at(CastedValue);
+    const model::Type &CastedValueType = *TypeMap->at(CastedValue);
     // If type of the value being casted or integer promoted type are implicit
     // casts, we can avoid the cast itself.
     bool IsImplicit = isImplicitCast(*PromotedTypeForCastedValue,
@@ -393,14 +397,14 @@ bool IMCP::collectTypeInfoForTypePromotion(llvm::Instruction *I,
       // already "casted" by the MakeModelCast Pass.
       llvm::CallInst *CallToModelCast = cast<llvm::CallInst>(Op.get());
       llvm::Value *CastedValue = CallToModelCast->getArgOperand(1);
-      OperandType = TypeMap.at(CastedValue).get();
+      OperandType = TypeMap->at(CastedValue).get();
       ValueToPromoteTypeFor = CastedValue;
-      ExpectedType = TypeMap.at(Op.get());
+      ExpectedType = TypeMap->at(Op.get());
     } else {
       // If it is not a ModelCast, promote the type for the llvm::Value itself.
-      OperandType = TypeMap.at(Op.get()).get();
+      OperandType = TypeMap->at(Op.get()).get();
       ValueToPromoteTypeFor = Op.get();
-      auto ModelTypes = getExpectedModelType(&Op, Model);
+      auto ModelTypes = getExpectedModelType(&Op, *TypeTable);
       if (ModelTypes.size() != 1)
         return;
       ExpectedType = std::move(ModelTypes.back());
@@ -515,10 +519,12 @@ bool ImplicitModelCastPass::runOnFunction(llvm::Function &F) {
   auto &ModelWrapper = getAnalysis<LoadModelWrapperPass>().get();
   const TupleTree<model::Binary> &Model = ModelWrapper.getReadOnlyModel();
 
-  auto ModelFunction = llvmToModelFunction(*Model, F);
+  auto &ModelTypes = getAnalysis<ModelTypesWrapperPass>();
+  auto ModelFunction = ModelTypes.getModelFunction();
   revng_assert(ModelFunction != nullptr);
 
-  TypeMap = initModelTypes(F, ModelFunction, *Model, false);
+  TypeMap = &ModelTypes.getTypes();
+  TypeTable.emplace(*Model);
 
   Changed = process(F, *Model);
 
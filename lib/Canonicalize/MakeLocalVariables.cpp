@@ -15,7 +15,7 @@
 #include "revng/Model/LoadModelPass.h"
 #include "revng/Support/OpaqueFunctionsPool.h"
 
-#include "revng-c/InitModelTypes/InitModelTypes.h"
+#include "revng-c/InitModelTypes/ModelTypesAnalysis.h"
 #include "revng-c/Support/FunctionTags.h"
 #include "revng-c/Support/ModelHelpers.h"
 
@@ -33,6 +33,8 @@ public:
 
   void getAnalysisUsage(llvm::AnalysisUsage &AU) const override {
     AU.addRequired<LoadModelWrapperPass>();
+    AU.addRequired<ModelTypesWrapperPass>();
+    AU.addPreserved<ModelTypesWrapperPass>();
     AU.setPreservesCFG();
   }
 };
@@ -68,18 +70,12 @@ bool MakeLocalVariables::runOnFunction(llvm::Function &F) {
   OpaqueFunctionsPool<llvm::Type *> LocalVarPool(&M, false);
   initLocalVarPool(LocalVarPool);
 
-  // Try to initialize a map for the known model types of llvm::Values
-  // that are reachable from F. If this fails, we just bail out because we
-  // cannot infer any modelGEP in F, if we have no type information to rely
-  // on.
-  const model::Function *ModelF = llvmToModelFunction(*Model, F);
-  revng_assert(ModelF);
-  using ModelTypesMap = std::map<const llvm::Value *,
-                                 const model::UpcastableType>;
-  ModelTypesMap KnownTypes = initModelTypes(F,
-                                            ModelF,
-                                            *Model,
-                                            /* PointersOnly = */ false);
+  // Get the known model types of the llvm::Values that are reachable from F.
+  // The map is updated only after all the allocas have been replaced, so that
+  // the types of the stored values are not affected by the replacement order.
+  auto &ModelTypes = getAnalysis<ModelTypesWrapperPass>();
+  const auto &KnownTypes = ModelTypes.getTypes();
+  llvm::SmallVector<llvm::Instruction *, 8> NewLocalVariables;
 
   for (auto *Alloca : ToReplace) {
     Builder.SetInsertPoint(Alloca);
@@ -146,9 +142,16 @@ bool MakeLocalVariables::runOnFunction(llvm::Function &F) {
     revng_assert(ResultType == ValueToSubstitute->getType());
 
     Alloca->replaceAllUsesWith(ValueToSubstitute);
+    ModelTypes.forget(Alloca);
     Alloca->eraseFromParent();
+    NewLocalVariables.push_back(LocalVarCall);
   }
 
+  // Propagate the types of the new local variables to the AddressOf calls and
+  // to all their users.
+  for (llvm::Instruction *LocalVarCall : NewLocalVariables)
+    ModelTypes.update(*LocalVarCall);
+
   return true;
 }
 
@@ -19,15 +19,14 @@
 #include "revng/Support/FunctionTags.h"
 #include "revng/Support/YAMLTraits.h"
 
-#include "revng-c/InitModelTypes/InitModelTypes.h"
+#include "revng-c/InitModelTypes/ModelTypesAnalysis.h"
 #include "revng-c/Support/FunctionTags.h"
 #include "revng-c/Support/IRHelpers.h"
 #include "revng-c/Support/ModelHelpers.h"
 #include "revng-c/TypeNames/LLVMTypeNames.h"
 
 using namespace llvm;
-using ModelTypesMap = std::map<const llvm::Value *,
-                               const model::UpcastableType>;
+using ModelTypesMap = ModelTypesWrapperPass::ModelTypesMap;
 
 struct SerializedType {
   Constant *StringType = nullptr;
@@ -39,7 +38,8 @@ struct SerializedType {
 
 struct MakeModelCastPass : public llvm::FunctionPass {
 private:
-  ModelTypesMap TypeMap;
+  const ModelTypesMap *TypeMap = nullptr;
+  std::optional<ModelTypeTable> TypeTable;
   const model::Function *ModelFunction = nullptr;
 
 public:
@@ -52,14 +52,16 @@ public:
   void getAnalysisUsage(llvm::AnalysisUsage &AU) const override {
     AU.setPreservesCFG();
     AU.addRequired<LoadModelWrapperPass>();
+    AU.addRequired<ModelTypesWrapperPass>();
+    AU.addPreserved<ModelTypesWrapperPass>();
   }
 
 private:
   std::vector<SerializedType> serializeTypesForModelCast(Instruction *,
                                                          const model::Binary &);
-  void createAndInjectModelCast(Instruction *,
-                                const SerializedType &,
-                                OpaqueFunctionsPool<TypePair> &);
+  Value *createAndInjectModelCast(Instruction *,
+                                  const SerializedType &,
+                                  OpaqueFunctionsPool<TypePair> &);
 };
 
 using MMCP = MakeModelCastPass;
@@ -72,9 +74,9 @@ MMCP::serializeTypesForModelCast(Instruction *I, const model::Binary &Model) {
   std::vector<SerializedType> Result;
   Module *M = I->getModule();
 
-  auto SerializeTypeFor = [this, &Model, &Result, &M](const llvm::Use &Op) {
+  auto SerializeTypeFor = [this, &Result, &M](const llvm::Use &Op) {
     // Check if we have strong model information about this operand
-    auto ModelTypes = getExpectedModelType(&Op, Model);
+    auto ModelTypes = getExpectedModelType(&Op, *TypeTable);
 
     // Aggregates that do not correspond to model structs (e.g. return types
     // of RawFunctionTypes that return more than one value) cannot be handled
@@ -83,7 +85,7 @@ MMCP::serializeTypesForModelCast(Instruction *I, const model::Binary &Model) {
       const model::UpcastableType &ExpectedType = ModelTypes.back();
       revng_assert(ExpectedType->verify());
 
-      const model::Type &OperandType = *TypeMap.at(Op.get());
+      const model::Type &OperandType = *TypeMap->at(Op.get());
       if (*ExpectedType->skipTypedefs() != *OperandType.skipTypedefs()) {
         revng_assert(ExpectedType->isScalar() and OperandType.isScalar());
         // Create a cast only if the expected type is different from the
@@ -170,9 +172,9 @@ static Value *createCallToModelCast(IRBuilder<> &Builder,
   return Call;
 }
 
-void MMCP::createAndInjectModelCast(Instruction *Ins,
-                                    const SerializedType &ST,
-                                    OpaqueFunctionsPool<TypePair> &Pool) {
+Value *MMCP::createAndInjectModelCast(Instruction *Ins,
+                                      const SerializedType &ST,
+                                      OpaqueFunctionsPool<TypePair> &Pool) {
   IRBuilder<> Builder(Ins);
 
   uint64_t OperandId = ST.OperandId;
@@ -185,6 +187,7 @@ void MMCP::createAndInjectModelCast(Instruction *Ins,
                                                  Operand,
                                                  Pool);
   Ins->setOperand(OperandId, CallToModelCast);
+  return CallToModelCast;
 }
 
 bool MMCP::runOnFunction(Function &F) {
@@ -197,8 +200,13 @@ bool MMCP::runOnFunction(Function &F) {
   auto &ModelWrapper = getAnalysis<LoadModelWrapperPass>().get();
   const TupleTree<model::Binary> &Model = ModelWrapper.getReadOnlyModel();
 
-  ModelFunction = llvmToModelFunction(*Model, F);
+  // The cached types are updated only after each batch of casts has been
+  // injected, so that each batch is computed on the types of the original IR.
+  auto &ModelTypes = getAnalysis<ModelTypesWrapperPass>();
+
+  ModelFunction = ModelTypes.getModelFunction();
   revng_assert(ModelFunction != nullptr);
+  llvm::SmallVector<Value *, 16> NewCasts;
 
   // First of all, remove all SExt, ZExt and Trunc, and replace them with
   // ModelCasts.
@@ -247,12 +255,19 @@ bool MMCP::runOnFunction(Function &F) {
                                                        CastedOperand,
                                                        ModelCastPool);
         I.replaceAllUsesWith(CallToModelCast);
+        ModelTypes.forget(&I);
         I.eraseFromParent();
+        NewCasts.push_back(CallToModelCast);
       }
     }
   }
 
-  TypeMap = initModelTypes(F, ModelFunction, *Model, false);
+  for (Value *Cast : NewCasts)
+    ModelTypes.update(*cast<Instruction>(Cast));
+  NewCasts.clear();
+
+  TypeMap = &ModelTypes.getTypes();
+  TypeTable.emplace(*Model);
 
   for (BasicBlock &BB : F) {
     for (Instruction &I : BB) {
@@ -264,10 +279,15 @@ bool MMCP::runOnFunction(Function &F) {
       Changed = true;
 
       for (unsigned Idx = 0; Idx < SerializedTypes.size(); ++Idx)
-        createAndInjectModelCast(&I, SerializedTypes[Idx], ModelCastPool);
+        NewCasts.push_back(createAndInjectModelCast(&I,
+                                                    SerializedTypes[Idx],
+                                                    ModelCastPool));
     }
   }
 
+  for (Value *Cast : NewCasts)
+    ModelTypes.update(*cast<Instruction>(Cast));
+
   return Changed;
 }
 
@@ -46,7 +46,7 @@
 #include "revng/Support/IRHelpers.h"
 #include "revng/Support/YAMLTraits.h"
 
-#include "revng-c/InitModelTypes/InitModelTypes.h"
+#include "revng-c/InitModelTypes/ModelTypesAnalysis.h"
 #include "revng-c/Support/FunctionTags.h"
 #include "revng-c/Support/IRHelpers.h"
 #include "revng-c/Support/ModelHelpers.h"
@@ -1852,26 +1852,23 @@ struct UseReplacementWithModelGEP {
 static std::vector<UseReplacementWithModelGEP>
 makeGEPReplacements(llvm::Function &F,
                     const model::Binary &Model,
+                    const ModelTypesMap &KnownPointerTypes,
                     model::VerifyHelper &VH) {
 
   std::vector<UseReplacementWithModelGEP> Result;
 
-  const model::Function *ModelF = llvmToModelFunction(Model, F);
-  revng_assert(ModelF);
-
-  // First, try to initialize a map for the known model types of llvm::Values
-  // that are reachable from F. If this fails, we just bail out because we
-  // cannot infer any modelGEP in F, if we have no type information to rely
-  // on.
-  ModelTypesMap PointerTypes = initModelTypes(F,
-                                              ModelF,
-                                              Model,
-                                              /* PointersOnly = */ true);
-  if (PointerTypes.empty()) {
+  // First, get the known model types of the pointer llvm::Values that are
+  // reachable from F. If there are none, we just bail out because we cannot
+  // infer any modelGEP in F, if we have no type information to rely on.
+  // The map is copied, since we enrich it with the types of the loads we
+  // GEPify along the way.
+  if (KnownPointerTypes.empty()) {
     revng_log(ModelGEPLog, "Model Types not found for " << F.getName());
     return Result;
   }
 
+  ModelTypesMap PointerTypes = KnownPointerTypes;
+
   UseTypeMap GEPifiedUsedTypes;
 
   auto RPOT = ReversePostOrderTraversal(&F.getEntryBlock());
@@ -2076,6 +2073,7 @@ public:
   void getAnalysisUsage(AnalysisUsage &AU) const override {
     AU.setPreservesCFG();
     AU.addRequired<LoadModelWrapperPass>();
+    AU.addRequired<ModelTypesWrapperPass>();
   }
 };
 
@@ -2088,7 +2086,11 @@ bool MakeModelGEPPass::runOnFunction(llvm::Function &F) {
   auto &Model = getAnalysis<LoadModelWrapperPass>().get().getReadOnlyModel();
 
   model::VerifyHelper VH;
-  auto GEPReplacements = makeGEPReplacements(F, *Model, VH);
+  auto &ModelTypes = getAnalysis<ModelTypesWrapperPass>();
+  auto GEPReplacements = makeGEPReplacements(F,
+                                             *Model,
+                                             ModelTypes.getPointerTypes(),
+                                             VH);
 
   llvm::Module &M = *F.getParent();
   LLVMContext &Context = M.getContext();
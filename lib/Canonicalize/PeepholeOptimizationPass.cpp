@@ -31,6 +31,7 @@ public:
 
   void getAnalysisUsage(AnalysisUsage &AU) const override {
     AU.setPreservesCFG();
+    AU.addRequired<DominatorTreeWrapperPass>();
   }
 
   bool runOnFunction(Function &F) override;
@@ -209,8 +210,7 @@ bool PeepholeOptimizationPass::runOnFunction(Function &F) {
   revng_log(Log, "Peephole For Decompilation: " << F.getName());
   LoggerIndent Indent{ Log };
   bool Changed = false;
-  DominatorTree DT;
-  DT.recalculate(F);
+  auto &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
   for (BasicBlock &B : F) {
     for (PHINode &PHI : B.phis()) {
       Changed |= reusePHIIncomings(PHI, DT);
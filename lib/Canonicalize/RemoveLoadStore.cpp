@@ -14,7 +14,7 @@
 #include "revng/Support/Assert.h"
 #include "revng/Support/OpaqueFunctionsPool.h"
 
-#include "revng-c/InitModelTypes/InitModelTypes.h"
+#include "revng-c/InitModelTypes/ModelTypesAnalysis.h"
 #include "revng-c/Support/DecompilationHelpers.h"
 #include "revng-c/Support/FunctionTags.h"
 #include "revng-c/Support/ModelHelpers.h"
@@ -31,6 +31,7 @@ public:
 
   void getAnalysisUsage(llvm::AnalysisUsage &AU) const override {
     AU.addRequired<LoadModelWrapperPass>();
+    AU.addRequired<ModelTypesWrapperPass>();
     AU.setPreservesCFG();
   }
 };
@@ -70,11 +71,15 @@ bool RemoveLoadStore::runOnFunction(llvm::Function &F) {
   const auto
     &Model = getAnalysis<LoadModelWrapperPass>().get().getReadOnlyModel().get();
 
-  // Collect model types
-  auto TypeMap = initModelTypes(F,
-                                llvmToModelFunction(*Model, F),
-                                *Model,
-                                /* PointersOnly = */ false);
+  // Collect model types. This pass does not preserve them, so the types of the
+  // injected calls are tracked on the side.
+  const auto &KnownTypes = getAnalysis<ModelTypesWrapperPass>().getTypes();
+  ModelTypesWrapperPass::ModelTypesMap InjectedTypes;
+  auto GetType = [&](const llvm::Value *V) -> const model::UpcastableType & {
+    if (auto It = InjectedTypes.find(V); It != InjectedTypes.end())
+      return It->second;
+    return KnownTypes.at(V);
+  };
 
   // Initialize the IR builder to inject functions
   llvm::LLVMContext &LLVMCtx = F.getContext();
@@ -109,7 +114,7 @@ bool RemoveLoadStore::runOnFunction(llvm::Function &F) {
 
       if (auto *Load = dyn_cast<llvm::LoadInst>(&I)) {
         llvm::Value *PtrOp = Load->getPointerOperand();
-        const model::UpcastableType &PointedT = TypeMap.at(Load);
+        const model::UpcastableType &PointedT = GetType(Load);
 
         // Check that the Model type is compatible with the Load size
         revng_assert(areMemOpCompatible(*PointedT, *Load->getType(), *Model));
@@ -129,7 +134,8 @@ bool RemoveLoadStore::runOnFunction(llvm::Function &F) {
         InjectedCall = Builder.CreateCall(CopyFunction, { DerefCall });
 
         // Add the dereferenced type to the type map
-        auto [_, Inserted] = TypeMap.insert({ InjectedCall, PointedT.copy() });
+        auto [_, Inserted] = InjectedTypes.insert({ InjectedCall,
+                                                    PointedT.copy() });
         revng_assert(Inserted);
 
       } else if (auto *Store = dyn_cast<llvm::StoreInst>(&I)) {
@@ -137,8 +143,8 @@ bool RemoveLoadStore::runOnFunction(llvm::Function &F) {
         llvm::Value *PointerOp = Store->getPointerOperand();
         llvm::Type *PointedType = ValueOp->getType();
 
-        const model::Type &PointerOpType = *TypeMap.at(PointerOp);
-        model::UpcastableType StoredType = TypeMap.at(ValueOp);
+        const model::Type &PointerOpType = *GetType(PointerOp);
+        model::UpcastableType StoredType = GetType(ValueOp);
 
         // Use the model information coming from pointer operand only if the
         // size is the same as the store's original size.
@@ -169,7 +175,7 @@ bool RemoveLoadStore::runOnFunction(llvm::Function &F) {
                                          ValueOp->getType());
 
         // Add the dereferenced type to the type map
-        TypeMap.insert({ DerefCall, StoredType });
+        InjectedTypes.insert({ DerefCall, StoredType });
 
         // Inject Assign() function
         auto *AssignFnType = getAssignFunctionType(ValueOp->getType(),
@@ -24,21 +24,19 @@
 #include "llvm/Pass.h"
 
 #include "revng/ABI/FunctionType/Layout.h"
-#include "revng/ADT/GenericGraph.h"
-#include "revng/ADT/SmallMap.h"
-#include "revng/MFP/MFP.h"
-#include "revng/MFP/SetLattices.h"
 #include "revng/Model/Binary.h"
 #include "revng/Model/IRHelpers.h"
 #include "revng/Model/LoadModelPass.h"
 #include "revng/Support/Debug.h"
 #include "revng/Support/FunctionTags.h"
 
-#include "revng-c/InitModelTypes/InitModelTypes.h"
+#include "revng-c/InitModelTypes/ModelTypesAnalysis.h"
 #include "revng-c/Support/DecompilationHelpers.h"
 #include "revng-c/Support/FunctionTags.h"
 #include "revng-c/Support/ModelHelpers.h"
 
+#include "AvailableExpressions.h"
+
 static Logger<> Log{ "switch-to-statements" };
 
 using namespace llvm;
@@ -52,502 +50,12 @@ public:
   void getAnalysisUsage(AnalysisUsage &AU) const override {
     AU.setPreservesCFG();
     AU.addRequired<LoadModelWrapperPass>();
+    AU.addRequired<ModelTypesWrapperPass>();
   }
 
   bool runOnFunction(Function &F) override;
 };
 
-struct AvailableExpression {
-  // The expression that is available
-  Instruction *Expression = nullptr;
-
-  // The Assign call that has assigned the Expression to some location.
-  // It can be used to retrieve the address of the location itself.
-  // nullptr means that we don't have a specific address but the Expression
-  // itself can be computed at the given program point without breaking
-  // semantics.
-  // We need to assign a semantic to nullptr for CallInst and Copy, which are
-  // note necessarily assigned to any location by an Assign call.
-  CallInst *Assign = nullptr;
-
-  bool operator==(const AvailableExpression &) const = default;
-  std::strong_ordering operator<=>(const AvailableExpression &) const = default;
-};
-
-using AvailableSet = std::set<AvailableExpression>;
-
-constexpr size_t SmallSize = 8;
-using InstructionVector = SmallVector<Instruction *, SmallSize>;
-using InstructionSetVector = SmallSetVector<Instruction *, SmallSize>;
-
-struct ProgramPointData {
-  Instruction *TheInstruction = nullptr;
-  ProgramPointData(Instruction *I) : TheInstruction(I){};
-};
-
-static auto findAvailableRange(const AvailableSet &Availables, Instruction *I) {
-  auto Begin = Availables.lower_bound(AvailableExpression{ .Expression = I,
-                                                           .Assign = nullptr });
-  auto End = Availables.upper_bound(AvailableExpression{
-    .Expression = std::next(I), .Assign = nullptr });
-  return llvm::make_range(Begin, End);
-}
-
-using ProgramPointNode = BidirectionalNode<ProgramPointData>;
-using ProgramPointsCFG = GenericGraph<ProgramPointNode>;
-
-struct AvailableExpressionsAnalysis;
-using ALA = AvailableExpressionsAnalysis;
-
-struct AvailableExpressionsAnalysis {
-  using GraphType = ProgramPointsCFG *;
-  using LatticeElement = AvailableSet;
-  using Label = ProgramPointNode *;
-  using MFPResult = MFP::MFPResult<ALA::LatticeElement>;
-
-  ALA::LatticeElement combineValues(const ALA::LatticeElement &LHS,
-                                    const ALA::LatticeElement &RHS) const {
-    return SetIntersectionLattice<LatticeElement>::combineValues(LHS, RHS);
-  }
-
-  bool isLessOrEqual(const ALA::LatticeElement &LHS,
-                     const ALA::LatticeElement &RHS) const {
-    return SetIntersectionLattice<LatticeElement>::isLessOrEqual(LHS, RHS);
-  }
-
-  ALA::LatticeElement applyTransferFunction(ProgramPointNode *L,
-                                            const ALA::LatticeElement &E) const;
-};
-
-using LatticeElement = ALA::LatticeElement;
-using MFPResult = ALA::MFPResult;
-using ResultMap = std::map<ProgramPointNode *, MFPResult>;
-
-static bool isStatement(const Instruction *I) {
-  // TODO: this is workaround for SelectInst being often involved in nasty
-  // huge dataflows.
-  // In the future we should drop this from here and add a separate pass after
-  // this, that takes care of forcing local variables for nasty dataflows.
-  if (isa<SelectInst>(I))
-    return true;
-
-  return hasSideEffects(*I);
-}
-
-static bool isProgramPoint(const Instruction *I) {
-
-  // TODO: In the future this pass will have to be updated to handle
-  // Load/Store/Alloca instead of Copy/Assign/LocalVariable, in order to be
-  // able to use LLVM's alias analysis.
-  // For now we just assume that we don't have Load/Store/Alloca at all.
-  // Whenever we'll do the switchover, we'll have to replace all the logic
-  // of Copy/Assign/LocalVariable with Load/Store/Alloca, and just drop
-  // everything related to Copy/Assign/LocalVariable.
-  // PHINodes will have to be dealt with if/when we move this pass before
-  // ExitSSA.
-  revng_assert(not isa<LoadInst>(I) and not isa<StoreInst>(I)
-               and not isa<AllocaInst>(I) and not isa<PHINode>(I));
-
-  return I == &I->getParent()->front() or isStatement(I) or mayReadMemory(*I);
-}
-
-static RecursiveCoroutine<std::optional<const Value *>>
-getAccessedLocalVariableFromModelGEP(const CallInst *ModelGEPRefCall) {
-  revng_assert(isCallToTagged(ModelGEPRefCall, FunctionTags::ModelGEPRef));
-
-  revng_assert(ModelGEPRefCall->arg_size() >= 2);
-
-  // If the ModelGEPRefCall has more than 2 arguments, and some of them are not
-  // constants, we cannot figure out all the list of potentially accessed local
-  // variables, so we just return nullptr.
-  for (const Use &GEPArg : llvm::drop_begin(ModelGEPRefCall->args(), 2)) {
-    if (not isa<Constant>(GEPArg.get()))
-      rc_return nullptr;
-  }
-
-  // If the Base argument of the ModelGEPRefCall isn't a LocalVariable, nor an
-  // Argument, nor another ModelGEPRef, we just return nullopt, meaning that
-  // this thing doesn't really access any local variable.
-  auto *GEPBase = ModelGEPRefCall->getArgOperand(1);
-  // If the GEPBase is directly an argument, we're done
-  if (isa<Argument>(GEPBase))
-    rc_return GEPBase;
-
-  // If the GEPBase is directly a LocalVariable, we're done
-  if (isCallToTagged(GEPBase, FunctionTags::AllocatesLocalVariable))
-    rc_return GEPBase;
-
-  // If the GEPBase is another ModelGEPRef we recur.
-  // Notice that we don't recur on ModelGEP, only on ModelGEPRef, because simple
-  // ModelGEP can have arbitrary base pointers, but they never access
-  // LocalVariables.
-  if (auto *NestedModelGEPRef = getCallToTagged(GEPBase,
-                                                FunctionTags::ModelGEPRef))
-    rc_return rc_recur getAccessedLocalVariableFromModelGEP(NestedModelGEPRef);
-
-  // Everything else cannot access local variables, so we return nullopt.
-  rc_return std::nullopt;
-}
-
-static std::optional<const Value *>
-getAccessedLocalVariable(const Instruction *I) {
-
-  // If it's not a Copy not an Assign then it's not an access to a local
-  // variable.
-  const CallInst *CallToCopy = getCallToTagged(I, FunctionTags::Copy);
-  const CallInst *CallToAssign = getCallToTagged(I, FunctionTags::Assign);
-  if (not CallToCopy and not CallToAssign)
-    return std::nullopt;
-
-  const CallInst *AccessCall = CallToCopy ? CallToCopy : CallToAssign;
-
-  unsigned AccessArgumentNumber = CallToAssign ? 1 : 0;
-  const auto *Accessed = AccessCall->getArgOperand(AccessArgumentNumber);
-
-  // If the accessed thing is directly an Argument or a LocalVariable we're
-  // done.
-  if (isa<Argument>(Accessed)
-      or isCallToTagged(Accessed, FunctionTags::AllocatesLocalVariable)) {
-    return Accessed;
-  }
-
-  // If the accessed thing is not a ModelGEPRef, then it's not an access to a
-  // local variable.
-  auto *ModelGEPRef = getCallToTagged(Accessed, FunctionTags::ModelGEPRef);
-  if (not ModelGEPRef)
-    return std::nullopt;
-
-  return getAccessedLocalVariableFromModelGEP(ModelGEPRef);
-}
-
-static bool localVariablesNoAlias(const Instruction *I, const Instruction *J) {
-
-  // Copies from local variables never alias anyone else, except other
-  // instructions that copy or assign the same local variable
-  std::optional<const Value *> MayBeAccessedByI = getAccessedLocalVariable(I);
-  std::optional<const Value *> MayBeAccessedByJ = getAccessedLocalVariable(J);
-
-  // If either doesn't access a local variable, they are noAlias.
-  if (not MayBeAccessedByI.has_value() or not MayBeAccessedByJ.has_value())
-    return true;
-
-  const Value *AccessedByI = *MayBeAccessedByI;
-  const Value *AccessedByJ = *MayBeAccessedByJ;
-
-  // If either is nullptr, there is at least one among I and J that access many
-  // variables, and we just can't say with certainty that they are noAlias
-  if (nullptr == AccessedByI or nullptr == AccessedByJ)
-    return false;
-
-  // For all the other cases they are noAlias only if the accessed
-  // local variable is different.
-  return AccessedByI != AccessedByJ;
-}
-
-static bool doesNotAccessMemory(const Instruction *I) {
-  auto *Call = dyn_cast_or_null<CallInst>(I);
-  return Call and Call->getMemoryEffects().doesNotAccessMemory();
-}
-
-static bool noAlias(const Instruction *I, const Instruction *J) {
-  revng_log(Log, "noAlias?");
-  LoggerIndent X{ Log };
-  revng_log(Log, "I: " << dumpToString(I));
-  revng_log(Log, "J: " << dumpToString(J));
-  LoggerIndent XX{ Log };
-  // If either instruction doesn't access memory, they are noAlias for sure.
-  if (doesNotAccessMemory(I) or doesNotAccessMemory(J)) {
-    revng_log(Log, "I or J doesNotAccessMemory");
-    return true;
-  }
-
-  // Here both instructions access memory.
-
-  // First, handle LocalVariables specifically.
-  // TODO: this is a poor's man alias analysis, which only explicitly handles
-  // stuff that is frequent and that we care about. In the future we have plans
-  // to replace it with a full fledged AliasAnalysis from LLVM
-  if (localVariablesNoAlias(I, J)) {
-    revng_log(Log, "I and J both access local variables that do not alias");
-    return true;
-  }
-
-  // TODO: In all the other cases, to reason accurately about aliasing, we would
-  // need LLVM's alias analysis. At the moment this is out of scope, so we
-  // always fall back to false, meaning that we can't say for sure that I and J
-  // do not alias.
-  revng_log(Log, "I and J aren't provably noAlias");
-  return false;
-}
-
-static void applyTransferFunction(Instruction *I, LatticeElement &E) {
-
-  revng_log(Log, "applyTransferFunction on Instruction: " << dumpToString(I));
-  LoggerIndent X{ Log };
-
-  if (isStatement(I)) {
-    revng_log(Log, "isStatement");
-    LoggerIndent XX{ Log };
-    for (const AvailableExpression &A : llvm::make_early_inc_range(E)) {
-      const auto &[Available, Assign] = A;
-      revng_log(Log, "Available: " << dumpToString(Available));
-      revng_log(Log, "Assign: " << dumpToString(Assign));
-      LoggerIndent XXX{ Log };
-      if (not noAlias(I, Available)) {
-        revng_log(Log, "Available: " << dumpToString(Available));
-        revng_log(Log, "is not noAlias (MayAlias) with I");
-        revng_log(Log, "erase Available");
-        E.erase(A);
-      } else if (not noAlias(I, Assign)) {
-        revng_log(Log, "Assign: " << dumpToString(Assign));
-        revng_log(Log, "erase Available");
-        E.erase(A);
-      } else {
-        revng_log(Log, "is noAlias with I");
-      }
-    }
-  }
-
-  if (auto *Assign = getCallToTagged(I, FunctionTags::Assign)) {
-    if (isa<Instruction>(Assign->getArgOperand(0))) {
-      revng_log(Log, "I is Assign");
-      revng_log(Log,
-                "insert Available: " << dumpToString(Assign->getArgOperand(0)));
-      revng_log(Log, "       Assign: " << dumpToString(Assign));
-      E.insert(AvailableExpression{
-        .Expression = cast<Instruction>(Assign->getArgOperand(0)),
-        .Assign = Assign,
-      });
-    }
-  }
-
-  if (mayReadMemory(*I)) {
-    revng_log(Log, "mayReadMemory -> insert Available: I");
-    E.insert(AvailableExpression{
-      .Expression = I,
-      .Assign = nullptr,
-    });
-  }
-}
-
-LatticeElement ALA::applyTransferFunction(ProgramPointNode *ProgramPoint,
-                                          const LatticeElement &E) const {
-
-  Instruction *I = ProgramPoint->TheInstruction;
-
-  revng_log(Log, "applyTransferFunction on ProgramPoint: " << dumpToString(I));
-  LoggerIndent Indent{ Log };
-
-  LatticeElement Result = E;
-
-  revng_log(Log, "initial set");
-  if (Log.isEnabled()) {
-    LoggerIndent X{ Log };
-    for (const auto &[Available, Assign] : Result) {
-      revng_log(Log, "Available: " << dumpToString(Available));
-      revng_log(Log, "Assign: " << dumpToString(Assign));
-    }
-  }
-
-  ::applyTransferFunction(I, Result);
-
-  revng_log(Log, "final set");
-  if (Log.isEnabled()) {
-    LoggerIndent X{ Log };
-    for (const auto &[Available, Assign] : Result) {
-      revng_log(Log, "Available: " << dumpToString(Available));
-      revng_log(Log, "Assign: " << dumpToString(Assign));
-    }
-  }
-
-  return Result;
-}
-
-static InstructionSetVector getProgramPoints(BasicBlock &B) {
-  InstructionSetVector Results;
-  for (Instruction &I : B)
-    if (isProgramPoint(&I))
-      Results.insert(&I);
-  return Results;
-}
-
-using InstructionProgramPoint = std::unordered_map<const Instruction *,
-                                                   ProgramPointNode *>;
-
-// An extended version of ProgramPointsCFG, that holds a graph of statements
-// points, along with a map from each Instruction to its previous statement.
-struct ProgramPointsGraphWithInstructionMap {
-  ProgramPointsCFG ProgramPointsGraph;
-  InstructionProgramPoint ProgramPoint;
-  InstructionProgramPoint PreviousProgramPointInBlock;
-  InstructionProgramPoint NextProgramPointInBlock;
-
-  auto getAvailableAt(Instruction *I,
-                      const Instruction *Where,
-                      const ResultMap &MFPResultMap) const {
-
-    revng_log(Log, "IsAvailableAt");
-    revng_log(Log, "I: " << dumpToString(I));
-    revng_log(Log, "Where: " << dumpToString(Where));
-
-    auto ProgramPointIt = ProgramPoint.find(Where);
-    if (ProgramPointIt != ProgramPoint.end()) {
-      revng_log(Log, "is ProgramPoint");
-
-      ProgramPointNode *UserProgramPoint = ProgramPointIt->second;
-      const AvailableSet &Available = MFPResultMap.at(UserProgramPoint).InValue;
-      return findAvailableRange(Available, I);
-    }
-
-    auto PreviousPointIt = PreviousProgramPointInBlock.find(Where);
-    if (PreviousPointIt != PreviousProgramPointInBlock.end()) {
-      revng_log(Log, "is NOT ProgramPoint");
-
-      ProgramPointNode *UserProgramPoint = PreviousPointIt->second;
-      revng_log(Log,
-                "Previous ProgramPoint: "
-                  << dumpToString(UserProgramPoint->TheInstruction));
-      const AvailableSet &Available = MFPResultMap.at(UserProgramPoint)
-                                        .OutValue;
-      return findAvailableRange(Available, I);
-    }
-
-    auto NextProgramPointIt = NextProgramPointInBlock.find(Where);
-    if (NextProgramPointIt != NextProgramPointInBlock.end()) {
-      revng_log(Log, "is before first ProgramPoint in BasicBlock");
-
-      ProgramPointNode *UserProgramPoint = NextProgramPointIt->second;
-      revng_log(Log,
-                "first ProgramPoint in BasicBlock: "
-                  << dumpToString(UserProgramPoint->TheInstruction));
-      const AvailableSet &Available = MFPResultMap.at(UserProgramPoint).InValue;
-      return findAvailableRange(Available, I);
-    }
-
-    revng_abort();
-  }
-
-  bool isAvailableAt(Instruction *I,
-                     const Instruction *Where,
-                     const ResultMap &MFPResultMap) const {
-    bool Result = not getAvailableAt(I, Where, MFPResultMap).empty();
-    revng_log(Log, "Result: " << Result);
-    return Result;
-  }
-};
-
-using PPGWithInstructionMap = ProgramPointsGraphWithInstructionMap;
-
-static PPGWithInstructionMap
-makeProgramPointsWithInstructionsGraph(Function &F) {
-
-  SmallMap<BasicBlock *, std::pair<ProgramPointNode *, ProgramPointNode *>, 8>
-    BlockToBeginEndNode;
-
-  PPGWithInstructionMap Result;
-
-  ProgramPointsCFG &TheCFG = Result.ProgramPointsGraph;
-  InstructionProgramPoint &ProgramPoint = Result.ProgramPoint;
-  InstructionProgramPoint
-    &PreviousProgramPointInBlock = Result.PreviousProgramPointInBlock;
-  InstructionProgramPoint &NextProgramPointInBlock = Result
-                                                       .NextProgramPointInBlock;
-
-  const auto MakeCFGNode = [&TheCFG, &ProgramPoint](Instruction *I) {
-    ProgramPointNode *NewNode = TheCFG.addNode(I);
-    ProgramPoint[I] = NewNode;
-    return NewNode;
-  };
-
-  for (BasicBlock &BB : F) {
-    InstructionSetVector ProgramPoints = getProgramPoints(BB);
-
-    // Reserve space for the new ProgramPoints. This is for performance but also
-    // for stability of pointers while adding new nodes, which allows to also
-    // save pointers to begin and end nodes of each block in a map, to handle
-    // addition of inter-block edges.
-    // If we don't reserve the pointers returned by addNode aren't stable and
-    // the trick for adding inter-block edges doesn't work.
-    TheCFG.reserve(TheCFG.size() + ProgramPoints.size());
-
-    ProgramPointNode *FirstNode = MakeCFGNode(ProgramPoints.front());
-    ProgramPointNode *LastNode = FirstNode;
-    for (Instruction &I :
-         llvm::make_range(BB.begin(), ProgramPoints.front()->getIterator()))
-      NextProgramPointInBlock[&I] = LastNode;
-
-    auto ProgramPointPairs = llvm::zip_equal(llvm::drop_end(ProgramPoints),
-                                             llvm::drop_begin(ProgramPoints));
-    for (const auto &[PreviousProgramPoint, NextProgramPoint] :
-         ProgramPointPairs) {
-      // Create a new node.
-      ProgramPointNode *NewNode = MakeCFGNode(NextProgramPoint);
-      // We can already add intra-block edges.
-      LastNode->addSuccessor(NewNode);
-
-      // Now we have to initialize PreviousProgramPointInBlock for all the
-      // instructions that are not program points and that are among the
-      // previous program point and the current new one.
-      for (Instruction &I :
-           llvm::make_range(std::next(PreviousProgramPoint->getIterator()),
-                            NextProgramPoint->getIterator()))
-        PreviousProgramPointInBlock[&I] = LastNode;
-
-      // Finally we can update the LastNode.
-      LastNode = NewNode;
-    }
-    for (Instruction &I :
-         llvm::make_range(std::next(ProgramPoints.back()->getIterator()),
-                          BB.end()))
-      PreviousProgramPointInBlock[&I] = LastNode;
-
-    BlockToBeginEndNode[&BB] = { FirstNode, LastNode };
-  }
-
-  // Now we add the inter-block edges.
-  for (BasicBlock &BB : F)
-    for (BasicBlock *Successor : llvm::successors(&BB))
-      BlockToBeginEndNode.at(&BB)
-        .second->addSuccessor(BlockToBeginEndNode.at(Successor).first);
-
-  // And set the entry node, which makes the MFP later more efficient, because
-  // it allows the algorithm to take the structure of the graph into account,
-  // instead of iterating in sparse order.
-  TheCFG.setEntryNode(BlockToBeginEndNode.at(&F.getEntryBlock()).first);
-
-  return Result;
-}
-
-static ResultMap getMFP(ProgramPointsCFG *TheGraph) {
-  AvailableSet Bottom;
-  for (ProgramPointNode *N : llvm::nodes(TheGraph)) {
-    Instruction *I = N->TheInstruction;
-
-    if (mayReadMemory(*I)) {
-      Bottom.insert(AvailableExpression{
-        .Expression = I,
-        .Assign = nullptr,
-      });
-    }
-
-    if (auto *Assign = getCallToTagged(I, FunctionTags::Assign)) {
-      if (isa<Instruction>(Assign->getArgOperand(0))) {
-        Bottom.insert(AvailableExpression{
-          .Expression = cast<Instruction>(Assign->getArgOperand(0)),
-          .Assign = Assign,
-        });
-      }
-    }
-  }
-
-  AvailableSet Empty{};
-  return MFP::getMaximalFixedPoint<ALA>({},
-                                        TheGraph,
-                                        Bottom,
-                                        Empty,
-                                        { TheGraph->getEntryNode() });
-}
-
 struct PickedInstructions {
   SetVector<Instruction *> ToSerialize = {};
   MapVector<Use *, CallInst *> ToReplaceWithAvailable = {};
@@ -557,10 +65,8 @@ struct PickedInstructions {
 class InstructionToSerializePicker {
 public:
   InstructionToSerializePicker(Function &TheF,
-                               const ProgramPointsGraphWithInstructionMap
-                                 &TheGraph,
-                               const ResultMap &TheMFPResult) :
-    F(TheF), Graph(TheGraph), MFPResultMap(TheMFPResult), Picked() {}
+                               AvailableExpressions &TheAvailable) :
+    F(TheF), Available(TheAvailable), Picked() {}
 
 public:
   const PickedInstructions &pick() {
@@ -634,8 +140,8 @@ private:
     LoggerIndent UserIndent{ Log };
 
     const auto IsMemoryReadAvailableAt = [this, MemoryRead](const Use &TheUse) {
-      const auto *UserInstruction = cast<Instruction>(TheUse.getUser());
-      return Graph.isAvailableAt(MemoryRead, UserInstruction, MFPResultMap);
+      auto *UserInstruction = cast<Instruction>(TheUse.getUser());
+      return Available.isAvailableAt(MemoryRead, UserInstruction);
     };
 
     const auto SerializeI =
@@ -682,9 +188,7 @@ private:
         }
       }
 
-      auto AvailableRange = Graph.getAvailableAt(I,
-                                                 UserInstruction,
-                                                 MFPResultMap);
+      auto AvailableRange = Available.getAvailableAt(I, UserInstruction);
       if (AvailableRange.empty()) {
         revng_log(Log, "Found unavailable use. Serialize I");
         rc_return SerializeI();
@@ -835,8 +339,7 @@ private:
 
 private:
   Function &F;
-  const ProgramPointsGraphWithInstructionMap &Graph;
-  const ResultMap &MFPResultMap;
+  AvailableExpressions &Available;
   PickedInstructions Picked;
   std::unordered_map<const Instruction *, size_t> ProgramOrdering;
 };
@@ -847,9 +350,9 @@ class VariableBuilder {
 public:
   VariableBuilder(Function &TheF,
                   const model::Binary &TheModel,
-                  TypeMap &&TMap) :
+                  const TypeMap &TMap) :
     Model(TheModel),
-    TheTypeMap(std::move(TMap)),
+    TheTypeMap(TMap),
     F(TheF),
     Builder(TheF.getContext()),
     LocalVarPool(TheF.getParent(), false),
@@ -899,7 +402,7 @@ private:
 
 private:
   const model::Binary &Model;
-  const TypeMap TheTypeMap;
+  const TypeMap &TheTypeMap;
   Function &F;
   IRBuilder<> Builder;
   OpaqueFunctionsPool<Type *> LocalVarPool;
@@ -1028,24 +531,15 @@ bool SwitchToStatements::runOnFunction(Function &F) {
 
   revng_log(Log, "SwitchToStatements: " << F.getName());
 
-  ProgramPointsGraphWithInstructionMap
-    Graph = makeProgramPointsWithInstructionsGraph(F);
-
-  ResultMap Result = getMFP(&Graph.ProgramPointsGraph);
+  AvailableExpressions Available(F);
 
   auto &ModelWrapper = getAnalysis<LoadModelWrapperPass>().get();
   const TupleTree<model::Binary> &Model = ModelWrapper.getReadOnlyModel();
 
-  auto ModelFunction = llvmToModelFunction(*Model, F);
-  revng_assert(ModelFunction != nullptr);
+  auto &ModelTypes = getAnalysis<ModelTypesWrapperPass>();
 
-  InstructionToSerializePicker InstructionPicker{ F, Graph, Result };
-  VariableBuilder VarBuilder{ F,
-                              *Model,
-                              initModelTypes(F,
-                                             ModelFunction,
-                                             *Model,
-                                             /*PointerOnly*/ false) };
+  InstructionToSerializePicker InstructionPicker{ F, Available };
+  VariableBuilder VarBuilder{ F, *Model, ModelTypes.getTypes() };
 
   bool Changed = VarBuilder.run(InstructionPicker.pick());
 
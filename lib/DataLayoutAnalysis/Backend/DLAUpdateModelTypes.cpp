@@ -743,7 +743,8 @@ bool dla::updateSegmentsTypes(const llvm::Module &M,
 
   for (const auto &F : FunctionTags::SegmentRef.functions(&M)) {
     const auto &[StartAddress, VirtualSize] = extractSegmentKeyFromMetadata(F);
-    auto Segment = Model->Segments().at({ StartAddress, VirtualSize });
+    model::Segment &Segment = Model->Segments().at({ StartAddress,
+                                                     VirtualSize });
 
     // If the Segment type is missing, we have nothing to update.
     if (Segment.Type().isEmpty())
@@ -3,7 +3,10 @@
 //
 
 #include <algorithm>
+#include <map>
+#include <numeric>
 #include <string>
+#include <vector>
 
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SCCIterator.h"
@@ -212,8 +215,10 @@ LayoutTypeSystemNode *LayoutTypeSystem::createArtificialLayoutType() {
   revng_assert(New);
   ++NID;
   EqClasses.growBy1();
-  bool Success = Layouts.insert(New).second;
-  revng_assert(Success);
+  revng_assert(Layouts.size() == New->ID);
+  Layouts.push_back(New);
+  ++NumLayouts;
+  markChanged();
   return New;
 }
 
@@ -299,6 +304,8 @@ void LayoutTypeSystem::mergeNodes(llvm::ArrayRef<LayoutTypeSystemNode *>
   if (ToMerge.size() <= 1ULL)
     return;
 
+  markChanged();
+
   LayoutTypeSystemNode *Into = ToMerge[0];
   const unsigned IntoID = Into->ID;
 
@@ -324,19 +331,24 @@ void LayoutTypeSystem::mergeNodes(llvm::ArrayRef<LayoutTypeSystemNode *>
 
     fixPredSucc(From, Into);
 
-    // Remove From from Layouts
-    bool Erased = Layouts.erase(From);
-    revng_assert(Erased);
-    From->~LayoutTypeSystemNode();
-    NodeAllocator.Deallocate(From);
+    destroyNode(From);
   }
 }
 
+void LayoutTypeSystem::destroyNode(LayoutTypeSystemNode *N) {
+  revng_assert(Layouts[N->ID] == N);
+  Layouts[N->ID] = nullptr;
+  --NumLayouts;
+  N->~LayoutTypeSystemNode();
+  NodeAllocator.Deallocate(N);
+}
+
 void LayoutTypeSystem::removeNode(LayoutTypeSystemNode *ToRemove) {
   // Join the node's eq class with the removed class
   uint64_t TheID = ToRemove->ID;
   EqClasses.remove(TheID);
   revng_log(MergeLog, "Removing " << ToRemove->ID << "\n");
+  markChanged();
 
   using IDBasedKey = std::pair<uint64_t, const TypeLinkTag *>;
 
@@ -354,10 +366,7 @@ void LayoutTypeSystem::removeNode(LayoutTypeSystemNode *ToRemove) {
     SuccOfPred.erase(It, End);
   }
 
-  bool Erased = Layouts.erase(ToRemove);
-  revng_assert(Erased);
-  ToRemove->~LayoutTypeSystemNode();
-  NodeAllocator.Deallocate(ToRemove);
+  destroyNode(ToRemove);
 }
 
 using NeighborIterator = LayoutTypeSystem::NeighborIterator;
@@ -403,6 +412,8 @@ void LayoutTypeSystem::moveEdgeTarget(LayoutTypeSystemNode *OldTgt,
   if (not OldTgt or not NewTgt)
     return;
 
+  markChanged();
+
   if (not OffsetToSum)
     return moveEdgeTargetWithoutSumming(OldTgt, NewTgt, InverseEdgeIt);
 
@@ -441,6 +452,8 @@ void LayoutTypeSystem::moveEdgeSource(LayoutTypeSystemNode *OldSrc,
   if (not OldSrc or not NewSrc)
     return;
 
+  markChanged();
+
   if (not OffsetToSum)
     return moveEdgeSourceWithoutSumming(OldSrc, NewSrc, EdgeIt);
 
@@ -474,6 +487,7 @@ void LayoutTypeSystem::moveEdgeSource(LayoutTypeSystemNode *OldSrc,
 NeighborIterator LayoutTypeSystem::eraseEdge(LayoutTypeSystemNode *Src,
                                              NeighborIterator EdgeIt) {
   LayoutTypeSystemNode *Tgt = EdgeIt->first;
+  markChanged();
 
   // Erase the inverse edge from Tgt to Src
   bool Erased = Tgt->Predecessors.erase({ Src, EdgeIt->second });
@@ -490,11 +504,158 @@ void LayoutTypeSystem::dropOutgoingEdges(LayoutTypeSystemNode *N) {
     It = eraseEdge(N, It);
 }
 
+std::vector<LayoutTypeSystemPartition>
+LayoutTypeSystem::partition(unsigned N) {
+  revng_assert(N > 0);
+  markChanged();
+
+  // Compute the weakly connected components
+  llvm::IntEqClasses Components(NID);
+  for (const LayoutTypeSystemNode *Node : getLayoutsRange())
+    for (const auto &[Successor, Tag] : Node->Successors)
+      Components.join(Node->ID, Successor->ID);
+  Components.compress();
+
+  std::vector<size_t> ComponentSizes(Components.getNumClasses(), 0);
+  for (const LayoutTypeSystemNode *Node : getLayoutsRange())
+    ++ComponentSizes[Components[Node->ID]];
+
+  // Assign the components to the partitions, from the largest one, each time
+  // to the partition with the fewest nodes
+  std::vector<unsigned> ComponentsBySize(ComponentSizes.size());
+  std::iota(ComponentsBySize.begin(), ComponentsBySize.end(), 0);
+  const auto IsLarger = [&ComponentSizes](unsigned A, unsigned B) {
+    return ComponentSizes[A] > ComponentSizes[B];
+  };
+  llvm::stable_sort(ComponentsBySize, IsLarger);
+
+  std::vector<size_t> PartitionSizes(N, 0);
+  std::vector<unsigned> PartitionOfComponent(ComponentSizes.size(), 0);
+  for (unsigned Component : ComponentsBySize) {
+    if (ComponentSizes[Component] == 0)
+      continue;
+    auto Smallest = std::min_element(PartitionSizes.begin(),
+                                     PartitionSizes.end());
+    PartitionOfComponent[Component] = Smallest - PartitionSizes.begin();
+    *Smallest += ComponentSizes[Component];
+  }
+
+  std::vector<LayoutTypeSystemPartition> Result(N);
+  for (LayoutTypeSystemPartition &Partition : Result)
+    Partition.TS = std::make_unique<LayoutTypeSystem>();
+
+  // Create the nodes, in ID order, so that the relative order of the nodes in
+  // each partition is preserved
+  std::vector<LayoutTypeSystemNode *> Copies(NID, nullptr);
+  for (const LayoutTypeSystemNode *Node : getLayoutsRange()) {
+    unsigned Index = PartitionOfComponent[Components[Node->ID]];
+    LayoutTypeSystemPartition &Partition = Result[Index];
+    LayoutTypeSystemNode *Copy = Partition.TS->createArtificialLayoutType();
+    Copy->Size = Node->Size;
+    Copy->InterferingInfo = Node->InterferingInfo;
+    Copy->NonScalar = Node->NonScalar;
+    Partition.OriginalIDs.push_back(Node->ID);
+    Copies[Node->ID] = Copy;
+  }
+
+  // Copy the edges, and drop them from this type system
+  for (LayoutTypeSystemNode *Node : getLayoutsRange()) {
+    LayoutTypeSystemPartition &Partition = Result[PartitionOfComponent
+                                                    [Components[Node->ID]]];
+    for (const auto &[Successor, Tag] : Node->Successors) {
+      bool New = Partition.TS
+                   ->addLink(Copies[Node->ID],
+                             Copies[Successor->ID],
+                             TypeLinkTag(*Tag))
+                   .second;
+      revng_assert(New);
+    }
+  }
+
+  for (LayoutTypeSystemNode *Node : getLayoutsRange()) {
+    Node->Successors.clear();
+    Node->Predecessors.clear();
+  }
+
+  return Result;
+}
+
+void LayoutTypeSystem::absorb(std::vector<LayoutTypeSystemPartition>
+                                &&Partitions) {
+  markChanged();
+  for (LayoutTypeSystemPartition &Partition : Partitions) {
+    const LayoutTypeSystem &Part = *Partition.TS;
+    const VectEqClasses &PartEqClasses = Part.getEqClasses();
+    // We need the leaders, which are not available after compression
+    revng_assert(PartEqClasses.getNumClasses() == 0);
+
+    // Map each node ever created in the partition to a node of this type
+    // system, creating the ones that did not exist when partitioning
+    std::vector<LayoutTypeSystemNode *> Originals;
+    Originals.reserve(Part.getNID());
+    for (uint64_t OriginalID : Partition.OriginalIDs) {
+      LayoutTypeSystemNode *Original = getLayout(OriginalID);
+      revng_assert(Original != nullptr);
+      revng_assert(Original->Successors.empty());
+      revng_assert(Original->Predecessors.empty());
+      Originals.push_back(Original);
+    }
+    while (Originals.size() < Part.getNID())
+      Originals.push_back(createArtificialLayoutType());
+
+    // For each equivalence class of the partition, the node still alive
+    std::map<unsigned, const LayoutTypeSystemNode *> Survivors;
+    for (const LayoutTypeSystemNode *Node : Part.getLayoutsRange()) {
+      bool New = Survivors.emplace(PartEqClasses.findLeader(Node->ID), Node)
+                   .second;
+      revng_assert(New);
+    }
+
+    // Replay the merges and the removals
+    for (unsigned ID = 0; ID < Part.getNID(); ++ID) {
+      LayoutTypeSystemNode *Original = Originals[ID];
+      if (PartEqClasses.isRemoved(ID)) {
+        EqClasses.remove(Original->ID);
+        destroyNode(Original);
+        continue;
+      }
+
+      const LayoutTypeSystemNode *Survivor = Survivors.at(PartEqClasses
+                                                            .findLeader(ID));
+      if (Survivor->ID == ID)
+        continue;
+
+      EqClasses.join(Originals[Survivor->ID]->ID, Original->ID);
+      destroyNode(Original);
+    }
+
+    // Copy the properties of the nodes and the edges
+    for (const LayoutTypeSystemNode *Node : Part.getLayoutsRange()) {
+      LayoutTypeSystemNode *Original = Originals[Node->ID];
+      Original->Size = Node->Size;
+      Original->InterferingInfo = Node->InterferingInfo;
+      Original->NonScalar = Node->NonScalar;
+    }
+
+    for (const LayoutTypeSystemNode *Node : Part.getLayoutsRange()) {
+      for (const auto &[Successor, Tag] : Node->Successors) {
+        bool New = addLink(Originals[Node->ID],
+                           Originals[Successor->ID],
+                           TypeLinkTag(*Tag))
+                     .second;
+        revng_assert(New);
+      }
+    }
+  }
+
+  Partitions.clear();
+}
+
 static Logger<> VerifyDLALog("dla-verify-strict");
 
 bool LayoutTypeSystem::verifyConsistency() const {
-  for (LayoutTypeSystemNode *NodePtr : Layouts) {
-    if (not NodePtr) {
+  for (LayoutTypeSystemNode *NodePtr : getLayoutsRange()) {
+    if (not NodePtr or getLayout(NodePtr->ID) != NodePtr) {
       if (VerifyDLALog.isEnabled())
         revng_check(false);
       return false;
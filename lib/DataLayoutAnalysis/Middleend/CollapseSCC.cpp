@@ -2,6 +2,7 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <optional>
 #include <set>
 #include <type_traits>
 #include <vector>
@@ -193,12 +194,16 @@ bool CollapseEqualitySCC::runOnTypeSystem(LayoutTypeSystem &TS) {
 }
 
 bool CollapseInstanceAtOffset0SCC::runOnTypeSystem(LayoutTypeSystem &TS) {
-  Task T(2, "runOnTypeSystem");
+  // Tasks are not thread-safe, see StepManager::ShowProgress
+  std::optional<Task> T;
+  if (ShowProgress)
+    T.emplace(2, "runOnTypeSystem");
 
   if (VerifyLog.isEnabled())
     revng_assert(TS.verifyConsistency());
 
-  T.advance("collapseInstanceAtOffset0SCC");
+  if (T)
+    T->advance("collapseInstanceAtOffset0SCC");
   revng_log(LogVerbose, "#### Collapsing Instance-at-offset-0 SCC: ... ");
   bool Changed = collapseInstanceAtOffset0SCC(TS);
   revng_log(LogVerbose, "#### Collapsing Instance-at-offset-0 SCC: Done!");
@@ -208,8 +213,10 @@ bool CollapseInstanceAtOffset0SCC::runOnTypeSystem(LayoutTypeSystem &TS) {
     revng_assert(TS.verifyInstanceAtOffset0DAG());
   }
 
-  T.advance("removeInstanceBackedgesFromInstanceAtOffset0Loops");
-  Changed |= removeInstanceBackedgesFromInstanceAtOffset0Loops(TS);
+  if (T)
+    T->advance("removeInstanceBackedgesFromInstanceAtOffset0Loops");
+  Changed |= removeInstanceBackedgesFromInstanceAtOffset0Loops(TS,
+                                                               ShowProgress);
 
   if (VerifyLog.isEnabled()) {
     revng_assert(TS.verifyConsistency());
@@ -103,6 +103,7 @@ bool CollapseSingleChild::collapseSingle(LayoutTypeSystem &TS,
 
       TS.mergeNodes({ /*Into=*/Node, /*From=*/Child });
       Node->Size = ChildSize;
+      TS.markChanged();
 
       Changed = true;
       Merged = true;
@@ -31,6 +31,13 @@ bool ComputeNonInterferingComponents::runOnTypeSystem(LayoutTypeSystem &TS) {
 
   bool Changed = false;
 
+  const auto SetInterferingInfo = [&TS](LTSN *N, InterferingChildrenInfo I) {
+    if (N->InterferingInfo != I) {
+      N->InterferingInfo = I;
+      TS.markChanged();
+    }
+  };
+
   // Helper set, to prevent visiting a node from multiple entry points.
   std::set<const LTSN *> Visited;
 
@@ -94,7 +101,7 @@ bool ComputeNonInterferingComponents::runOnTypeSystem(LayoutTypeSystem &TS) {
       // constitute a single non-interfering component and we can leave them
       // alone.
       if (Children.empty()) {
-        N->InterferingInfo = AllChildrenAreNonInterfering;
+        SetInterferingInfo(N, AllChildrenAreNonInterfering);
         continue;
       }
 
@@ -102,7 +109,7 @@ bool ComputeNonInterferingComponents::runOnTypeSystem(LayoutTypeSystem &TS) {
       // nothing to do, because the only children cannot interfere with anything
       // else, and it is already a component on its own.
       if (Children.size() == 1ULL) {
-        N->InterferingInfo = AllChildrenAreNonInterfering;
+        SetInterferingInfo(N, AllChildrenAreNonInterfering);
         continue;
       }
 
@@ -188,9 +195,9 @@ bool ComputeNonInterferingComponents::runOnTypeSystem(LayoutTypeSystem &TS) {
       if (Components.size() < 2) {
         revng_assert(not Components.empty());
         if (Components.back().NumChildren > 1)
-          N->InterferingInfo = AllChildrenAreInterfering;
+          SetInterferingInfo(N, AllChildrenAreInterfering);
         else
-          N->InterferingInfo = AllChildrenAreNonInterfering;
+          SetInterferingInfo(N, AllChildrenAreNonInterfering);
         continue;
       }
 
@@ -231,7 +238,7 @@ bool ComputeNonInterferingComponents::runOnTypeSystem(LayoutTypeSystem &TS) {
         TS.addInstanceLink(N, New, OffsetExpression(C.StartByte));
       }
 
-      N->InterferingInfo = AllChildrenAreNonInterfering;
+      SetInterferingInfo(N, AllChildrenAreNonInterfering);
     }
   }
 
@@ -68,8 +68,10 @@ bool ComputeUpperMemberAccesses::runOnTypeSystem(LayoutTypeSystem &TS) {
         FinalSize = std::max(FinalSize, getFieldUpperMember(Child, EdgeTag));
       }
 
-      if (FinalSize != N->Size)
+      if (FinalSize != N->Size) {
         Changed = true;
+        TS.markChanged();
+      }
 
       N->Size = FinalSize;
       revng_assert(FinalSize);
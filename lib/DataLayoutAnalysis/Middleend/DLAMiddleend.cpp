@@ -0,0 +1,123 @@
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/ThreadPool.h"
+
+#include "revng/Support/Assert.h"
+
+#include "revng-c/DataLayoutAnalysis/DLATypeSystem.h"
+
+#include "DLAStep.h"
+
+static void addMiddleendSteps(dla::StepManager &SM, size_t PtrSize) {
+  //
+  // Graph normalization phase
+  //
+  revng_check(SM.addStep<dla::RemoveInvalidPointers>(PtrSize));
+  revng_check(SM.addStep<dla::CollapseEqualitySCC>());
+  revng_check(SM.addStep<dla::CollapseInstanceAtOffset0SCC>());
+  revng_check(SM.addStep<dla::SimplifyInstanceAtOffset0>());
+  revng_check(SM.addStep<dla::PruneLayoutNodesWithoutLayout>());
+  revng_check(SM.addStep<dla::ComputeUpperMemberAccesses>());
+  revng_check(SM.addStep<dla::RemoveInvalidStrideEdges>());
+  revng_check(SM.addStep<dla::PruneLayoutNodesWithoutLayout>());
+  revng_check(SM.addStep<dla::ComputeUpperMemberAccesses>());
+  revng_check(SM.addStep<dla::DecomposeStridedEdges>());
+
+  //
+  // Graph optimization phase
+  //
+  revng_check(SM.addStep<dla::CollapseSingleChild>());
+  revng_check(SM.addStep<dla::DeduplicateFields>());
+  revng_check(SM.addStep<dla::MergePointeesOfPointerUnion>(PtrSize));
+  revng_check(SM.addStep<dla::MergePointerNodes>());
+  revng_check(SM.addStep<dla::CollapseInstanceAtOffset0SCC>());
+  revng_check(SM.addStep<dla::SimplifyInstanceAtOffset0>());
+  revng_check(SM.addStep<dla::PruneLayoutNodesWithoutLayout>());
+  revng_check(SM.addStep<dla::ComputeUpperMemberAccesses>());
+  revng_check(SM.addStep<dla::RemoveInvalidStrideEdges>());
+  revng_check(SM.addStep<dla::PruneLayoutNodesWithoutLayout>());
+  revng_check(SM.addStep<dla::ComputeUpperMemberAccesses>());
+
+  revng_check(SM.addStep<dla::MergePointerNodes>());
+  // CollapseSingleChild and DeduplicateFields run before
+  // CompactCompatibleArrays and ArrangeAccessesHierarchically, to allow them to
+  // produce better results
+  revng_check(SM.addStep<dla::CollapseSingleChild>());
+  revng_check(SM.addStep<dla::DeduplicateFields>());
+  revng_check(SM.addStep<dla::ArrangeAccessesHierarchically>());
+  revng_check(SM.addStep<dla::CompactCompatibleArrays>());
+  revng_check(SM.addStep<dla::PushDownPointers>());
+  // ArrangeAccessesHierarchically can move pointer edges around in some cases,
+  // so we want to run MergePointerNodes again afterwards.
+  revng_check(SM.addStep<dla::MergePointerNodes>());
+  // CollapseSingleChild and DeduplicateFields run again after
+  // CompactCompatibleArrays and ArrangeAccessesHierarchically, to allow them to
+  // improve the results even further.
+  revng_check(SM.addStep<dla::ResolveLeafUnions>());
+  revng_check(SM.addStep<dla::CollapseSingleChild>());
+  revng_check(SM.addStep<dla::DeduplicateFields>());
+  revng_check(SM.addStep<dla::ComputeNonInterferingComponents>());
+}
+
+/// Run the middle-end steps on the weakly connected components of \p TS in
+/// parallel.
+///
+/// The steps only ever merge, compare or move edges between nodes that are
+/// connected, so running them on each component separately gives the same
+/// result as running them on the whole type system.
+static void runMiddleendInParallel(dla::LayoutTypeSystem &TS,
+                                   size_t PtrSize,
+                                   unsigned Threads) {
+  auto Strategy = llvm::hardware_concurrency(Threads);
+  unsigned WorkerCount = Strategy.compute_thread_count();
+  auto Partitions = TS.partition(WorkerCount);
+
+  std::vector<dla::StepManager> Managers(Partitions.size());
+  {
+    llvm::ThreadPool Pool(Strategy);
+    for (auto [Index, Partition] : llvm::enumerate(Partitions)) {
+      if (Partition.TS->getNumLayouts() == 0)
+        continue;
+
+      dla::StepManager &SM = Managers[Index];
+      SM.ShowProgress = false;
+      SM.DotPrefix = "type-system-partition-" + std::to_string(Index);
+      addMiddleendSteps(SM, PtrSize);
+      Pool.async([&SM, &PartitionTS = *Partition.TS]() {
+        SM.run(PartitionTS);
+      });
+    }
+    Pool.wait();
+  }
+
+  TS.absorb(std::move(Partitions));
+
+  dla::StepManager Total;
+  for (const dla::StepManager &SM : Managers)
+    if (SM.getNumSteps() != 0)
+      Total.accumulateStatistics(SM);
+  Total.dumpStatistics();
+}
+
+namespace dla {
+
+void runMiddleend(LayoutTypeSystem &TS, size_t PointerSize, unsigned Threads) {
+  if (Threads != 1) {
+    runMiddleendInParallel(TS, PointerSize, Threads);
+    return;
+  }
+
+  StepManager SM;
+  addMiddleendSteps(SM, PointerSize);
+  SM.run(TS);
+  SM.dumpStatistics();
+}
+
+} // end namespace dla
@@ -2,7 +2,19 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <chrono>
+#include <optional>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/JSON.h"
 #include "llvm/Support/Progress.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/raw_ostream.h"
 
 #include "revng/Support/Assert.h"
 #include "revng/Support/Debug.h"
@@ -71,6 +83,40 @@ static std::string getStepNameFromID(const void *ID) {
 static Logger<> DLAStepManagerLog("dla-step-manager");
 static Logger<> DLADumpDot("dla-step-dump-dot");
 
+enum class StatisticsFormat {
+  JSON,
+  CSV,
+};
+
+namespace cl = llvm::cl;
+
+static cl::opt<std::string> StatisticsPath("dla-step-statistics",
+                                           cl::desc("Write the time spent in "
+                                                    "each DLA step, and the "
+                                                    "size of the type system "
+                                                    "before and after it, to "
+                                                    "this file."),
+                                           cl::value_desc("path"));
+
+using StatisticsFormatOption = cl::opt<StatisticsFormat>;
+static StatisticsFormatOption
+  StatisticsFormatOpt("dla-step-statistics-format",
+                      cl::desc("Format of the -dla-step-statistics file."),
+                      cl::values(clEnumValN(StatisticsFormat::JSON,
+                                            "json",
+                                            "JSON"),
+                                 clEnumValN(StatisticsFormat::CSV,
+                                            "csv",
+                                            "CSV")),
+                      cl::init(StatisticsFormat::JSON));
+
+static cl::opt<bool> SkipUnchangedSteps("dla-skip-unchanged-steps",
+                                        cl::desc("Do not run a DLA step on a "
+                                                 "type system on which it has "
+                                                 "already reached a fixed "
+                                                 "point."),
+                                        cl::init(false));
+
 [[nodiscard]] bool StepManager::addStep(std::unique_ptr<Step> S) {
   const void *StepID = S->getStepID();
 
@@ -117,26 +163,172 @@ static Logger<> DLADumpDot("dla-step-dump-dot");
   return true;
 }
 
+static size_t countEdges(const LayoutTypeSystem &TS) {
+  size_t Edges = 0;
+  for (const LayoutTypeSystemNode *N : TS.getLayoutsRange())
+    Edges += N->Successors.size();
+  return Edges;
+}
+
 void StepManager::run(LayoutTypeSystem &TS) {
   if (not hasValidSchedule())
     revng_abort("Cannot run a on LayoutTypeSystem: invalid schedule");
   int x = 0;
   if (DLADumpDot.isEnabled())
-    TS.dumpDotOnFile("type-system-0.dot", true);
+    TS.dumpDotOnFile(DotPrefix + "-0.dot", true);
+
+  Statistics.clear();
+  size_t Nodes = TS.getNumLayouts();
+  size_t Edges = countEdges(TS);
+
+  // Maps the ID of each Step to the generation of the type system on which it
+  // last ran without changing anything. Running it again on the same
+  // generation would be a no-op.
+  llvm::SmallDenseMap<const void *, uint64_t, 16> FixedPoints;
 
-  llvm::Task T{ Schedule.size(), "StepManager::run" };
+  std::optional<llvm::Task> T;
+  if (ShowProgress)
+    T.emplace(Schedule.size(), "StepManager::run");
   for (auto &S : Schedule) {
-    T.advance(getStepNameFromID(S->getStepID()));
-    S->runOnTypeSystem(TS);
+    const void *StepID = S->getStepID();
+    std::string Name = getStepNameFromID(StepID);
+    if (T)
+      T->advance(Name);
+
     ++x;
+    StepStatistics &Stats = Statistics.emplace_back();
+    Stats.Name = Name;
+    Stats.Index = x;
+    Stats.NodesBefore = Stats.NodesAfter = Nodes;
+    Stats.EdgesBefore = Stats.EdgesAfter = Edges;
+
+    if (SkipUnchangedSteps) {
+      auto It = FixedPoints.find(StepID);
+      if (It != FixedPoints.end() and It->second == TS.getGeneration()) {
+        Stats.Skipped = true;
+        revng_log(DLAStepManagerLog,
+                  "Step " << Name << " Index: " << x
+                          << " Skipped: type system unchanged");
+        continue;
+      }
+    }
+
+    bool Changed = false;
+    uint64_t Generation = TS.getGeneration();
+    auto Start = std::chrono::steady_clock::now();
+    {
+      llvm::TimeTraceScope Scope("DLAStep", Name);
+      S->setShowProgress(ShowProgress);
+      Changed = S->runOnTypeSystem(TS);
+    }
+    auto End = std::chrono::steady_clock::now();
+
+    // Do not trust a Step claiming it has not changed anything: it might have
+    // updated some node without reporting it
+    bool Modified = TS.getGeneration() != Generation;
+    if (Modified and not Changed)
+      revng_log(DLAStepManagerLog,
+                "Step " << Name
+                        << " changed the type system without reporting it");
+
+    if (Changed and not Modified)
+      TS.markChanged();
+
+    if (SkipUnchangedSteps) {
+      if (Changed or Modified)
+        FixedPoints.erase(StepID);
+      else
+        FixedPoints[StepID] = TS.getGeneration();
+    }
+
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    Stats.Time = duration_cast<microseconds>(End - Start);
+    Stats.NodesAfter = Nodes = TS.getNumLayouts();
+    Stats.EdgesAfter = Edges = countEdges(TS);
+    Stats.Changed = Changed;
+
+    revng_log(DLAStepManagerLog,
+              "Step " << Name << " Index: " << x << " Time: "
+                      << Stats.Time.count() << "us Nodes: "
+                      << Stats.NodesBefore << " -> " << Stats.NodesAfter
+                      << " Edges: " << Stats.EdgesBefore << " -> "
+                      << Stats.EdgesAfter << " Changed: " << Changed);
+
     if (DLADumpDot.isEnabled()) {
-      revng_log(DLADumpDot,
-                "Step " << getStepNameFromID(S->getStepID())
-                        << " Index: " << x);
-      std::string DotName = "type-system-" + std::to_string(x) + ".dot";
+      revng_log(DLADumpDot, "Step " << Name << " Index: " << x);
+      std::string DotName = DotPrefix + "-" + std::to_string(x) + ".dot";
       TS.dumpDotOnFile(DotName.c_str(), true);
     }
   }
 }
 
+void StepManager::dumpStatistics() const {
+  if (not StatisticsPath.getNumOccurrences())
+    return;
+
+  std::error_code EC;
+  llvm::raw_fd_ostream File(StatisticsPath, EC);
+  revng_check(not EC, (EC.message() + ": " + StatisticsPath).c_str());
+  switch (StatisticsFormatOpt) {
+  case StatisticsFormat::JSON:
+    printStatisticsAsJSON(File);
+    break;
+  case StatisticsFormat::CSV:
+    printStatisticsAsCSV(File);
+    break;
+  }
+}
+
+void StepManager::accumulateStatistics(const StepManager &Other) {
+  if (Statistics.empty()) {
+    Statistics = Other.Statistics;
+    return;
+  }
+
+  revng_assert(Statistics.size() == Other.Statistics.size());
+  for (auto [Stats, OtherStats] : llvm::zip(Statistics, Other.Statistics)) {
+    revng_assert(Stats.Name == OtherStats.Name);
+    Stats.Time += OtherStats.Time;
+    Stats.NodesBefore += OtherStats.NodesBefore;
+    Stats.EdgesBefore += OtherStats.EdgesBefore;
+    Stats.NodesAfter += OtherStats.NodesAfter;
+    Stats.EdgesAfter += OtherStats.EdgesAfter;
+    Stats.Changed |= OtherStats.Changed;
+    Stats.Skipped &= OtherStats.Skipped;
+  }
+}
+
+void StepManager::printStatisticsAsJSON(llvm::raw_ostream &OS) const {
+  llvm::json::OStream JSON(OS, 2);
+  JSON.array([&] {
+    for (const StepStatistics &Stats : Statistics) {
+      JSON.object([&] {
+        JSON.attribute("Name", Stats.Name);
+        JSON.attribute("Index", Stats.Index);
+        JSON.attribute("TimeMicroseconds", Stats.Time.count());
+        JSON.attribute("NodesBefore", Stats.NodesBefore);
+        JSON.attribute("EdgesBefore", Stats.EdgesBefore);
+        JSON.attribute("NodesAfter", Stats.NodesAfter);
+        JSON.attribute("EdgesAfter", Stats.EdgesAfter);
+        JSON.attribute("Changed", Stats.Changed);
+        JSON.attribute("Skipped", Stats.Skipped);
+      });
+    }
+  });
+  OS << '\n';
+}
+
+void StepManager::printStatisticsAsCSV(llvm::raw_ostream &OS) const {
+  OS << "Index,Name,TimeMicroseconds,NodesBefore,EdgesBefore,NodesAfter,"
+        "EdgesAfter,Changed,Skipped\n";
+  for (const StepStatistics &Stats : Statistics) {
+    OS << Stats.Index << ',' << Stats.Name << ',' << Stats.Time.count() << ','
+       << Stats.NodesBefore << ',' << Stats.EdgesBefore << ','
+       << Stats.NodesAfter << ',' << Stats.EdgesAfter << ','
+       << (Stats.Changed ? "true" : "false") << ','
+       << (Stats.Skipped ? "true" : "false") << '\n';
+  }
+}
+
 } // end namespace dla
@@ -5,12 +5,16 @@
 //
 
 #include <algorithm>
+#include <chrono>
 #include <memory>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
 
 #include "revng-c/DataLayoutAnalysis/DLATypeSystem.h"
 
@@ -36,6 +40,9 @@ protected:
   IDSet Dependencies;
   IDSet Invalidated;
 
+  /// Report the progress of runOnTypeSystem, see StepManager::ShowProgress
+  bool ShowProgress = true;
+
   Step(const char &C,
        std::initializer_list<const void *> D,
        std::initializer_list<const void *> I) :
@@ -54,6 +61,8 @@ public:
   IDSetConstRef getInvalidated() const { return Invalidated; }
 
   const void *getStepID() const { return StepID; };
+
+  void setShowProgress(bool Value) { ShowProgress = Value; }
 };
 
 /// Collapses strongly connected components made of equality edges
@@ -400,16 +409,41 @@ public:
     Done,
   };
 
+  /// What happened during a single execution of a Step
+  struct StepStatistics {
+    std::string Name;
+    /// Position of the Step in the Schedule
+    size_t Index = 0;
+    std::chrono::microseconds Time{};
+    size_t NodesBefore = 0;
+    size_t EdgesBefore = 0;
+    size_t NodesAfter = 0;
+    size_t EdgesAfter = 0;
+    /// The value returned by runOnTypeSystem
+    bool Changed = false;
+    /// The Step has not been run, since it had already reached a fixed point
+    /// on the same type system
+    bool Skipped = false;
+  };
+
 public:
   llvm::SmallVector<std::unique_ptr<Step>, 16> Schedule;
   llvm::SmallPtrSet<const void *, 16> InsertedSteps;
   llvm::SmallPtrSet<const void *, 16> InvalidatedSteps;
+  /// One element for each Step executed by the last call to run
+  std::vector<StepStatistics> Statistics;
+  /// Report the progress of run. Must be false if run is not invoked on the
+  /// main thread.
+  bool ShowProgress = true;
+  /// Prefix of the names of the files produced by dla-step-dump-dot
+  std::string DotPrefix = "type-system";
 
   using sched_const_iterator = decltype(Schedule)::const_iterator;
   using sched_const_range = llvm::iterator_range<sched_const_iterator>;
 
 public:
-  StepManager() : Schedule(), InsertedSteps(), InvalidatedSteps() {}
+  StepManager() :
+    Schedule(), InsertedSteps(), InvalidatedSteps(), Statistics() {}
 
   /// Adds a Step to the StepManager, moving ownership into it.
   [[nodiscard]] bool addStep(std::unique_ptr<Step> S);
@@ -419,7 +453,10 @@ public:
     return addStep(std::make_unique<StepT>(std::forward<ArgsT &&>(Args)...));
   }
 
-  /// Runs the added steps
+  /// Runs the added steps.
+  ///
+  /// A Step is skipped if the last time it ran it did not change the type
+  /// system, and no other Step has changed it since then.
   void run(LayoutTypeSystem &TS);
 
   /// Drops all the scheduled steps
@@ -427,8 +464,28 @@ public:
     Schedule.clear();
     InsertedSteps.clear();
     InvalidatedSteps.clear();
+    Statistics.clear();
+  }
+
+  /// Get the statistics collected by the last call to run
+  const std::vector<StepStatistics> &getStatistics() const {
+    return Statistics;
   }
 
+  /// Print the statistics as a JSON array, with an object for each Step
+  void printStatisticsAsJSON(llvm::raw_ostream &OS) const;
+
+  /// Print the statistics as CSV, with a row for each Step
+  void printStatisticsAsCSV(llvm::raw_ostream &OS) const;
+
+  /// Write the statistics to the file specified with -dla-step-statistics, if
+  /// any
+  void dumpStatistics() const;
+
+  /// Add to the statistics of each Step the ones of the same Step in \a Other,
+  /// which must have run the same schedule on a different type system
+  void accumulateStatistics(const StepManager &Other);
+
   bool hasValidSchedule() const {
     return not intersect(InsertedSteps, InvalidatedSteps);
   }
@@ -444,4 +501,11 @@ public:
   }
 };
 
+/// Run all the middle-end Steps on \a TS.
+///
+/// If \a Threads is not 1, the weakly connected components of \a TS are
+/// processed in parallel, on \a Threads threads, 0 meaning one per hardware
+/// thread. Progress is only reported when running serially.
+void runMiddleend(LayoutTypeSystem &TS, size_t PointerSize, unsigned Threads);
+
 } // end namespace dla
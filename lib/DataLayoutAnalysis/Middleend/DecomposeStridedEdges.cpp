@@ -77,8 +77,10 @@ bool DecomposeStridedEdges::runOnTypeSystem(LayoutTypeSystem &TS) {
         LayoutTypeSystemNode *Succ = NodeChain[Idx];
         // Link them
         const auto [Tag, New] = TS.addInstanceLink(Pred, Succ, std::move(OE));
-        if (Pred != Parent)
+        if (Pred != Parent) {
           Pred->Size = getFieldSize(Succ, Tag);
+          TS.markChanged();
+        }
       }
 
       // Remove the old strided edge
@@ -325,6 +325,7 @@ bool MergePointeesOfPointerUnion::runOnTypeSystem(LayoutTypeSystem &TS) {
                                OffsetExpression{ 0 });
           } else if (not MergedAggregate->NonScalar) {
             MergedAggregate->Size = MergedScalar->Size;
+            TS.markChanged();
             TS.addInstanceLink(MergedAggregate,
                                MergedScalar,
                                OffsetExpression{ 0 });
@@ -4,6 +4,7 @@
 
 #include <compare>
 #include <limits>
+#include <optional>
 #include <vector>
 
 #include "llvm/ADT/DepthFirstIterator.h"
@@ -62,7 +63,7 @@ static bool hasNoSCCEdge(const LTSN *Node) {
 };
 
 template<SCCWithBackedgeHelper SCC>
-static bool removeBackedgesFromSCC(LayoutTypeSystem &TS) {
+static bool removeBackedgesFromSCC(LayoutTypeSystem &TS, bool ShowProgress) {
   bool Changed = false;
   if (VerifyLog.isEnabled()) {
     revng_assert(TS.verifyConsistency());
@@ -86,8 +87,11 @@ static bool removeBackedgesFromSCC(LayoutTypeSystem &TS) {
 
   revng_log(Log, "Removing Backedges From Loops");
 
-  llvm::Task T(2, "removeBackedgesFromSCC");
-  T.advance("Detect SCC Node View Components");
+  std::optional<llvm::Task> T;
+  if (ShowProgress) {
+    T.emplace(2, "removeBackedgesFromSCC");
+    T->advance("Detect SCC Node View Components");
+  }
   // Assign each node to a Component, except for those that have no incoming nor
   // outgoing SCCNodeView edges. The goal is to identify the subsets of nodes
   // that are connected by means of SCCNodeView edges. In this way we divide the
@@ -140,7 +144,8 @@ static bool removeBackedgesFromSCC(LayoutTypeSystem &TS) {
 
   using MixedNodeT = EdgeFilteredGraph<LTSN *, isMixedEdge<SCC>>;
 
-  T.advance("Remove Backedges");
+  if (T)
+    T->advance("Remove Backedges");
   for (const auto &Root : llvm::nodes(&TS)) {
     revng_assert(Root != nullptr);
     // We start from SCCNodeView roots and look if we find an SCC with mixed
@@ -321,6 +326,7 @@ static bool removeBackedgesFromSCC(LayoutTypeSystem &TS) {
       Edge PredToChild = std::make_pair(Child, T);
       Erased = Pred->Successors.erase(PredToChild);
       revng_assert(Erased);
+      TS.markChanged();
       Changed = true;
     }
   }
@@ -349,8 +355,10 @@ static bool removeBackedgesFromSCC(LayoutTypeSystem &TS) {
   return Changed;
 }
 
-bool removeInstanceBackedgesFromInstanceAtOffset0Loops(LayoutTypeSystem &TS) {
-  return removeBackedgesFromSCC<InstanceOffsetZeroWithInstanceBackedge>(TS);
+bool removeInstanceBackedgesFromInstanceAtOffset0Loops(LayoutTypeSystem &TS,
+                                                       bool ShowProgress) {
+  using SCC = InstanceOffsetZeroWithInstanceBackedge;
+  return removeBackedgesFromSCC<SCC>(TS, ShowProgress);
 }
 
 } // end namespace dla
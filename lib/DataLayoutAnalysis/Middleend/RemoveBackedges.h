@@ -9,6 +9,7 @@ namespace dla {
 class LayoutTypeSystem;
 
 extern bool
-removeInstanceBackedgesFromInstanceAtOffset0Loops(LayoutTypeSystem &TS);
+removeInstanceBackedgesFromInstanceAtOffset0Loops(LayoutTypeSystem &TS,
+                                                  bool ShowProgress);
 
 } // end namespace dla
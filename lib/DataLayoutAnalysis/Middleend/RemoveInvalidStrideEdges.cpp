@@ -93,6 +93,7 @@ bool RemoveInvalidStrideEdges::runOnTypeSystem(LayoutTypeSystem &TS) {
         revng_assert(PredIt != Succ->Predecessors.end());
         Succ->Predecessors.erase(PredIt);
         N->Successors.erase(It);
+        TS.markChanged();
         RemovedChild = true;
         Changed = true;
       }
@@ -120,6 +121,8 @@ bool RemoveInvalidStrideEdges::runOnTypeSystem(LayoutTypeSystem &TS) {
           NewSize = std::max(NewSize, getFieldUpperMember(Child, EdgeTag));
         }
 
+        if (NewSize != N->Size)
+          TS.markChanged();
         N->Size = NewSize;
       }
     }
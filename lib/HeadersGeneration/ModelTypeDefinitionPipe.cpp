@@ -2,6 +2,9 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <set>
+#include <string>
+
 #include "revng/Model/Binary.h"
 #include "revng/Pipeline/AllRegistries.h"
 #include "revng/Pipes/Kinds.h"
@@ -41,8 +44,26 @@ public:
            const BinaryFileContainer &SourceBinary,
            TypeDefinitionStringMap &ModelTypesContainer) {
     const model::Binary &Model = *getModelFromContext(EC);
-    for (const model::TypeDefinition &Type :
-         getTypeDefinitionsAndCommit(EC, ModelTypesContainer.name())) {
+
+    std::set<std::string> Requested;
+    for (const pipeline::Target &Target :
+         EC.getRequestedTargetsFor(ModelTypesContainer))
+      Requested.insert(Target.getPathComponents()[0]);
+
+    if (Requested.empty())
+      return;
+
+    // Every type definition depends on the inlinable types, which in turn
+    // depend on all the type definitions and stack frames of the model.
+    // Compute them, and read what they depend on, only once: all the targets
+    // are then committed together, and share the same dependencies.
+    auto Inlinable = ptml::getInlinableTypes(Model);
+
+    for (const model::UpcastableTypeDefinition &T : Model.TypeDefinitions()) {
+      const model::TypeDefinition &Type = *T;
+      if (not Requested.contains(toString(Type.key())))
+        continue;
+
       std::string &Result = ModelTypesContainer[Type.key()];
       llvm::raw_string_ostream Out(Result);
 
@@ -51,10 +72,12 @@ public:
                            { .EnablePrintingOfTheMaximumEnumValue = true,
                              .EnableExplicitPaddingMode = false,
                              .EnableStructSizeAnnotation = true });
-      B.collectInlinableTypes(Model);
+      B.collectInlinableTypes(Inlinable);
 
       B.printTypeDefinition(Type);
     }
+
+    EC.commitAllFor(ModelTypesContainer);
   }
 };
 
@@ -1182,7 +1182,10 @@ bool DeclVisitor::VisitEnumDecl(const EnumDecl *D) {
 }
 
 void DeclVisitor::run(clang::TranslationUnitDecl *TUD) {
-  this->TraverseDecl(TUD);
+  // Only the declarations coming from the user's code are of interest, so
+  // don't load the ones coming from the precompiled model header, if any.
+  for (clang::Decl *D : TUD->noload_decls())
+    this->TraverseDecl(D);
 }
 
 bool DeclVisitor::TraverseDecl(clang::Decl *D) {
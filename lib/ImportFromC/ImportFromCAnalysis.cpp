@@ -6,16 +6,23 @@
 //
 
 #include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
 #include <string>
 #include <tuple>
 #include <vector>
 
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ToolOutputFile.h"
 
 #include "clang/Driver/Driver.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendAction.h"
+#include "clang/Frontend/FrontendActions.h"
 #include "clang/Lex/PreprocessorOptions.h"
 #include "clang/StaticAnalyzer/Frontend/FrontendActions.h"
 #include "clang/Tooling/CommonOptionsParser.h"
@@ -38,6 +45,7 @@
 #include "HeaderToModel.h"
 #include "ImportFromCAnalysis.h"
 #include "ImportFromCHelpers.h"
+#include "ModelEdit.h"
 
 using namespace llvm;
 using namespace clang;
@@ -75,215 +83,347 @@ static std::optional<std::string> findHeaderFile(const std::string &File) {
 
 static Logger<> Log("header-to-model-errors");
 
-struct ImportFromCAnalysis {
-  static constexpr auto Name = "import-from-c";
+static cl::opt<unsigned> CachedHeaders("import-from-c-cached-headers",
+                                       cl::desc("Number of precompiled model "
+                                                "headers to keep around for "
+                                                "import-from-c, 0 disables "
+                                                "them"),
+                                       cl::init(4));
 
-  constexpr static std::tuple Options = { pipeline::Option("location-to-edit",
-                                                           ""),
-                                          pipeline::Option("ccode", "") };
+/// What the filtered model header depends on, besides the model
+struct HeaderFilter {
+  std::set<model::TypeDefinition::Key> TypesToOmit;
+  std::set<MetaAddress> FunctionsToOmit;
+  std::string PostIncludeSnippet;
 
-  std::vector<std::vector<pipeline::Kind *>> AcceptedKinds = {};
+  bool operator==(const HeaderFilter &) const = default;
+};
 
-  llvm::Error run(pipeline::ExecutionContext &EC,
-                  std::string LocationToEdit,
-                  std::string CCode) {
-    enum ImportFromCOption TheOption;
-    auto &Model = revng::getWritableModelFromContext(EC);
+/// A model header printed to a file, along with its precompiled version, if
+/// clang managed to build one, and what it has been printed from
+struct ModelHeader {
+  TupleTree<model::Binary> Model;
+  HeaderFilter Filter;
+  std::vector<std::string> Compilation;
+  TemporaryFile Header;
+  std::optional<TemporaryFile> PCH;
+};
 
-    // This will be used iff {Edit|Add}TypeFeature is used.
-    model::TypeDefinition *TypeToEdit = nullptr;
+/// Build a precompiled header out of \p HeaderPath, in \p PCHPath
+static bool generatePCH(llvm::StringRef HeaderPath,
+                        llvm::StringRef PCHPath,
+                        const std::vector<std::string> &Compilation) {
+  std::vector<std::string> CommandLine = { "clang-tool" };
+  llvm::append_range(CommandLine, Compilation);
+  CommandLine.push_back("-xc-header");
+  CommandLine.push_back(HeaderPath.str());
+  CommandLine.push_back("-o");
+  CommandLine.push_back(PCHPath.str());
+
+  // Errors in the header will show up again when parsing the user's code
+  IgnoringDiagConsumer IgnoreDiagnostics;
+  IntrusiveRefCntPtr<FileManager> Files(new FileManager(FileSystemOptions()));
+  ToolInvocation Invocation(std::move(CommandLine),
+                            std::make_unique<GeneratePCHAction>(),
+                            Files.get());
+  Invocation.setDiagnosticConsumer(&IgnoreDiagnostics);
+  return Invocation.run();
+}
 
-    // This will be used iff EditFunctionPrototypeFeature is used.
-    model::Function *FunctionToEdit = nullptr;
+/// Print the model header of \p Model, filtered by \p Filter, to a file and,
+/// if \p Precompile is set, try to build a precompiled header out of it
+static llvm::ErrorOr<std::shared_ptr<const ModelHeader>>
+makeModelHeader(const TupleTree<model::Binary> &Model,
+                const HeaderFilter &Filter,
+                const std::vector<std::string> &Compilation,
+                bool Precompile) {
+  auto MaybeHeader = TemporaryFile::make("filtered-model-header-ptml", "h");
+  if (not MaybeHeader)
+    return MaybeHeader.getError();
+
+  {
+    std::error_code ErrorCode;
+    llvm::raw_fd_ostream Out(MaybeHeader->path(), ErrorCode);
+    if (ErrorCode)
+      return ErrorCode;
+
+    ptml::CTypeBuilder B(Out,
+                         /* EnableTaglessMode = */ true,
+                         { .EnableTypeInlining = false,
+                           .EnableStackFrameInlining = false,
+                           .TypesToOmit = Filter.TypesToOmit });
+    ptml::HeaderBuilder(B,
+                        { .PostIncludeSnippet = Filter.PostIncludeSnippet,
+                          .FunctionsToOmit = Filter.FunctionsToOmit })
+      .printModelHeader(*Model);
+  }
 
-    namespace RRanks = revng::ranks;
-    if (LocationToEdit.empty()) {
-      // This is the default option of the analysis.
-      TheOption = ImportFromCOption::AddType;
-    } else {
-      if (auto L = pipeline::locationFromString(revng::ranks::Function,
-                                                LocationToEdit)) {
-        auto [Key] = L->at(revng::ranks::Function);
-        auto Iterator = Model->Functions().find(Key);
-        if (Iterator == Model->Functions().end()) {
-          return llvm::createStringError(llvm::inconvertibleErrorCode(),
-                                         "Couldn't find the function "
-                                           + LocationToEdit);
-        }
-
-        FunctionToEdit = &*Iterator;
-        TheOption = ImportFromCOption::EditFunctionPrototype;
-      } else if (auto L = pipeline::locationFromString(RRanks::TypeDefinition,
-                                                       LocationToEdit)) {
-        auto [Key, Kind] = L->at(revng::ranks::TypeDefinition);
-        auto Iterator = Model->TypeDefinitions().find({ Key, Kind });
-        if (Iterator == Model->TypeDefinitions().end()) {
-          return llvm::createStringError(llvm::inconvertibleErrorCode(),
-                                         "Couldn't find the type "
-                                           + LocationToEdit);
-        }
-
-        TypeToEdit = Iterator->get();
-        TheOption = ImportFromCOption::EditType;
-      } else {
-        return llvm::createStringError(llvm::inconvertibleErrorCode(),
-                                       "Invalid location");
-      }
-    }
+  std::optional<TemporaryFile> PCH;
+  if (Precompile) {
+    auto MaybePCH = TemporaryFile::make("filtered-model-header-ptml", "pch");
+    if (MaybePCH
+        and generatePCH(MaybeHeader->path(), MaybePCH->path(), Compilation))
+      PCH = std::move(*MaybePCH);
+  }
 
-    auto MaybeFilterModelPath = TemporaryFile::make("filtered-model-header-"
-                                                    "ptml",
-                                                    "h");
-    if (!MaybeFilterModelPath) {
-      std::error_code EC = MaybeFilterModelPath.getError();
-      return llvm::createStringError(EC,
-                                     "Couldn't create temporary file: "
-                                       + EC.message());
-    }
+  return std::make_shared<const ModelHeader>(ModelHeader{
+    Model,
+    Filter,
+    Compilation,
+    std::move(*MaybeHeader),
+    std::move(PCH),
+  });
+}
 
-    TemporaryFile &FilterModelPath = MaybeFilterModelPath.get();
-    std::error_code ErrorCode;
-    llvm::raw_fd_ostream Out(FilterModelPath.path(), ErrorCode);
-    if (ErrorCode) {
-      return llvm::createStringError(ErrorCode,
-                                     "Couldn't open file for "
-                                     "filtered-model-header-ptml.h: "
-                                       + ErrorCode.message());
+/// Get a file containing the model header of \p Model, filtered by \p Filter,
+/// and a precompiled header for it, if possible.
+///
+/// Editing a type multiple times leads to the same filtered header, since the
+/// type and the ones depending on it are omitted from it. The most recently
+/// used headers are kept around, along with the model they have been printed
+/// from, so that from then on clang only has to parse the user's code.
+/// Whether a header can be reused is checked by comparing the models, which
+/// is much cheaper than printing the header again. The precompiled header is
+/// built right away, and it is used by the first import too.
+static llvm::ErrorOr<std::shared_ptr<const ModelHeader>>
+getModelHeader(const TupleTree<model::Binary> &Model,
+               const HeaderFilter &Filter,
+               const std::vector<std::string> &Compilation) {
+  static std::mutex Mutex;
+  static std::list<std::shared_ptr<const ModelHeader>> Cache;
+
+  std::lock_guard Lock(Mutex);
+  for (auto It = Cache.begin(); It != Cache.end(); ++It) {
+    const ModelHeader &Entry = **It;
+    if (Entry.Filter == Filter and Entry.Compilation == Compilation
+        and diff(*Entry.Model, *Model).Changes.empty()) {
+      Cache.splice(Cache.begin(), Cache, It);
+      return Cache.front();
     }
+  }
 
-    ptml::CTypeBuilder::ConfigurationOptions Configuration = {
-      .EnableTypeInlining = false, .EnableStackFrameInlining = false
-    };
-    ptml::HeaderBuilder::ConfigurationOptions HeaderConfiguration = {};
-    if (TheOption == ImportFromCOption::EditType) {
-      // For all the types other than functions and typedefs, generate forward
-      // declarations.
-      if (!ptml::CTypeBuilder::isDeclarationTheSameAsDefinition(*TypeToEdit)) {
-        llvm::raw_string_ostream Stream(HeaderConfiguration.PostIncludeSnippet);
-        ptml::CTypeBuilder PI(Stream, /* GenerateTaglessPTML = */ true);
-        PI.appendLineComment("The type we are editing");
-        // The declaration of this type will be near the top of the file.
-        PI.printForwardTypeDeclaration(*TypeToEdit);
-        PI.append("\n");
-      }
+  auto MaybeHeader = makeModelHeader(Model,
+                                     Filter,
+                                     Compilation,
+                                     /* Precompile = */ CachedHeaders > 0);
+  if (MaybeHeader and CachedHeaders > 0) {
+    Cache.push_front(*MaybeHeader);
+    while (Cache.size() > CachedHeaders)
+      Cache.pop_back();
+  }
 
-      // Find all types whose definition depends on the type we are editing.
-      Configuration.TypesToOmit = collectDependentTypes(*TypeToEdit, Model);
+  return MaybeHeader;
+}
 
-    } else if (TheOption == ImportFromCOption::EditFunctionPrototype) {
-      HeaderConfiguration.FunctionsToOmit.insert(FunctionToEdit->Entry());
+llvm::Error importFromC(TupleTree<model::Binary> &Model,
+                        const std::string &LocationToEdit,
+                        const std::string &CCode) {
+  enum ImportFromCOption TheOption;
+
+  // This will be used iff {Edit|Add}TypeFeature is used.
+  model::TypeDefinition *TypeToEdit = nullptr;
+
+  // This will be used iff EditFunctionPrototypeFeature is used.
+  model::Function *FunctionToEdit = nullptr;
+
+  namespace RRanks = revng::ranks;
+  if (LocationToEdit.empty()) {
+    // This is the default option of the analysis.
+    TheOption = ImportFromCOption::AddType;
+  } else {
+    if (auto L = pipeline::locationFromString(revng::ranks::Function,
+                                              LocationToEdit)) {
+      auto [Key] = L->at(revng::ranks::Function);
+      auto Iterator = Model->Functions().find(Key);
+      if (Iterator == Model->Functions().end()) {
+        return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                       "Couldn't find the function "
+                                         + LocationToEdit);
+      }
 
-    } else if (TheOption == ImportFromCOption::AddType) {
-      // Nothing special to do when adding types
+      FunctionToEdit = &*Iterator;
+      TheOption = ImportFromCOption::EditFunctionPrototype;
+    } else if (auto L = pipeline::locationFromString(RRanks::TypeDefinition,
+                                                     LocationToEdit)) {
+      auto [Key, Kind] = L->at(revng::ranks::TypeDefinition);
+      auto Iterator = Model->TypeDefinitions().find({ Key, Kind });
+      if (Iterator == Model->TypeDefinitions().end()) {
+        return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                       "Couldn't find the type "
+                                         + LocationToEdit);
+      }
 
+      TypeToEdit = Iterator->get();
+      TheOption = ImportFromCOption::EditType;
     } else {
-      revng_abort("Unknown action requested.");
+      return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                     "Invalid location");
     }
+  }
 
-    {
-      ptml::CTypeBuilder B(Out,
-                           /* EnableTaglessMode = */ true,
-                           std::move(Configuration));
-      ptml::HeaderBuilder(B, std::move(HeaderConfiguration))
-        .printModelHeader(*Model);
+  HeaderFilter Filter;
+  std::set<model::TypeDefinition::Key> DependentTypes;
+  if (TheOption == ImportFromCOption::EditType) {
+    // For all the types other than functions and typedefs, generate forward
+    // declarations.
+    if (!ptml::CTypeBuilder::isDeclarationTheSameAsDefinition(*TypeToEdit)) {
+      llvm::raw_string_ostream Stream(Filter.PostIncludeSnippet);
+      ptml::CTypeBuilder PI(Stream, /* GenerateTaglessPTML = */ true);
+      PI.appendLineComment("The type we are editing");
+      // The declaration of this type will be near the top of the file.
+      PI.printForwardTypeDeclaration(*TypeToEdit);
+      PI.append("\n");
     }
 
-    Out.close();
-
-    std::string FilteredHeader = std::string("#include \"")
-                                 + FilterModelPath.path().str()
-                                 + std::string("\"");
-    TupleTree<model::Binary> OutModel(Model);
-
-    ImportingErrorList Errors;
-    std::unique_ptr<HeaderToModelAction> Action;
-
-    if (TheOption == ImportFromCOption::EditType) {
-      revng_assert(TypeToEdit != nullptr);
-      Action = std::make_unique<HeaderToModelEditTypeAction>(OutModel,
-                                                             Errors,
-                                                             TypeToEdit->key());
-    } else if (TheOption == ImportFromCOption::EditFunctionPrototype) {
-      revng_assert(FunctionToEdit != nullptr);
-      using EditFunctionPrototype = HeaderToModelEditFunctionAction;
-      Action = std::make_unique<EditFunctionPrototype>(OutModel,
-                                                       Errors,
-                                                       FunctionToEdit->Entry());
-    } else {
-      Action = std::make_unique<HeaderToModelAddTypeAction>(OutModel, Errors);
-    }
+    // Find all types whose definition depends on the type we are editing.
+    DependentTypes = collectDependentTypes(*TypeToEdit, Model);
+    Filter.TypesToOmit = DependentTypes;
 
-    // Find compile flags to be applied to clang.
-    StringRef CompileFlagsPath = "share/revng-c/compile-flags.cfg";
-    auto MaybeCompileCFGPath = revng::ResourceFinder.findFile(CompileFlagsPath);
-    if (not MaybeCompileCFGPath) {
-      return llvm::createStringError(llvm::inconvertibleErrorCode(),
-                                     "Couldn't find compile-flags.cfg");
-    }
+  } else if (TheOption == ImportFromCOption::EditFunctionPrototype) {
+    Filter.FunctionsToOmit.insert(FunctionToEdit->Entry());
 
-    // Since the `--config` is just a clang Driver option, we need to parse it
-    // manually.
-    auto FromCFGFile = getOptionsFromCFGFile(*MaybeCompileCFGPath);
-    std::vector<std::string> Compilation(FromCFGFile);
-    Compilation.push_back("-xc");
-
-    SmallString<16> CompilerHeadersPath;
-    {
-      StringRef LLVMLibrary = getLibrariesFullPath().at("libLLVMSupport");
-      using namespace llvm::sys::path;
-      SmallString<16> ClangPath;
-      append(ClangPath, parent_path(parent_path(LLVMLibrary)));
-      append(ClangPath, Twine("bin"));
-      append(ClangPath, Twine("clang"));
-      CompilerHeadersPath = clang::driver::Driver::GetResourcesPath(ClangPath);
-      append(CompilerHeadersPath, Twine("include"));
-    }
-    Compilation.push_back("-I" + CompilerHeadersPath.str().str());
+  } else if (TheOption == ImportFromCOption::AddType) {
+    // Nothing special to do when adding types
 
-    // Find primitive-types.h and attributes.h.
-    const char *PrimitivesHeader = "share/revng-c/include/"
-                                   "primitive-types.h";
-    auto MaybePrimitiveHeaderPath = findHeaderFile(PrimitivesHeader);
-    if (not MaybePrimitiveHeaderPath) {
-      return llvm::createStringError(llvm::inconvertibleErrorCode(),
-                                     "Couldn't find primitive-types.h");
-    }
-    Compilation.push_back("-I" + *MaybePrimitiveHeaderPath);
+  } else {
+    revng_abort("Unknown action requested.");
+  }
 
-    FilteredHeader += "\n";
-    FilteredHeader += CCode;
+  ImportingErrorList Errors;
+  std::unique_ptr<HeaderToModelAction> Action;
+
+  // Instead of importing into a copy of the model, import directly into it
+  // and undo the changes in case of failure.
+  ModelEdit Edit(Model);
+
+  if (TheOption == ImportFromCOption::EditType) {
+    revng_assert(TypeToEdit != nullptr);
+    Edit.editType(*TypeToEdit, std::move(DependentTypes));
+    Action = std::make_unique<HeaderToModelEditTypeAction>(Model,
+                                                           Errors,
+                                                           TypeToEdit->key());
+  } else if (TheOption == ImportFromCOption::EditFunctionPrototype) {
+    revng_assert(FunctionToEdit != nullptr);
+    Edit.editFunction(*FunctionToEdit);
+    using EditFunctionPrototype = HeaderToModelEditFunctionAction;
+    Action = std::make_unique<EditFunctionPrototype>(Model,
+                                                     Errors,
+                                                     FunctionToEdit->Entry());
+  } else {
+    Action = std::make_unique<HeaderToModelAddTypeAction>(Model, Errors);
+  }
 
-    if (not clang::tooling::runToolOnCodeWithArgs(std::move(Action),
-                                                  FilteredHeader,
-                                                  Compilation,
-                                                  InputCFile)) {
-      return llvm::createStringError(llvm::inconvertibleErrorCode(),
-                                     "Unable to run clang");
-    }
+  // Find compile flags to be applied to clang.
+  StringRef CompileFlagsPath = "share/revng-c/compile-flags.cfg";
+  auto MaybeCompileCFGPath = revng::ResourceFinder.findFile(CompileFlagsPath);
+  if (not MaybeCompileCFGPath) {
+    return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                   "Couldn't find compile-flags.cfg");
+  }
 
-    // Check if an error was reported by clang or revng during parsing of C
-    // code.
-    if (not Errors.empty()) {
-      std::string Result;
-      for (auto &Error : Errors)
-        Result += std::move(Error);
+  // Since the `--config` is just a clang Driver option, we need to parse it
+  // manually.
+  auto FromCFGFile = getOptionsFromCFGFile(*MaybeCompileCFGPath);
+  std::vector<std::string> Compilation(FromCFGFile);
+
+  SmallString<16> CompilerHeadersPath;
+  {
+    StringRef LLVMLibrary = getLibrariesFullPath().at("libLLVMSupport");
+    using namespace llvm::sys::path;
+    SmallString<16> ClangPath;
+    append(ClangPath, parent_path(parent_path(LLVMLibrary)));
+    append(ClangPath, Twine("bin"));
+    append(ClangPath, Twine("clang"));
+    CompilerHeadersPath = clang::driver::Driver::GetResourcesPath(ClangPath);
+    append(CompilerHeadersPath, Twine("include"));
+  }
+  Compilation.push_back("-I" + CompilerHeadersPath.str().str());
+
+  // Find primitive-types.h and attributes.h.
+  const char *PrimitivesHeader = "share/revng-c/include/"
+                                 "primitive-types.h";
+  auto MaybePrimitiveHeaderPath = findHeaderFile(PrimitivesHeader);
+  if (not MaybePrimitiveHeaderPath) {
+    return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                   "Couldn't find primitive-types.h");
+  }
+  Compilation.push_back("-I" + *MaybePrimitiveHeaderPath);
+
+  // The model is only edited by the action, once clang runs, so the header is
+  // printed from the model the user's code has been written against
+  auto MaybeModelHeader = getModelHeader(Model, Filter, Compilation);
+  if (not MaybeModelHeader) {
+    std::error_code ErrorCode = MaybeModelHeader.getError();
+    return llvm::createStringError(ErrorCode,
+                                   "Couldn't create the model header: "
+                                     + ErrorCode.message());
+  }
 
-      revng_log(Log, Result.c_str());
-      return llvm::createStringError(llvm::inconvertibleErrorCode(),
-                                     std::move(Result));
-    }
+  // The model header starts with `#pragma once`, therefore, if it has been
+  // precompiled, the `#include` directive does not parse it again.
+  const ModelHeader &TheModelHeader = **MaybeModelHeader;
+  if (TheModelHeader.PCH) {
+    Compilation.push_back("-include-pch");
+    Compilation.push_back(TheModelHeader.PCH->path().str());
+  }
+  Compilation.push_back("-xc");
+
+  std::string FilteredHeader = std::string("#include \"")
+                               + TheModelHeader.Header.path().str()
+                               + std::string("\"");
+  FilteredHeader += "\n";
+  FilteredHeader += CCode;
+
+  if (not clang::tooling::runToolOnCodeWithArgs(std::move(Action),
+                                                FilteredHeader,
+                                                Compilation,
+                                                InputCFile)) {
+    Edit.rollback();
+    return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                   "Unable to run clang");
+  }
 
-    model::VerifyHelper VH(false);
-    if (not OutModel->verify(VH)) {
-      return llvm::createStringError(llvm::inconvertibleErrorCode(),
-                                     "New model does not verify: "
-                                       + VH.getReason());
-    }
+  // Check if an error was reported by clang or revng during parsing of C
+  // code.
+  if (not Errors.empty()) {
+    std::string Result;
+    for (auto &Error : Errors)
+      Result += std::move(Error);
+
+    revng_log(Log, Result.c_str());
+    Edit.rollback();
+    return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                   std::move(Result));
+  }
+
+  model::VerifyHelper VH(false);
+  if (not Edit.verify(VH)) {
+    Edit.rollback();
+    return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                   "New model does not verify: "
+                                     + VH.getReason());
+  }
+
+  if (VerifyLog.isEnabled())
+    revng_assert(Model->verify(true));
+
+  return llvm::Error::success();
+}
+
+struct ImportFromCAnalysis {
+  static constexpr auto Name = "import-from-c";
 
-    // Replace the original Model with the OutModel that contains the changes.
-    Model = OutModel;
+  constexpr static std::tuple Options = { pipeline::Option("location-to-edit",
+                                                           ""),
+                                          pipeline::Option("ccode", "") };
+
+  std::vector<std::vector<pipeline::Kind *>> AcceptedKinds = {};
 
-    return llvm::Error::success();
+  llvm::Error run(pipeline::ExecutionContext &EC,
+                  std::string LocationToEdit,
+                  std::string CCode) {
+    auto &Model = revng::getWritableModelFromContext(EC);
+    return importFromC(Model, LocationToEdit, CCode);
   }
 };
 
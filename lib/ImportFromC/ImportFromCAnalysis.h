@@ -3,6 +3,13 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <string>
+
+#include "llvm/Support/Error.h"
+
+#include "revng/Model/Binary.h"
+#include "revng/TupleTree/TupleTree.h"
+
 namespace {
 enum class ImportFromCOption {
   EditType,
@@ -10,3 +17,11 @@ enum class ImportFromCOption {
   AddType
 };
 } // namespace
+
+/// Import \p CCode into \p Model: edit the type or the function prototype at
+/// \p LocationToEdit or, if it's empty, add the types it defines.
+///
+/// \note on failure, \p Model is left untouched.
+llvm::Error importFromC(TupleTree<model::Binary> &Model,
+                        const std::string &LocationToEdit,
+                        const std::string &CCode);
@@ -0,0 +1,140 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <algorithm>
+#include <optional>
+#include <set>
+#include <vector>
+
+#include "llvm/ADT/SmallVector.h"
+
+#include "revng/Model/Binary.h"
+#include "revng/Model/VerifyHelper.h"
+#include "revng/TupleTree/TupleTree.h"
+
+/// The model is edited in place: this remembers what is needed to restore it
+/// if the user's code cannot be imported, and which parts of it need to be
+/// verified after the edit.
+class ModelEdit {
+  using Key = model::TypeDefinition::Key;
+
+  TupleTree<model::Binary> &Model;
+
+  // The keys of all the types before the edit, sorted
+  std::vector<Key> OriginalKeys;
+
+  // The type being edited and the types depending on it, if any
+  std::optional<model::UpcastableTypeDefinition> OriginalType;
+  std::set<Key> DependentTypes;
+
+  // The function whose prototype is being edited, if any
+  std::optional<model::Function> OriginalFunction;
+
+public:
+  explicit ModelEdit(TupleTree<model::Binary> &Model) : Model(Model) {
+    OriginalKeys.reserve(Model->TypeDefinitions().size());
+    for (const model::UpcastableTypeDefinition &T : Model->TypeDefinitions())
+      OriginalKeys.push_back(T->key());
+  }
+
+  void editType(const model::TypeDefinition &Type,
+                std::set<Key> &&Dependent) {
+    OriginalType = Model->TypeDefinitions().at(Type.key());
+    DependentTypes = std::move(Dependent);
+  }
+
+  void editFunction(const model::Function &Function) {
+    OriginalFunction = Function;
+  }
+
+  /// Verify the types that have been added or edited, the ones depending on
+  /// them, the edited function, and everything else in the model referring
+  /// to any of those types, instead of the whole model
+  bool verify(model::VerifyHelper &VH) const {
+    // If the edited type changed kind, and therefore key, anything could be
+    // referring to the old one
+    if (OriginalType
+        and not Model->TypeDefinitions().tryGet((*OriginalType)->key()))
+      return Model->verify(VH);
+
+    std::set<Key> Touched = DependentTypes;
+    if (OriginalType)
+      Touched.insert((*OriginalType)->key());
+
+    for (const model::UpcastableTypeDefinition &T : Model->TypeDefinitions()) {
+      if (isNew(T->key()))
+        Touched.insert(T->key());
+
+      if (Touched.contains(T->key()))
+        if (not T->verify(VH))
+          return false;
+    }
+
+    const auto IsTouched = [&Touched](const model::UpcastableType &Type) {
+      if (Type.isEmpty())
+        return false;
+
+      const model::TypeDefinition *Definition = Type->skipToDefinition();
+      return Definition != nullptr and Touched.contains(Definition->key());
+    };
+
+    // The default prototype is checked against the rest of the binary
+    if (IsTouched(Model->DefaultPrototype()))
+      return Model->verify(VH);
+
+    for (const model::Function &Function : Model->Functions()) {
+      bool IsEdited = OriginalFunction
+                      and OriginalFunction->Entry() == Function.Entry();
+      if (IsEdited or IsTouched(Function.Prototype())
+          or IsTouched(Function.StackFrameType()))
+        if (not Function.verify(VH))
+          return false;
+    }
+
+    for (const model::DynamicFunction &Function :
+         Model->ImportedDynamicFunctions())
+      if (IsTouched(Function.Prototype()))
+        if (not Function.verify(VH))
+          return false;
+
+    for (const model::Segment &Segment : Model->Segments())
+      if (IsTouched(Segment.Type()))
+        if (not Segment.verify(VH))
+          return false;
+
+    return true;
+  }
+
+  /// Undo the edit
+  void rollback() {
+    llvm::SmallVector<Key, 4> NewKeys;
+    for (const model::UpcastableTypeDefinition &T : Model->TypeDefinitions())
+      if (isNew(T->key()))
+        NewKeys.push_back(T->key());
+
+    for (const Key &NewKey : NewKeys)
+      Model->TypeDefinitions().erase(NewKey);
+
+    if (OriginalType) {
+      Model->TypeDefinitions().erase((*OriginalType)->key());
+      Model->TypeDefinitions().insert(std::move(*OriginalType));
+      OriginalType.reset();
+    }
+
+    if (OriginalFunction) {
+      const MetaAddress Entry = OriginalFunction->Entry();
+      Model->Functions().at(Entry) = std::move(*OriginalFunction);
+      OriginalFunction.reset();
+    }
+  }
+
+private:
+  bool isNew(const Key &TypeKey) const {
+    return not std::binary_search(OriginalKeys.begin(),
+                                  OriginalKeys.end(),
+                                  TypeKey);
+  }
+};
@@ -152,13 +152,14 @@ static RecursiveCoroutine<bool> addOperandType(const llvm::Value *Operand,
 /// special rules apply to recover the returned type.
 static TypeVector getReturnTypes(const llvm::CallInst *Call,
                                  const model::Function *ParentFunc,
-                                 const model::Binary &Model,
+                                 ModelTypeTable &Types,
                                  const ModelTypesMap &TypeMap) {
+  const model::Binary &Model = Types.getModel();
   if (Call->getType()->isVoidTy())
     return {};
 
   // Check if we already have strong model information for this call
-  TypeVector ReturnTypes = getStrongModelInfo(Call, Model);
+  TypeVector ReturnTypes = getStrongModelInfo(Call, Types);
   if (not ReturnTypes.empty())
     return ReturnTypes;
 
@@ -235,11 +236,11 @@ static TypeVector getReturnTypes(const llvm::CallInst *Call,
 /// one type, infect the uses of the returned value with those types.
 static void handleCallInstruction(const llvm::CallInst *Call,
                                   const model::Function *ParentFunc,
-                                  const model::Binary &Model,
+                                  ModelTypeTable &Types,
                                   ModelTypesMap &TypeMap,
                                   bool PointersOnly) {
 
-  TypeVector ReturnedTypes = getReturnTypes(Call, ParentFunc, Model, TypeMap);
+  TypeVector ReturnedTypes = getReturnTypes(Call, ParentFunc, Types, TypeMap);
   if (ReturnedTypes.empty())
     return;
 
@@ -416,11 +417,12 @@ static RecursiveCoroutine<std::optional<model::UpcastableType>>
 initModelTypesImpl(const llvm::Instruction &I,
                    const llvm::Function &F,
                    const model::Function *ModelF,
-                   const model::Binary &Model,
+                   ModelTypeTable &Types,
                    bool PointersOnly,
                    ModelTypesMap &TypeMap,
                    llvm::SmallPtrSet<const llvm::PHINode *, 8>
                      VisitedPHIs = {}) {
+  const model::Binary &Model = Types.getModel();
 
   const auto *InstType = I.getType();
 
@@ -457,7 +459,7 @@ initModelTypesImpl(const llvm::Instruction &I,
   // the binary or to special intrinsics used by the backend, so they need
   // to be handled separately
   if (auto *Call = dyn_cast<llvm::CallInst>(&I)) {
-    handleCallInstruction(Call, ModelF, Model, TypeMap, PointersOnly);
+    handleCallInstruction(Call, ModelF, Types, TypeMap, PointersOnly);
     auto CallTypeIt = TypeMap.find(Call);
     if (CallTypeIt != TypeMap.end())
       rc_return CallTypeIt->second.copy();
@@ -588,7 +590,7 @@ initModelTypesImpl(const llvm::Instruction &I,
           IncomingType = rc_recur initModelTypesImpl(*IncomingInst,
                                                      F,
                                                      ModelF,
-                                                     Model,
+                                                     Types,
                                                      PointersOnly,
                                                      TypeMap,
                                                      VisitedPHIs);
@@ -626,6 +628,7 @@ initModelTypesImpl(const llvm::Function &F,
                      VisitedPHIs = {}) {
 
   ModelTypesMap TypeMap;
+  ModelTypeTable Types(Model);
 
   const auto *Prototype = Model.prototypeOrDefault(ModelF->prototype());
   auto Layout = abi::FunctionType::Layout::make(*Prototype);
@@ -637,7 +640,7 @@ initModelTypesImpl(const llvm::Function &F,
         initModelTypesImpl(I,
                            F,
                            ModelF,
-                           Model,
+                           Types,
                            PointersOnly,
                            TypeMap,
                            VisitedPHIs);
@@ -0,0 +1,114 @@
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Support/CommandLine.h"
+
+#include "revng/Model/IRHelpers.h"
+#include "revng/Model/LoadModelPass.h"
+#include "revng/Support/Assert.h"
+
+#include "revng-c/InitModelTypes/InitModelTypes.h"
+#include "revng-c/InitModelTypes/ModelTypesAnalysis.h"
+
+static llvm::cl::opt<bool> VerifyModelTypes("verify-model-types",
+                                            llvm::cl::desc("Check that the "
+                                                           "model types kept "
+                                                           "after erasing "
+                                                           "values match a "
+                                                           "full "
+                                                           "recomputation."),
+                                            llvm::cl::init(false));
+
+using ModelTypesMap = ModelTypesWrapperPass::ModelTypesMap;
+
+/// Check that the types of the instructions in \p Updated match the ones
+/// computed from scratch.
+static void verifyUpdatedTypes(const ModelTypesMap &Updated,
+                               const llvm::Function &F,
+                               const model::Function *ModelF,
+                               const model::Binary &Model,
+                               bool PointersOnly) {
+  ModelTypesMap Expected = initModelTypes(F, ModelF, Model, PointersOnly);
+  for (const llvm::Instruction &I : llvm::instructions(F)) {
+    auto ExpectedIt = Expected.find(&I);
+    auto UpdatedIt = Updated.find(&I);
+    bool HasExpected = ExpectedIt != Expected.end();
+    revng_assert(HasExpected == (UpdatedIt != Updated.end()));
+    if (HasExpected)
+      revng_assert(*ExpectedIt->second == *UpdatedIt->second);
+  }
+}
+
+bool ModelTypesWrapperPass::runOnFunction(llvm::Function &F) {
+  releaseMemory();
+
+  const auto &Wrapper = getAnalysis<LoadModelWrapperPass>().get();
+  Model = &*Wrapper.getReadOnlyModel();
+  this->F = &F;
+  ModelF = llvmToModelFunction(*Model, F);
+  revng_assert(ModelF != nullptr);
+
+  return false;
+}
+
+void ModelTypesWrapperPass::getAnalysisUsage(llvm::AnalysisUsage &AU) const {
+  AU.setPreservesAll();
+  AU.addRequired<LoadModelWrapperPass>();
+}
+
+void ModelTypesWrapperPass::releaseMemory() {
+  F = nullptr;
+  ModelF = nullptr;
+  Model = nullptr;
+  Updated = false;
+  AllTypes.reset();
+  PointerTypes.reset();
+}
+
+const ModelTypesMap &ModelTypesWrapperPass::getTypes() {
+  revng_assert(F != nullptr);
+  if (not AllTypes)
+    AllTypes = initModelTypes(*F, ModelF, *Model, false);
+  else if (VerifyModelTypes and Updated)
+    verifyUpdatedTypes(*AllTypes, *F, ModelF, *Model, false);
+  return *AllTypes;
+}
+
+const ModelTypesMap &ModelTypesWrapperPass::getPointerTypes() {
+  revng_assert(F != nullptr);
+  if (not PointerTypes)
+    PointerTypes = initModelTypes(*F, ModelF, *Model, true);
+  else if (VerifyModelTypes and Updated)
+    verifyUpdatedTypes(*PointerTypes, *F, ModelF, *Model, true);
+  return *PointerTypes;
+}
+
+void ModelTypesWrapperPass::forget(const llvm::Value *V) {
+  Updated = true;
+  if (AllTypes)
+    AllTypes->erase(V);
+  if (PointerTypes)
+    PointerTypes->erase(V);
+}
+
+void ModelTypesWrapperPass::update(const llvm::Instruction &I) {
+  revng_assert(I.getFunction() == F);
+
+  // The type of a PHI depends on all of its transitive incomings, and on the
+  // order in which PHIs are first visited, so a change can't be propagated
+  // locally and still match a full recomputation. Drop the maps, and
+  // recompute them the next time they are requested.
+  AllTypes.reset();
+  PointerTypes.reset();
+  Updated = false;
+}
+
+char ModelTypesWrapperPass::ID = 0;
+
+using Register = llvm::RegisterPass<ModelTypesWrapperPass>;
+static Register X("model-types",
+                  "Cache the model types of LLVM values",
+                  /* CFGOnly */ false,
+                  /* IsAnalysis */ true);
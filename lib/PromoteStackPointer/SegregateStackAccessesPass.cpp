@@ -13,7 +13,6 @@
 #include "revng/ABI/FunctionType/Layout.h"
 #include "revng/BasicAnalyses/GeneratedCodeBasicInfo.h"
 #include "revng/MFP/MFP.h"
-#include "revng/MFP/SetLattices.h"
 #include "revng/Model/IRHelpers.h"
 #include "revng/Model/LoadModelPass.h"
 #include "revng/Model/VerifyHelper.h"
@@ -31,6 +30,7 @@
 #include "revng-c/Support/ModelHelpers.h"
 
 #include "Helpers.h"
+#include "StoredBytesLattice.h"
 
 using namespace llvm;
 
@@ -103,20 +103,6 @@ static std::optional<int64_t> getStackOffset(Instruction *I) {
   return {};
 }
 
-struct StoredByte {
-  int64_t StackOffset = 0;
-  llvm::StoreInst *Store = nullptr;
-  unsigned StoreOffset = 0;
-
-  bool operator<(const StoredByte &Other) const {
-    auto ThisTuple = std::tie(StackOffset, Store, StoreOffset);
-    auto OtherTuple = std::tie(Other.StackOffset,
-                               Other.Store,
-                               Other.StoreOffset);
-    return ThisTuple < OtherTuple;
-  }
-};
-
 class StackAccessRedirector {
 private:
   using Span = abi::FunctionType::Layout::Argument::StackSpan;
@@ -194,14 +180,25 @@ public:
   void dump() const debug_function { dump(dbg); }
 };
 
-using Lattice = std::set<StoredByte>;
+using StoredBytes = StoredBytesLattice<llvm::StoreInst>;
 
-struct SegregateStackAccessesMFI : public SetUnionLattice<Lattice> {
+struct SegregateStackAccessesMFI {
   using Label = llvm::BasicBlock *;
   using GraphType = llvm::Function *;
+  using LatticeElement = StoredBytes;
+
+  LatticeElement combineValues(const LatticeElement &LHS,
+                               const LatticeElement &RHS) const {
+    return StoredBytes::combine(LHS, RHS);
+  }
+
+  bool isLessOrEqual(const LatticeElement &LHS,
+                     const LatticeElement &RHS) const {
+    return StoredBytes::isLessOrEqual(LHS, RHS);
+  }
 
-  static LatticeElement applyTransferFunction(llvm::BasicBlock *BB,
-                                              const LatticeElement &Value) {
+  LatticeElement applyTransferFunction(llvm::BasicBlock *BB,
+                                       const LatticeElement &Value) const {
     using namespace llvm;
     revng_log(Log, "Analyzing block " << getName(BB));
     LoggerIndent<> Indent(Log);
@@ -231,14 +228,11 @@ struct SegregateStackAccessesMFI : public SetUnionLattice<Lattice> {
       int64_t EndStackOffset = StartStackOffset + AccessSize;
 
       // Erase all the existing entries
-      // TODO: use lower_bound instead of scanning everything
-      StackBytes.erase(StackBytes.lower_bound(StoredByte{ StartStackOffset }),
-                       StackBytes.upper_bound(StoredByte{ EndStackOffset }));
+      StackBytes.erase(StartStackOffset, EndStackOffset);
 
       // If it's a store, record all of its bytes
-      if (auto *Store = dyn_cast<StoreInst>(&I))
-        for (unsigned I = 0; I < AccessSize; ++I)
-          StackBytes.insert({ StartStackOffset + I, Store, I });
+      if (auto *Store = dyn_cast<StoreInst>(&I); Store and AccessSize > 0)
+        StackBytes.insert(StartStackOffset, EndStackOffset, Store);
     }
 
     return StackBytes;
@@ -254,8 +248,7 @@ struct SortByFunction {
 
 class SegregateStackAccesses : public pipeline::FunctionPassImpl {
 private:
-  using MFIResult = std::map<BasicBlock *,
-                             MFP::MFPResult<std::set<StoredByte>>>;
+  using MFIResult = std::map<BasicBlock *, MFP::MFPResult<StoredBytes>>;
 
 private:
   const model::Binary &Binary;
@@ -1282,12 +1275,13 @@ private:
     };
     std::map<StoreInst *, StoreInfo> Stores;
     BasicBlock *BB = SSACSCall->getParent();
-    const std::set<StoredByte> &BlockFinalResult = AnalysisResult.at(BB)
-                                                     .OutValue;
-    for (const StoredByte &Byte : BlockFinalResult) {
-      StoreInfo &Info = Stores[Byte.Store];
-      Info.Count += 1;
-      Info.Offset = Byte.StackOffset - Byte.StoreOffset;
+    const StoredBytes &BlockFinalResult = AnalysisResult.at(BB).OutValue;
+    for (const auto &[Start, Interval] : BlockFinalResult) {
+      for (const auto &[Store, StoreOffset] : Interval.Writers) {
+        StoreInfo &Info = Stores[Store];
+        Info.Count += Interval.End - Start;
+        Info.Offset = Start - StoreOffset;
+      }
     }
 
     // Process MarkedStores
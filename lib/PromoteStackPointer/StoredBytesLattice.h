@@ -0,0 +1,292 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <algorithm>
+#include <compare>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include "revng/Support/Assert.h"
+
+/// The set of stack bytes that might have been written by a store, along with
+/// the stores that might have written them.
+///
+/// Semantically, this is a set of (stack offset, store, offset in the store)
+/// triples, one per byte. However, bytes are grouped in disjoint intervals of
+/// stack offsets written by the same stores, so that, for instance, a store of
+/// N bytes takes a single node instead of N.
+///
+/// Copies share the underlying map, which is cloned only when a copy that is
+/// not the only owner is modified.
+template<typename StoreT>
+class StoredBytesLattice {
+public:
+  struct Writer {
+    StoreT *Store = nullptr;
+    /// Offset, within the store, of the first byte of the interval
+    uint64_t StoreOffset = 0;
+
+    Writer shift(uint64_t Delta) const {
+      return { Store, StoreOffset + Delta };
+    }
+
+    bool operator==(const Writer &) const = default;
+    std::strong_ordering operator<=>(const Writer &) const = default;
+  };
+
+  /// Sorted and without duplicates
+  using WriterSet = llvm::SmallVector<Writer, 1>;
+
+  struct Interval {
+    int64_t End = 0;
+    WriterSet Writers;
+
+    bool operator==(const Interval &) const = default;
+  };
+
+  /// Maps the first stack offset of each interval to the interval
+  using IntervalMap = std::map<int64_t, Interval>;
+
+private:
+  std::shared_ptr<IntervalMap> Intervals;
+
+public:
+  bool empty() const { return not Intervals or Intervals->empty(); }
+
+  void clear() { Intervals.reset(); }
+
+  size_t intervalsCount() const { return Intervals ? Intervals->size() : 0; }
+
+  auto begin() const { return map().begin(); }
+  auto end() const { return map().end(); }
+
+  bool operator==(const StoredBytesLattice &Other) const {
+    return Intervals == Other.Intervals or map() == Other.map();
+  }
+
+public:
+  /// Forget all the bytes in [Start, End)
+  void erase(int64_t Start, int64_t End) {
+    if (not overlaps(Start, End))
+      return;
+
+    IntervalMap &Map = mutate();
+    split(Map, Start);
+    split(Map, End);
+    Map.erase(Map.lower_bound(Start), Map.lower_bound(End));
+  }
+
+  /// Record that \p Store writes [Start, End), which must not be covered by
+  /// any other interval
+  void insert(int64_t Start, int64_t End, StoreT *Store) {
+    revng_assert(Start < End);
+    revng_assert(not overlaps(Start, End));
+
+    IntervalMap &Map = mutate();
+    Interval New{ End, { Writer{ Store, 0 } } };
+    auto It = Map.emplace(Start, std::move(New)).first;
+    coalesce(Map, It);
+  }
+
+public:
+  /// The union of \p LHS and \p RHS
+  static StoredBytesLattice combine(const StoredBytesLattice &LHS,
+                                    const StoredBytesLattice &RHS) {
+    if (LHS.Intervals == RHS.Intervals or RHS.empty())
+      return LHS;
+    if (LHS.empty())
+      return RHS;
+
+    StoredBytesLattice Result;
+    IntervalMap &Map = Result.mutate();
+    Cursor LHSCursor(*LHS.Intervals);
+    Cursor RHSCursor(*RHS.Intervals);
+    std::vector<int64_t> Points = boundaries(*LHS.Intervals, *RHS.Intervals);
+    for (auto [Start, End] : llvm::zip(Points, llvm::drop_begin(Points))) {
+      WriterSet Writers;
+      LHSCursor.writersAt(Start, Writers);
+      RHSCursor.writersAt(Start, Writers);
+      if (Writers.empty())
+        continue;
+
+      llvm::sort(Writers);
+      Writers.erase(std::unique(Writers.begin(), Writers.end()),
+                    Writers.end());
+
+      auto It = Map.emplace_hint(Map.end(),
+                                 Start,
+                                 Interval{ End, std::move(Writers) });
+      coalesce(Map, It);
+    }
+
+    return Result;
+  }
+
+  /// Is \p LHS a subset of \p RHS?
+  static bool isLessOrEqual(const StoredBytesLattice &LHS,
+                            const StoredBytesLattice &RHS) {
+    if (LHS.Intervals == RHS.Intervals or LHS.empty())
+      return true;
+    if (RHS.empty())
+      return false;
+
+    Cursor LHSCursor(*LHS.Intervals);
+    Cursor RHSCursor(*RHS.Intervals);
+    std::vector<int64_t> Points = boundaries(*LHS.Intervals, *RHS.Intervals);
+    for (int64_t Start : Points) {
+      WriterSet LHSWriters;
+      LHSCursor.writersAt(Start, LHSWriters);
+      if (LHSWriters.empty())
+        continue;
+
+      WriterSet RHSWriters;
+      RHSCursor.writersAt(Start, RHSWriters);
+      if (not std::includes(RHSWriters.begin(),
+                            RHSWriters.end(),
+                            LHSWriters.begin(),
+                            LHSWriters.end()))
+        return false;
+    }
+
+    return true;
+  }
+
+private:
+  const IntervalMap &map() const {
+    static const IntervalMap Empty;
+    return Intervals ? *Intervals : Empty;
+  }
+
+  /// Get a map that can be modified without affecting other copies
+  IntervalMap &mutate() {
+    if (not Intervals)
+      Intervals = std::make_shared<IntervalMap>();
+    else if (Intervals.use_count() > 1)
+      Intervals = std::make_shared<IntervalMap>(*Intervals);
+    return *Intervals;
+  }
+
+  bool overlaps(int64_t Start, int64_t End) const {
+    if (empty() or Start >= End)
+      return false;
+
+    auto It = Intervals->lower_bound(Start);
+    if (It != Intervals->end() and It->first < End)
+      return true;
+
+    return It != Intervals->begin() and std::prev(It)->second.End > Start;
+  }
+
+  /// Make sure that no interval strictly contains \p Offset, splitting the
+  /// one that does, if any
+  static void split(IntervalMap &Map, int64_t Offset) {
+    auto It = Map.upper_bound(Offset);
+    if (It == Map.begin())
+      return;
+
+    --It;
+    int64_t Start = It->first;
+    Interval &Current = It->second;
+    if (Start == Offset or Current.End <= Offset)
+      return;
+
+    uint64_t Delta = Offset - Start;
+    Interval Tail{ Current.End, {} };
+    for (const Writer &W : Current.Writers)
+      Tail.Writers.push_back(W.shift(Delta));
+    Current.End = Offset;
+    Map.emplace_hint(std::next(It), Offset, std::move(Tail));
+  }
+
+  /// Is \p Right the continuation of \p Left, i.e., are they adjacent and is
+  /// each store writing the last byte of \p Left also writing the first byte
+  /// of \p Right?
+  static bool continues(const typename IntervalMap::value_type &Left,
+                        const typename IntervalMap::value_type &Right) {
+    if (Left.second.End != Right.first)
+      return false;
+
+    const WriterSet &LeftWriters = Left.second.Writers;
+    const WriterSet &RightWriters = Right.second.Writers;
+    if (LeftWriters.size() != RightWriters.size())
+      return false;
+
+    uint64_t Size = Left.second.End - Left.first;
+    for (auto [LeftWriter, RightWriter] : llvm::zip(LeftWriters, RightWriters))
+      if (LeftWriter.shift(Size) != RightWriter)
+        return false;
+
+    return true;
+  }
+
+  /// Merge the interval at \p It with its neighbors, if they are the
+  /// continuation of one another, so that equal sets are represented in the
+  /// same way
+  static void coalesce(IntervalMap &Map, typename IntervalMap::iterator It) {
+    auto Next = std::next(It);
+    if (Next != Map.end() and continues(*It, *Next)) {
+      It->second.End = Next->second.End;
+      Map.erase(Next);
+    }
+
+    if (It != Map.begin()) {
+      auto Previous = std::prev(It);
+      if (continues(*Previous, *It)) {
+        Previous->second.End = It->second.End;
+        Map.erase(It);
+      }
+    }
+  }
+
+  /// All the offsets where an interval of \p LHS or \p RHS starts or ends,
+  /// sorted
+  static std::vector<int64_t> boundaries(const IntervalMap &LHS,
+                                         const IntervalMap &RHS) {
+    std::vector<int64_t> Result;
+    Result.reserve(2 * (LHS.size() + RHS.size()));
+    for (const IntervalMap *Map : { &LHS, &RHS }) {
+      for (const auto &[Start, Current] : *Map) {
+        Result.push_back(Start);
+        Result.push_back(Current.End);
+      }
+    }
+
+    llvm::sort(Result);
+    Result.erase(std::unique(Result.begin(), Result.end()), Result.end());
+    return Result;
+  }
+
+  /// Visits the intervals of a map in order, looking for the writers of a
+  /// given offset
+  class Cursor {
+  private:
+    typename IntervalMap::const_iterator It;
+    typename IntervalMap::const_iterator End;
+
+  public:
+    Cursor(const IntervalMap &Map) : It(Map.begin()), End(Map.end()) {}
+
+  public:
+    /// Append to \p Result the writers of \p Offset, shifted accordingly.
+    /// \note \p Offset must not decrease across calls.
+    void writersAt(int64_t Offset, WriterSet &Result) {
+      while (It != End and It->second.End <= Offset)
+        ++It;
+
+      if (It == End or It->first > Offset)
+        return;
+
+      uint64_t Delta = Offset - It->first;
+      for (const Writer &W : It->second.Writers)
+        Result.push_back(W.shift(Delta));
+    }
+  };
+};
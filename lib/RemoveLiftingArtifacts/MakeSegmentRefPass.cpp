@@ -3,7 +3,9 @@
 //
 
 #include <functional>
+#include <map>
 #include <optional>
+#include <vector>
 
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/IR/IRBuilder.h"
@@ -34,26 +36,36 @@
 #include "revng-c/Support/FunctionTags.h"
 #include "revng-c/Support/IRHelpers.h"
 #include "revng-c/Support/ModelHelpers.h"
+#include "revng-c/Support/SegmentIndex.h"
 
 #include "MakeSegmentRefPass.h"
+#include "StringLiteralTable.h"
 
 using namespace llvm;
 
 struct MakeSegmentRefPassImpl : public pipeline::FunctionPassImpl {
 private:
   const model::Binary &Binary;
+  const SegmentIndex Segments;
   llvm::Module &M;
   llvm::LLVMContext &Context;
   OpaqueFunctionsPool<SegmentRefPoolKey> SegmentRefPool;
   OpaqueFunctionsPool<TypePair> AddressOfPool;
   OpaqueFunctionsPool<StringLiteralPoolKey> StringLiteralPool;
 
+  /// The string literals of each segment a constant points into, built on
+  /// first use. std::nullopt if the contents of the segment are not available
+  /// as a whole.
+  std::map<const model::Segment *, std::optional<StringLiteralTable>>
+    StringLiterals;
+
 public:
   MakeSegmentRefPassImpl(llvm::ModulePass &Pass,
                          const model::Binary &Binary,
                          llvm::Module &M) :
     pipeline::FunctionPassImpl(Pass),
     Binary(Binary),
+    Segments(Binary),
     M(M),
     Context(M.getContext()),
     SegmentRefPool(&M, false),
@@ -67,6 +79,11 @@ public:
   bool runOnFunction(const model::Function &ModelFunction,
                      llvm::Function &Function) override;
 
+private:
+  std::optional<llvm::StringRef> getStringLiteral(RawBinaryView &BinaryView,
+                                                  const model::Segment &Segment,
+                                                  uint64_t Offset);
+
 public:
   static void getAnalysisUsage(llvm::AnalysisUsage &AU);
 };
@@ -76,21 +93,6 @@ void MakeSegmentRefPassImpl::getAnalysisUsage(llvm::AnalysisUsage &AU) {
   AU.addRequired<LoadModelWrapperPass>();
 }
 
-static std::optional<std::pair<MetaAddress, uint64_t>>
-findLiteralInSegments(const model::Binary &Binary, uint64_t Literal) {
-  std::optional<std::pair<MetaAddress, uint64_t>> Result = std::nullopt;
-  auto Arch = toLLVMArchitecture(Binary.Architecture());
-
-  for (const auto &Segment : Binary.Segments()) {
-    if (Segment.contains(MetaAddress::fromGeneric(Arch, Literal))) {
-      revng_assert(not Result.has_value());
-      Result = { { Segment.StartAddress(), Segment.VirtualSize() } };
-    }
-  }
-
-  return Result;
-}
-
 static std::optional<llvm::StringRef>
 getStringLiteral(RawBinaryView &BinaryView,
                  MetaAddress SegmentAddress,
@@ -111,23 +113,34 @@ getStringLiteral(RawBinaryView &BinaryView,
   if (not DataOrNone.has_value())
     return std::nullopt;
 
-  llvm::StringRef StringView = DataOrNone.value();
-
-  // If it doesn't end with \0 it's not a string literal
-  auto NullTerminatorPos = StringView.find('\0');
-  if (NullTerminatorPos == llvm::StringLiteral::npos)
-    return std::nullopt;
+  return findStringLiteral(*DataOrNone, 0);
+}
 
-  StringView = StringView.take_front(NullTerminatorPos);
+std::optional<llvm::StringRef>
+MakeSegmentRefPassImpl::getStringLiteral(RawBinaryView &BinaryView,
+                                         const model::Segment &Segment,
+                                         uint64_t Offset) {
+  MetaAddress StartAddress = Segment.StartAddress();
+  uint64_t VirtualSize = Segment.VirtualSize();
+
+  auto [It, New] = StringLiterals.try_emplace(&Segment);
+  if (New) {
+    // Segments which are not read only contain no string literals
+    It->second = StringLiteralTable();
+    if (BinaryView.isReadOnly(StartAddress, VirtualSize)) {
+      auto Data = BinaryView.getStringByAddress(StartAddress, VirtualSize);
+      if (Data.has_value())
+        It->second = StringLiteralTable(*Data);
+      else
+        It->second = std::nullopt;
+    }
+  }
 
-  // If some of the characters are not printable, is not a string literal
-  const auto IsPrintableInCString = [](const char C) {
-    return not llvm::isPrint(C) and not llvm::isSpace(C);
-  };
-  if (llvm::any_of(StringView, IsPrintableInCString))
-    return std::nullopt;
+  if (It->second.has_value())
+    return It->second->get(Offset);
 
-  return StringView;
+  // Only part of the segment is available, look at each string on its own
+  return ::getStringLiteral(BinaryView, StartAddress, VirtualSize, Offset);
 }
 
 bool MakeSegmentRefPassImpl::runOnFunction(const model::Function &ModelFunction,
@@ -159,9 +172,9 @@ bool MakeSegmentRefPassImpl::runOnFunction(const model::Function &ModelFunction,
           and (ConstOp->getBitWidth() == (8 * PointerSize))) {
         uint64_t ConstantAddress = ConstOp->getZExtValue();
 
-        if (auto Segment = findLiteralInSegments(Binary, ConstantAddress);
-            Segment) {
-          const auto &[StartAddress, VirtualSize] = *Segment;
+        if (const model::Segment *Segment = Segments.find(ConstantAddress)) {
+          MetaAddress StartAddress = Segment->StartAddress();
+          uint64_t VirtualSize = Segment->VirtualSize();
           auto OffsetInSegment = ConstantAddress - StartAddress.address();
 
           if (isa<PHINode>(&I)) {
@@ -180,10 +193,9 @@ bool MakeSegmentRefPassImpl::runOnFunction(const model::Function &ModelFunction,
           // Check if the Op is large as a pointer. If it isn't it can't be a
           // string literal.
           // See if we can find a string literal there.
-          auto OptString = getStringLiteral(BinaryView,
-                                            StartAddress,
-                                            VirtualSize,
-                                            OffsetInSegment);
+          std::optional<llvm::StringRef> OptString;
+          if (not UseIsComparison)
+            OptString = getStringLiteral(BinaryView, *Segment, OffsetInSegment);
 
           if (not UseIsComparison and OptString.has_value()) {
             auto Str = OptString.value();
@@ -239,9 +251,7 @@ bool MakeSegmentRefPassImpl::runOnFunction(const model::Function &ModelFunction,
                                                         AddressOfFunctionType,
                                                         "AddressOf");
             Constant *ModelTypeString = nullptr;
-            if (const auto &SegmentType = Binary.Segments()
-                                            .at({ StartAddress, VirtualSize })
-                                            .Type()) {
+            if (const auto &SegmentType = Segment->Type()) {
               ModelTypeString = toLLVMString(SegmentType, M);
             } else {
               auto Byte = model::PrimitiveType::makeGeneric(1);
@@ -0,0 +1,84 @@
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <cstring>
+#include <iterator>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
+
+#include "StringLiteralTable.h"
+
+static bool isPrintableInCString(char C) {
+  return llvm::isPrint(C) or llvm::isSpace(C);
+}
+
+std::optional<llvm::StringRef> findStringLiteral(llvm::StringRef Data,
+                                                 uint64_t Offset) {
+  if (Offset >= Data.size())
+    return std::nullopt;
+
+  llvm::StringRef StringView = Data.drop_front(Offset);
+
+  // If it doesn't end with \0 it's not a string literal
+  auto NullTerminatorPos = StringView.find('\0');
+  if (NullTerminatorPos == llvm::StringRef::npos)
+    return std::nullopt;
+
+  StringView = StringView.take_front(NullTerminatorPos);
+
+  // If some of the characters are not printable, is not a string literal
+  if (not llvm::all_of(StringView, isPrintableInCString))
+    return std::nullopt;
+
+  return StringView;
+}
+
+StringLiteralTable::StringLiteralTable(llvm::StringRef Data) : Data(Data) {
+  const char *Begin = Data.data();
+  const char *End = Begin + Data.size();
+
+  // Look for the terminators with memchr, which is vectorized, and go back
+  // from each of them to the first character which can't be printed. Then
+  // skip the following terminators, so that zero padding takes a single
+  // entry. Each byte is inspected at most once.
+  const char *Start = Begin;
+  while (Start != End) {
+    const void *Found = std::memchr(Start, '\0', End - Start);
+    if (Found == nullptr)
+      break;
+
+    const char *Terminator = static_cast<const char *>(Found);
+    const char *First = Terminator;
+    while (First != Start and isPrintableInCString(First[-1]))
+      --First;
+
+    const char *Last = Terminator;
+    while (Last + 1 != End and Last[1] == '\0')
+      ++Last;
+
+    Strings.push_back({ First - Begin, Last - Begin });
+    Start = Last + 1;
+  }
+}
+
+std::optional<llvm::StringRef>
+StringLiteralTable::get(uint64_t Offset) const {
+  // Find the last string starting at or before Offset
+  auto IsBefore = [](uint64_t Offset, const auto &String) {
+    return Offset < String.first;
+  };
+  auto It = llvm::upper_bound(Strings, Offset, IsBefore);
+  if (It == Strings.begin())
+    return std::nullopt;
+
+  // Offset is in a string if it comes before the last terminator of the run.
+  // If it points to one of the terminators, it's an empty string.
+  const auto &[First, Last] = *std::prev(It);
+  if (Offset > Last)
+    return std::nullopt;
+
+  llvm::StringRef String = Data.slice(Offset, Last);
+  return String.take_front(String.find('\0'));
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+
+/// \return the C string literal starting at \p Offset in \p Data, if any, by
+///         looking for its terminator and checking each of its characters
+std::optional<llvm::StringRef> findStringLiteral(llvm::StringRef Data,
+                                                 uint64_t Offset);
+
+/// The C string literals contained in a read-only segment, found with a single
+/// scan of its contents
+class StringLiteralTable {
+private:
+  llvm::StringRef Data;
+
+  /// For each run of consecutive terminators in Data, the offset of the first
+  /// character of the longest string which can be printed and ends at the
+  /// first terminator, and the offset of the last terminator. Every offset in
+  /// between is the start of a string literal, possibly empty, while a run of
+  /// terminators takes a single entry. Both are sorted.
+  std::vector<std::pair<uint64_t, uint64_t>> Strings;
+
+public:
+  StringLiteralTable() = default;
+  explicit StringLiteralTable(llvm::StringRef Data);
+
+public:
+  /// \return the string literal starting at \p Offset, if any. This is the
+  ///         same as `findStringLiteral(Data, Offset)`.
+  std::optional<llvm::StringRef> get(uint64_t Offset) const;
+};
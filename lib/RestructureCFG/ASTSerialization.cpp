@@ -0,0 +1,682 @@
+/// \file ASTSerialization.cpp
+/// Textual serialization of the GHAST of a function
+///
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/IR/Argument.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instruction.h"
+#include "llvm/Support/Casting.h"
+
+#include "revng/Support/Assert.h"
+
+#include "revng-c/RestructureCFG/ASTNode.h"
+#include "revng-c/RestructureCFG/ASTSerialization.h"
+#include "revng-c/RestructureCFG/ASTTree.h"
+#include "revng-c/RestructureCFG/ExprNode.h"
+
+#include "SimplifyHybridNot.h"
+
+using namespace llvm;
+
+// A serialized AST is a sequence of tokens separated by whitespace:
+//
+//   ghast <version>
+//   flips <count> { <block> <not-kind> }
+//   expressions <count> { <expression> }
+//   nodes <count> { <node> }
+//   root <node>
+//
+// Nodes and expressions refer to each other through their position in the
+// respective lists, and blocks through their position in the function, with
+// `-` standing for `nullptr`. Strings are prefixed by their length and a
+// space, so that they can contain anything.
+
+static constexpr uint64_t Version = 1;
+
+using NotKind = ASTTree::NotKind;
+using ComparisonKind = CompareNode::ComparisonKind;
+using DispatcherKind = ASTNode::DispatcherKind;
+
+static StringRef toString(NotKind Kind) {
+  switch (Kind) {
+  case NotKind::SimpleIR:
+    return "simple-ir";
+  case NotKind::BooleanNot:
+    return "boolean-not";
+  }
+  revng_abort();
+}
+
+static StringRef toString(ComparisonKind Kind) {
+  switch (Kind) {
+  case ComparisonKind::Comparison_Equal:
+    return "eq";
+  case ComparisonKind::Comparison_NotEqual:
+    return "ne";
+  case ComparisonKind::Comparison_NotPresent:
+    return "not-present";
+  }
+  revng_abort();
+}
+
+static StringRef toString(DispatcherKind Kind) {
+  switch (Kind) {
+  case DispatcherKind::DK_NotADispatcher:
+    return "not-a-dispatcher";
+  case DispatcherKind::DK_Entry:
+    return "entry";
+  case DispatcherKind::DK_Exit:
+    return "exit";
+  }
+  revng_abort();
+}
+
+namespace {
+
+class ASTWriter {
+private:
+  ASTTree &AST;
+  const Function &F;
+  raw_ostream &OS;
+
+  DenseMap<const BasicBlock *, unsigned> BlockIndices;
+  DenseMap<const ASTNode *, unsigned> NodeIndices;
+  DenseMap<const ExprNode *, unsigned> ExprIndices;
+
+public:
+  ASTWriter(ASTTree &AST, const Function &F, raw_ostream &OS) :
+    AST(AST), F(F), OS(OS) {
+    for (const BasicBlock &BB : F)
+      BlockIndices.try_emplace(&BB, BlockIndices.size());
+    for (ASTNode *Node : AST.nodes())
+      NodeIndices.try_emplace(Node, NodeIndices.size());
+    for (const ASTTree::expr_unique_ptr &Expr : AST.expressions())
+      ExprIndices.try_emplace(Expr.get(), ExprIndices.size());
+  }
+
+  void write() {
+    OS << "ghast " << Version << "\n";
+
+    OS << "flips " << AST.irFlips().size() << "\n";
+    for (const auto &[BB, Kind] : AST.irFlips()) {
+      writeBlock(BB);
+      OS << " " << toString(Kind) << "\n";
+    }
+
+    OS << "expressions " << ExprIndices.size() << "\n";
+    for (const ASTTree::expr_unique_ptr &Expr : AST.expressions()) {
+      writeExpr(Expr.get());
+      OS << "\n";
+    }
+
+    OS << "nodes " << NodeIndices.size() << "\n";
+    for (ASTNode *Node : AST.nodes()) {
+      writeNode(Node);
+      OS << "\n";
+    }
+
+    OS << "root";
+    writeReference(AST.getRoot());
+    OS << "\n";
+  }
+
+private:
+  void writeBlock(const BasicBlock *BB) {
+    if (BB == nullptr) {
+      OS << " -";
+      return;
+    }
+
+    auto It = BlockIndices.find(BB);
+    revng_assert(It != BlockIndices.end());
+    OS << " " << It->second;
+  }
+
+  void writeReference(const ASTNode *Node) {
+    if (Node == nullptr) {
+      OS << " -";
+      return;
+    }
+
+    auto It = NodeIndices.find(Node);
+    revng_assert(It != NodeIndices.end(), "Node not owned by the AST");
+    OS << " " << It->second;
+  }
+
+  void writeReference(const ExprNode *Expr) {
+    if (Expr == nullptr) {
+      OS << " -";
+      return;
+    }
+
+    auto It = ExprIndices.find(Expr);
+    revng_assert(It != ExprIndices.end(), "Expression not owned by the AST");
+    OS << " " << It->second;
+  }
+
+  void writeString(StringRef String) {
+    OS << " " << String.size() << " " << String;
+  }
+
+  void writeFlag(bool Flag) { OS << (Flag ? " 1" : " 0"); }
+
+  void writeValue(const Value *V) {
+    if (auto *Argument = dyn_cast<llvm::Argument>(V)) {
+      revng_assert(Argument->getParent() == &F);
+      OS << " argument " << Argument->getArgNo();
+    } else if (auto *I = dyn_cast<Instruction>(V)) {
+      const BasicBlock *BB = I->getParent();
+      revng_assert(BB->getParent() == &F);
+      OS << " instruction";
+      writeBlock(BB);
+      OS << " " << std::distance(BB->begin(), I->getIterator());
+    } else {
+      revng_abort("Unexpected value in the AST");
+    }
+  }
+
+  void writeExpr(const ExprNode *Expr) {
+    switch (Expr->getKind()) {
+    case ExprNode::NK_ValueCompare: {
+      auto *Compare = cast<ValueCompareNode>(Expr);
+      OS << "value-compare " << toString(Compare->getComparison()) << " "
+         << Compare->getConstant();
+      writeBlock(Compare->getBasicBlock());
+    } break;
+
+    case ExprNode::NK_LoopStateCompare: {
+      auto *Compare = cast<LoopStateCompareNode>(Expr);
+      OS << "loop-state-compare " << toString(Compare->getComparison()) << " "
+         << Compare->getConstant();
+    } break;
+
+    case ExprNode::NK_Atomic: {
+      OS << "atomic";
+      writeBlock(cast<AtomicNode>(Expr)->getConditionalBasicBlock());
+    } break;
+
+    case ExprNode::NK_Not: {
+      OS << "not";
+      writeReference(cast<NotNode>(Expr)->getNegatedNode());
+    } break;
+
+    case ExprNode::NK_And:
+    case ExprNode::NK_Or: {
+      OS << (Expr->getKind() == ExprNode::NK_And ? "and" : "or");
+      const auto &[LHS, RHS] = cast<BinaryNode>(Expr)->getInternalNodes();
+      writeReference(LHS);
+      writeReference(RHS);
+    } break;
+
+    default:
+      revng_abort();
+    }
+  }
+
+  void writeNode(const ASTNode *Node) {
+    switch (Node->getKind()) {
+    case ASTNode::NK_Code:
+      OS << "code";
+      break;
+    case ASTNode::NK_Break:
+      OS << "break";
+      break;
+    case ASTNode::NK_Continue:
+      OS << "continue";
+      break;
+    case ASTNode::NK_If:
+      OS << "if";
+      break;
+    case ASTNode::NK_Scs:
+      OS << "scs";
+      break;
+    case ASTNode::NK_List:
+      OS << "list";
+      break;
+    case ASTNode::NK_Switch:
+      OS << "switch";
+      break;
+    case ASTNode::NK_SwitchBreak:
+      OS << "switch-break";
+      break;
+    case ASTNode::NK_Set:
+      OS << "set";
+      break;
+    default:
+      revng_abort();
+    }
+
+    writeBlock(Node->getBB());
+    writeString(Node->getNameStr());
+
+    switch (Node->getKind()) {
+    case ASTNode::NK_Code: {
+      writeFlag(cast<CodeNode>(Node)->containsImplicitReturn());
+    } break;
+
+    case ASTNode::NK_Break: {
+      writeFlag(cast<BreakNode>(Node)->breaksFromWithinSwitch());
+    } break;
+
+    case ASTNode::NK_Continue: {
+      auto *Continue = cast<ContinueNode>(Node);
+      writeFlag(Continue->isImplicit());
+      writeReference(Continue->hasComputation() ?
+                       Continue->getComputationIfNode() :
+                       nullptr);
+    } break;
+
+    case ASTNode::NK_If: {
+      auto *If = cast<IfNode>(Node);
+      writeFlag(If->isWeaved());
+      writeReference(If->getCondExpr());
+      writeReference(If->getThen());
+      writeReference(If->getElse());
+    } break;
+
+    case ASTNode::NK_Scs: {
+      auto *Scs = cast<ScsNode>(Node);
+      writeReference(Scs->getBody());
+      if (Scs->isWhileTrue()) {
+        OS << " while-true";
+      } else {
+        OS << (Scs->isWhile() ? " while" : " do-while");
+        writeReference(Scs->getRelatedCondition());
+      }
+    } break;
+
+    case ASTNode::NK_List: {
+      auto *Sequence = cast<SequenceNode>(Node);
+      OS << " " << Sequence->length();
+      for (const ASTNode *Child : Sequence->nodes())
+        writeReference(Child);
+    } break;
+
+    case ASTNode::NK_Switch: {
+      auto *Switch = cast<SwitchNode>(Node);
+      writeFlag(Switch->isWeaved());
+      writeFlag(Switch->needsStateVariable());
+      writeFlag(Switch->needsLoopBreakDispatcher());
+
+      // Dispatchers have no condition
+      if (Switch->getCondition() == nullptr)
+        OS << " dispatcher " << toString(Switch->getDispatcherKind());
+      else
+        writeValue(Switch->getCondition());
+
+      auto Cases = Switch->cases_const_range();
+      OS << " " << std::distance(Cases.begin(), Cases.end());
+      for (const auto &[Labels, Case] : Cases) {
+        OS << " " << Labels.size();
+        for (uint64_t Label : Labels)
+          OS << " " << Label;
+        writeReference(Case);
+      }
+    } break;
+
+    case ASTNode::NK_SwitchBreak: {
+      writeReference(cast<SwitchBreakNode>(Node)->getParentSwitch());
+    } break;
+
+    case ASTNode::NK_Set: {
+      auto *Set = cast<SetNode>(Node);
+      OS << " " << Set->getStateVariableValue() << " "
+         << toString(Set->getDispatcherKind());
+    } break;
+
+    default:
+      revng_abort();
+    }
+  }
+};
+
+class ASTReader {
+private:
+  StringRef Buffer;
+  Function &F;
+  ASTTree &AST;
+
+  std::vector<BasicBlock *> Blocks;
+  std::vector<ASTNode *> Nodes;
+  std::vector<ExprNode *> Exprs;
+
+  /// Actions linking the nodes to the ones they refer to, which can only run
+  /// once all the nodes have been created
+  std::vector<std::function<void()>> Fixups;
+
+public:
+  ASTReader(StringRef Buffer, Function &F, ASTTree &AST) :
+    Buffer(Buffer), F(F), AST(AST) {
+    for (BasicBlock &BB : F)
+      Blocks.push_back(&BB);
+  }
+
+  void read() {
+    expect("ghast");
+    revng_check(readInteger() == Version, "Unsupported GHAST version");
+
+    // Replay the changes on the IR first, since the positions of the
+    // instructions in the rest of the AST refer to the IR after them
+    expect("flips");
+    for (uint64_t I = 0, Count = readInteger(); I < Count; ++I) {
+      BasicBlock *BB = readBlock();
+      revng_check(BB != nullptr, "Malformed GHAST");
+      NotKind Kind = readNotKind();
+      flipIRNot(BB, Kind);
+      AST.addIRFlip(BB, Kind);
+    }
+
+    expect("expressions");
+    uint64_t ExprCount = readInteger();
+    std::vector<std::function<void()>> ExprFixups;
+    for (uint64_t I = 0; I < ExprCount; ++I)
+      Exprs.push_back(readExpr(ExprFixups));
+    for (const std::function<void()> &Fixup : ExprFixups)
+      Fixup();
+
+    expect("nodes");
+    for (uint64_t I = 0, Count = readInteger(); I < Count; ++I)
+      Nodes.push_back(readNode());
+    for (const std::function<void()> &Fixup : Fixups)
+      Fixup();
+
+    expect("root");
+    AST.setRoot(getNode(readReference()));
+
+    revng_check(Buffer.trim().empty(), "Trailing data after the GHAST");
+  }
+
+private:
+  StringRef readToken() {
+    Buffer = Buffer.ltrim();
+    StringRef Token = Buffer.take_until(isSpace);
+    revng_check(not Token.empty(), "Unexpected end of the GHAST");
+    Buffer = Buffer.drop_front(Token.size());
+    return Token;
+  }
+
+  void expect(StringRef Expected) {
+    revng_check(readToken() == Expected, "Malformed GHAST");
+  }
+
+  uint64_t readInteger() {
+    uint64_t Result = 0;
+    bool Failed = readToken().getAsInteger(10, Result);
+    revng_check(not Failed, "Malformed integer in the GHAST");
+    return Result;
+  }
+
+  bool readFlag() {
+    uint64_t Flag = readInteger();
+    revng_check(Flag <= 1, "Malformed flag in the GHAST");
+    return Flag == 1;
+  }
+
+  std::string readString() {
+    uint64_t Size = readInteger();
+    revng_check(Buffer.consume_front(" ") and Buffer.size() >= Size,
+                "Malformed string in the GHAST");
+    std::string Result = Buffer.take_front(Size).str();
+    Buffer = Buffer.drop_front(Size);
+    return Result;
+  }
+
+  std::optional<uint64_t> readReference() {
+    Buffer = Buffer.ltrim();
+    if (Buffer.consume_front("-"))
+      return std::nullopt;
+    return readInteger();
+  }
+
+  BasicBlock *readBlock() {
+    std::optional<uint64_t> Index = readReference();
+    if (not Index)
+      return nullptr;
+
+    revng_check(*Index < Blocks.size(), "Block out of range in the GHAST");
+    return Blocks[*Index];
+  }
+
+  ASTNode *getNode(std::optional<uint64_t> Index) const {
+    if (not Index)
+      return nullptr;
+
+    revng_check(*Index < Nodes.size(), "Node out of range in the GHAST");
+    return Nodes[*Index];
+  }
+
+  ExprNode *getExpr(std::optional<uint64_t> Index) const {
+    if (not Index)
+      return nullptr;
+
+    revng_check(*Index < Exprs.size(), "Expression out of range in the GHAST");
+    return Exprs[*Index];
+  }
+
+  NotKind readNotKind() {
+    auto Kind = StringSwitch<std::optional<NotKind>>(readToken())
+                  .Case("simple-ir", NotKind::SimpleIR)
+                  .Case("boolean-not", NotKind::BooleanNot)
+                  .Default(std::nullopt);
+    revng_check(Kind.has_value(), "Unexpected kind of not in the GHAST");
+    return *Kind;
+  }
+
+  ComparisonKind readComparisonKind() {
+    using CK = ComparisonKind;
+    auto Kind = StringSwitch<std::optional<CK>>(readToken())
+                  .Case("eq", CK::Comparison_Equal)
+                  .Case("ne", CK::Comparison_NotEqual)
+                  .Case("not-present", CK::Comparison_NotPresent)
+                  .Default(std::nullopt);
+    revng_check(Kind.has_value(), "Unexpected comparison in the GHAST");
+    return *Kind;
+  }
+
+  DispatcherKind readDispatcherKind() {
+    using DK = DispatcherKind;
+    auto Kind = StringSwitch<std::optional<DK>>(readToken())
+                  .Case("not-a-dispatcher", DK::DK_NotADispatcher)
+                  .Case("entry", DK::DK_Entry)
+                  .Case("exit", DK::DK_Exit)
+                  .Default(std::nullopt);
+    revng_check(Kind.has_value(), "Unexpected dispatcher kind in the GHAST");
+    return *Kind;
+  }
+
+  Value *readValue() {
+    StringRef Kind = readToken();
+    if (Kind == "argument") {
+      uint64_t Index = readInteger();
+      revng_check(Index < F.arg_size(), "Argument out of range in the GHAST");
+      return F.getArg(Index);
+    }
+
+    revng_check(Kind == "instruction", "Unexpected value in the GHAST");
+    BasicBlock *BB = readBlock();
+    uint64_t Index = readInteger();
+    revng_check(BB != nullptr and Index < BB->size(),
+                "Instruction out of range in the GHAST");
+    return &*std::next(BB->begin(), Index);
+  }
+
+  ExprNode *readExpr(std::vector<std::function<void()>> &ExprFixups) {
+    ASTTree::expr_unique_ptr Expr;
+    StringRef Kind = readToken();
+    if (Kind == "value-compare") {
+      ComparisonKind Comparison = readComparisonKind();
+      uint64_t Constant = readInteger();
+      BasicBlock *BB = readBlock();
+      revng_check(BB != nullptr, "Malformed GHAST");
+      Expr.reset(new ValueCompareNode(Comparison, BB, Constant));
+    } else if (Kind == "loop-state-compare") {
+      ComparisonKind Comparison = readComparisonKind();
+      uint64_t Constant = readInteger();
+      Expr.reset(new LoopStateCompareNode(Comparison, Constant));
+    } else if (Kind == "atomic") {
+      Expr.reset(new AtomicNode(readBlock()));
+    } else if (Kind == "not") {
+      auto *Not = new NotNode(nullptr);
+      Expr.reset(Not);
+      auto Negated = readReference();
+      ExprFixups.push_back([this, Not, Negated]() {
+        Not->setNegatedNode(getExpr(Negated));
+      });
+    } else if (Kind == "and" or Kind == "or") {
+      BinaryNode *Binary = nullptr;
+      if (Kind == "and")
+        Binary = new AndNode(nullptr, nullptr);
+      else
+        Binary = new OrNode(nullptr, nullptr);
+      Expr.reset(Binary);
+      auto LHS = readReference();
+      auto RHS = readReference();
+      ExprFixups.push_back([this, Binary, LHS, RHS]() {
+        Binary->setInternalNodes({ getExpr(LHS), getExpr(RHS) });
+      });
+    } else {
+      revng_abort("Unexpected expression in the GHAST");
+    }
+
+    return AST.addCondExpr(std::move(Expr));
+  }
+
+  ASTNode *readNode() {
+    StringRef Kind = readToken();
+    BasicBlock *BB = readBlock();
+    std::string Name = readString();
+
+    ASTTree::ast_unique_ptr Node;
+    if (Kind == "code") {
+      auto *Code = new CodeNode(Name, BB);
+      Node.reset(Code);
+      if (readFlag())
+        Code->setImplicitReturn();
+    } else if (Kind == "break") {
+      auto *Break = new BreakNode(Name, BB);
+      Node.reset(Break);
+      Break->setBreakFromWithinSwitch(readFlag());
+    } else if (Kind == "continue") {
+      auto *Continue = new ContinueNode(Name, BB);
+      Node.reset(Continue);
+      if (readFlag())
+        Continue->setImplicit();
+      if (auto Computation = readReference()) {
+        Fixups.push_back([this, Continue, Computation]() {
+          auto *If = cast<IfNode>(getNode(Computation));
+          Continue->addComputationIfNode(If);
+        });
+      }
+    } else if (Kind == "if") {
+      bool IsWeaved = readFlag();
+      ExprNode *CondExpr = getExpr(readReference());
+      auto *If = new IfNode(CondExpr, nullptr, nullptr, Name, IsWeaved, BB);
+      Node.reset(If);
+      auto Then = readReference();
+      auto Else = readReference();
+      Fixups.push_back([this, If, Then, Else]() {
+        If->setThen(getNode(Then));
+        If->setElse(getNode(Else));
+      });
+    } else if (Kind == "scs") {
+      auto *Scs = new ScsNode(Name, BB, nullptr);
+      Node.reset(Scs);
+      auto Body = readReference();
+      StringRef LoopType = readToken();
+      std::optional<uint64_t> Condition;
+      if (LoopType != "while-true") {
+        revng_check(LoopType == "while" or LoopType == "do-while",
+                    "Unexpected loop type in the GHAST");
+        Condition = readReference();
+      }
+      Fixups.push_back([this, Scs, Body, LoopType, Condition]() {
+        Scs->setBody(getNode(Body));
+        if (LoopType == "while")
+          Scs->setWhile(cast<IfNode>(getNode(Condition)));
+        else if (LoopType == "do-while")
+          Scs->setDoWhile(cast<IfNode>(getNode(Condition)));
+      });
+    } else if (Kind == "list") {
+      auto *Sequence = SequenceNode::createEmpty(Name);
+      Node.reset(Sequence);
+      std::vector<std::optional<uint64_t>> Children;
+      for (uint64_t I = 0, Count = readInteger(); I < Count; ++I)
+        Children.push_back(readReference());
+      Fixups.push_back([this, Sequence, Children]() {
+        for (std::optional<uint64_t> Child : Children)
+          Sequence->addNode(getNode(Child));
+      });
+    } else if (Kind == "switch") {
+      bool IsWeaved = readFlag();
+      bool NeedsStateVariable = readFlag();
+      bool NeedsLoopBreakDispatcher = readFlag();
+
+      Value *Condition = nullptr;
+      DispatcherKind DKind = DispatcherKind::DK_NotADispatcher;
+      Buffer = Buffer.ltrim();
+      if (Buffer.consume_front("dispatcher"))
+        DKind = readDispatcherKind();
+      else
+        Condition = readValue();
+
+      using Labels = SwitchNode::label_set_t;
+      std::vector<std::pair<Labels, std::optional<uint64_t>>> Cases;
+      for (uint64_t I = 0, Count = readInteger(); I < Count; ++I) {
+        Labels CaseLabels;
+        for (uint64_t J = 0, LabelCount = readInteger(); J < LabelCount; ++J)
+          CaseLabels.insert(readInteger());
+        Cases.push_back({ std::move(CaseLabels), readReference() });
+      }
+
+      auto *Switch = new SwitchNode(Name, BB, Condition, {}, IsWeaved, DKind);
+      Node.reset(Switch);
+      Switch->setNeedsStateVariable(NeedsStateVariable);
+      Switch->setNeedsLoopBreakDispatcher(NeedsLoopBreakDispatcher);
+      Fixups.push_back([this, Switch, Cases = std::move(Cases)]() {
+        for (const auto &[CaseLabels, Case] : Cases)
+          Switch->cases().push_back({ CaseLabels, getNode(Case) });
+      });
+    } else if (Kind == "switch-break") {
+      auto *SwitchBreak = new SwitchBreakNode(nullptr);
+      Node.reset(SwitchBreak);
+      auto Parent = readReference();
+      Fixups.push_back([this, SwitchBreak, Parent]() {
+        SwitchBreak->setParentSwitch(cast<SwitchNode>(getNode(Parent)));
+      });
+    } else if (Kind == "set") {
+      uint64_t StateVariableValue = readInteger();
+      DispatcherKind DKind = readDispatcherKind();
+      Node.reset(new SetNode(Name, BB, StateVariableValue, DKind));
+    } else {
+      revng_abort("Unexpected node in the GHAST");
+    }
+
+    return AST.addASTNode(std::move(Node));
+  }
+};
+
+} // namespace
+
+void serializeAST(ASTTree &AST, const Function &F, raw_ostream &OS) {
+  ASTWriter(AST, F, OS).write();
+}
+
+ASTTree deserializeAST(StringRef Buffer, Function &F) {
+  ASTTree AST;
+  ASTReader(Buffer, F, AST).read();
+  return AST;
+}
@@ -17,13 +17,6 @@ using namespace llvm;
 using ASTNodeMap = std::map<ASTNode *, ASTNode *>;
 using ExprNodeMap = std::map<ExprNode *, ExprNode *>;
 
-// Helper to obtain a unique incremental counter (to give name to sequence
-// nodes).
-static int Counter = 1;
-static std::string getID() {
-  return std::to_string(Counter++);
-}
-
 SwitchBreakNode *ASTTree::addSwitchBreak(SwitchNode *SN) {
   ASTNodeList.emplace_back(new SwitchBreakNode(SN));
   ASTNodeList.back()->setID(getNewID());
@@ -31,7 +24,8 @@ SwitchBreakNode *ASTTree::addSwitchBreak(SwitchNode *SN) {
 }
 
 SequenceNode *ASTTree::addSequenceNode() {
-  ASTNodeList.emplace_back(SequenceNode::createEmpty("sequence " + getID()));
+  std::string Name = "sequence " + std::to_string(SequenceCounter++);
+  ASTNodeList.emplace_back(SequenceNode::createEmpty(Name));
 
   // Set the Node ID
   ASTNodeList.back()->setID(getNewID());
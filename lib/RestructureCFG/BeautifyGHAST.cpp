@@ -23,6 +23,7 @@
 #include "revng-c/RestructureCFG/ExprNode.h"
 #include "revng-c/RestructureCFG/GenerateAst.h"
 #include "revng-c/RestructureCFG/RegionCFGTree.h"
+#include "revng-c/RestructureCFG/RestructureContext.h"
 #include "revng-c/Support/DecompilationHelpers.h"
 
 #include "FallThroughScopeAnalysis.h"
@@ -75,10 +76,6 @@ openFunctionFile(const StringRef DirectoryPath,
   return FileOStream;
 }
 
-// Metrics counter variables
-static unsigned ShortCircuitCounter = 0;
-static unsigned TrivialShortCircuitCounter = 0;
-
 static RecursiveCoroutine<bool> hasSideEffects(ExprNode *Expr) {
   switch (Expr->getKind()) {
 
@@ -132,19 +129,21 @@ static bool hasSideEffects(IfNode *If) {
 using UniqueExpr = ASTTree::expr_unique_ptr;
 
 // Helper function to simplify short-circuit IFs
-static void simplifyShortCircuit(ASTNode *RootNode, ASTTree &AST) {
+static void simplifyShortCircuit(ASTNode *RootNode,
+                                 ASTTree &AST,
+                                 RestructureContext &Context) {
 
   if (auto *Sequence = llvm::dyn_cast<SequenceNode>(RootNode)) {
     for (ASTNode *Node : Sequence->nodes()) {
-      simplifyShortCircuit(Node, AST);
+      simplifyShortCircuit(Node, AST, Context);
     }
 
   } else if (auto *Scs = llvm::dyn_cast<ScsNode>(RootNode)) {
-    simplifyShortCircuit(Scs->getBody(), AST);
+    simplifyShortCircuit(Scs->getBody(), AST, Context);
   } else if (auto *Switch = llvm::dyn_cast<SwitchNode>(RootNode)) {
 
     for (auto &LabelCasePair : Switch->cases())
-      simplifyShortCircuit(LabelCasePair.second, AST);
+      simplifyShortCircuit(LabelCasePair.second, AST, Context);
 
   } else if (auto *If = llvm::dyn_cast<IfNode>(RootNode)) {
     if (If->hasBothBranches()) {
@@ -180,10 +179,10 @@ static void simplifyShortCircuit(ASTNode *RootNode, ASTTree &AST) {
             If->replaceCondExpr(AAndNotBNode);
 
             // Increment counter
-            ShortCircuitCounter += 1;
+            Context.ShortCircuits += 1;
 
             // Recursive call.
-            simplifyShortCircuit(If, AST);
+            simplifyShortCircuit(If, AST, Context);
           }
         }
 
@@ -215,9 +214,9 @@ static void simplifyShortCircuit(ASTNode *RootNode, ASTTree &AST) {
             If->replaceCondExpr(AAndBNode);
 
             // Increment counter
-            ShortCircuitCounter += 1;
+            Context.ShortCircuits += 1;
 
-            simplifyShortCircuit(If, AST);
+            simplifyShortCircuit(If, AST, Context);
           }
         }
       }
@@ -256,9 +255,9 @@ static void simplifyShortCircuit(ASTNode *RootNode, ASTTree &AST) {
             If->replaceCondExpr(NotAAndNotBNode);
 
             // Increment counter
-            ShortCircuitCounter += 1;
+            Context.ShortCircuits += 1;
 
-            simplifyShortCircuit(If, AST);
+            simplifyShortCircuit(If, AST, Context);
           }
         }
 
@@ -289,33 +288,35 @@ static void simplifyShortCircuit(ASTNode *RootNode, ASTTree &AST) {
             If->replaceCondExpr(NotAAndBNode);
 
             // Increment counter
-            ShortCircuitCounter += 1;
+            Context.ShortCircuits += 1;
 
-            simplifyShortCircuit(If, AST);
+            simplifyShortCircuit(If, AST, Context);
           }
         }
       }
     }
 
     if (If->hasThen())
-      simplifyShortCircuit(If->getThen(), AST);
+      simplifyShortCircuit(If->getThen(), AST, Context);
     if (If->hasElse())
-      simplifyShortCircuit(If->getElse(), AST);
+      simplifyShortCircuit(If->getElse(), AST, Context);
   }
 }
 
-static void simplifyTrivialShortCircuit(ASTNode *RootNode, ASTTree &AST) {
+static void simplifyTrivialShortCircuit(ASTNode *RootNode,
+                                        ASTTree &AST,
+                                        RestructureContext &Context) {
   if (auto *Sequence = llvm::dyn_cast<SequenceNode>(RootNode)) {
     for (ASTNode *Node : Sequence->nodes()) {
-      simplifyTrivialShortCircuit(Node, AST);
+      simplifyTrivialShortCircuit(Node, AST, Context);
     }
   } else if (auto *Scs = llvm::dyn_cast<ScsNode>(RootNode)) {
-    simplifyTrivialShortCircuit(Scs->getBody(), AST);
+    simplifyTrivialShortCircuit(Scs->getBody(), AST, Context);
 
   } else if (auto *Switch = llvm::dyn_cast<SwitchNode>(RootNode)) {
 
     for (auto &LabelCasePair : Switch->cases())
-      simplifyTrivialShortCircuit(LabelCasePair.second, AST);
+      simplifyTrivialShortCircuit(LabelCasePair.second, AST, Context);
 
   } else if (auto *If = llvm::dyn_cast<IfNode>(RootNode)) {
     if (!If->hasElse()) {
@@ -344,17 +345,17 @@ static void simplifyTrivialShortCircuit(ASTNode *RootNode, ASTTree &AST) {
           If->replaceCondExpr(AAndBNode);
 
           // Increment counter
-          TrivialShortCircuitCounter += 1;
+          Context.TrivialShortCircuits += 1;
 
-          simplifyTrivialShortCircuit(RootNode, AST);
+          simplifyTrivialShortCircuit(RootNode, AST, Context);
         }
       }
     }
 
     if (If->hasThen())
-      simplifyTrivialShortCircuit(If->getThen(), AST);
+      simplifyTrivialShortCircuit(If->getThen(), AST, Context);
     if (If->hasElse())
-      simplifyTrivialShortCircuit(If->getElse(), AST);
+      simplifyTrivialShortCircuit(If->getElse(), AST, Context);
   }
 }
 
@@ -962,7 +963,10 @@ static ASTNode *promoteNoFallthroughIf(const model::Binary &Model,
   return RootNode;
 }
 
-void beautifyAST(const model::Binary &Model, Function &F, ASTTree &CombedAST) {
+void beautifyAST(const model::Binary &Model,
+                 Function &F,
+                 ASTTree &CombedAST,
+                 RestructureContext &Context) {
 
   // If the --short-circuit-metrics-output-dir=dir argument was passed from
   // command line, we need to print the statistics for the short circuit metrics
@@ -971,8 +975,8 @@ void beautifyAST(const model::Binary &Model, Function &F, ASTTree &CombedAST) {
   if (OutputPath.getNumOccurrences())
     StatsFileStream = openFunctionFile(OutputPath, F.getName(), ".csv");
 
-  ShortCircuitCounter = 0;
-  TrivialShortCircuitCounter = 0;
+  Context.ShortCircuits = 0;
+  Context.TrivialShortCircuits = 0;
 
   ASTNode *RootNode = CombedAST.getRoot();
 
@@ -983,7 +987,7 @@ void beautifyAST(const model::Binary &Model, Function &F, ASTTree &CombedAST) {
 
   // Simplify short-circuit nodes.
   revng_log(BeautifyLogger, "Performing short-circuit simplification\n");
-  simplifyShortCircuit(RootNode, CombedAST);
+  simplifyShortCircuit(RootNode, CombedAST, Context);
   Dumper.log("after-short-circuit");
 
   // Flip IFs with empty then branches.
@@ -998,7 +1002,7 @@ void beautifyAST(const model::Binary &Model, Function &F, ASTTree &CombedAST) {
   // Simplify trivial short-circuit nodes.
   revng_log(BeautifyLogger,
             "Performing trivial short-circuit simplification\n");
-  simplifyTrivialShortCircuit(RootNode, CombedAST);
+  simplifyTrivialShortCircuit(RootNode, CombedAST, Context);
   Dumper.log("after-trivial-short-circuit");
 
   // Flip IFs with empty then branches.
@@ -1103,7 +1107,7 @@ void beautifyAST(const model::Binary &Model, Function &F, ASTTree &CombedAST) {
   // Serialize the collected metrics in the statistics file if necessary
   if (StatsFileStream) {
     *StatsFileStream << "function,short-circuit,trivial-short-circuit\n"
-                     << F.getName().data() << "," << ShortCircuitCounter << ","
-                     << TrivialShortCircuitCounter << "\n";
+                     << F.getName().data() << "," << Context.ShortCircuits
+                     << "," << Context.TrivialShortCircuits << "\n";
   }
 }
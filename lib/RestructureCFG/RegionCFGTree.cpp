@@ -9,8 +9,3 @@
 
 // Explicit instantiation for the `RegionCFG` template class.
 template class RegionCFG<llvm::BasicBlock *>;
-
-unsigned DuplicationCounter = 0;
-
-unsigned UntangleTentativeCounter = 0;
-unsigned UntanglePerformedCounter = 0;
@@ -33,6 +33,8 @@
 #include "revng-c/RestructureCFG/RestructureCFG.h"
 #include "revng-c/RestructureCFG/Utils.h"
 
+#include "SimplifySCS.h"
+
 using namespace llvm;
 using namespace llvm::cl;
 
@@ -55,111 +57,6 @@ template class RegionCFG<BasicBlock *>;
 using MetaRegionBB = MetaRegion<BasicBlock *>;
 using MetaRegionBBVect = std::vector<MetaRegionBB>;
 using MetaRegionBBPtrVect = std::vector<MetaRegionBB *>;
-using BackedgeMetaRegionMap = std::map<EdgeDescriptor, MetaRegionBB *>;
-
-static bool mergeSCSStep(MetaRegionBBVect &MetaRegions) {
-  for (auto RegionIt1 = MetaRegions.begin(); RegionIt1 != MetaRegions.end();
-       RegionIt1++) {
-    for (auto RegionIt2 = std::next(RegionIt1); RegionIt2 != MetaRegions.end();
-         RegionIt2++) {
-      bool Intersects = (*RegionIt1).intersectsWith(*RegionIt2);
-      bool IsIncluded = (*RegionIt1).isSubSet(*RegionIt2);
-      bool IsIncludedReverse = (*RegionIt2).isSubSet(*RegionIt1);
-      bool AreEquivalent = (*RegionIt1).nodesEquality(*RegionIt2);
-      if (Intersects
-          and (((!IsIncluded) and (!IsIncludedReverse)) or AreEquivalent)) {
-        (*RegionIt1).mergeWith(*RegionIt2);
-        MetaRegions.erase(RegionIt2);
-        return true;
-      }
-    }
-  }
-
-  return false;
-}
-
-static void simplifySCS(MetaRegionBBVect &MetaRegions) {
-  bool Changes = true;
-  while (Changes) {
-    Changes = mergeSCSStep(MetaRegions);
-  }
-}
-
-static bool
-mergeSCSAbnormalRetreating(MetaRegionBBVect &MetaRegions,
-                           const llvm::SmallDenseSet<EdgeDescriptor> &Backedges,
-                           BackedgeMetaRegionMap &BackedgeMetaRegionMap,
-                           std::set<MetaRegionBB *> &BlacklistedMetaregions) {
-  for (auto RegionIt = MetaRegions.begin(); RegionIt != MetaRegions.end();
-       RegionIt++) {
-    MetaRegionBB &Region = *RegionIt;
-
-    // Do not re-analyze blacklisted metaregions.
-    if (!BlacklistedMetaregions.contains(&Region)) {
-
-      // Iterate over all the backedges present in the graph, if the current
-      // region contains the source of a backedge, it should contain also the
-      // the target of that backedge. If not, merge the two SCSs.
-      for (EdgeDescriptor Backedge : Backedges) {
-        bool FirstIn = Region.containsNode(Backedge.first);
-        bool SecondIn = Region.containsNode(Backedge.second);
-        bool AbnormalIncoming = FirstIn and not SecondIn;
-        bool AbnormalOutgoing = not FirstIn and SecondIn;
-        if (AbnormalIncoming or AbnormalOutgoing) {
-
-          // Retrieve the Metaregion identified by the backedge with goes
-          // goes outside the scope of the current Metaregion.
-          MetaRegionBB *OtherRegion = BackedgeMetaRegionMap.at(Backedge);
-          Region.mergeWith(*OtherRegion);
-
-          // Blacklist the region which we have merged.
-          BackedgeMetaRegionMap[Backedge] = &Region;
-          BlacklistedMetaregions.insert(OtherRegion);
-          return true;
-
-          // Abort if we didn't find the metaregion to remove.
-          revng_abort("Not found the region to merge with.");
-        }
-      }
-    }
-  }
-
-  return false;
-}
-
-static void
-simplifySCSAbnormalRetreating(MetaRegionBBVect &MetaRegions,
-                              const llvm::SmallDenseSet<EdgeDescriptor>
-                                &Backedges) {
-
-  // Temporary map where to store the correspondence between the backedge and
-  // the SCS it gives origin to.
-  // HACK: this should be done at the same time of the metaregion creation.
-  unsigned MetaRegionIndex = 0;
-  std::map<EdgeDescriptor, MetaRegionBB *> BackedgeMetaRegionMap;
-  for (EdgeDescriptor Backedge : Backedges) {
-    BackedgeMetaRegionMap[Backedge] = &MetaRegions.at(MetaRegionIndex);
-    MetaRegionIndex++;
-  }
-
-  std::set<MetaRegionBB *> BlacklistedMetaregions;
-  bool Changes = true;
-  while (Changes) {
-    Changes = mergeSCSAbnormalRetreating(MetaRegions,
-                                         Backedges,
-                                         BackedgeMetaRegionMap,
-                                         BlacklistedMetaregions);
-  }
-
-  // Remove all the metaregion that have been merged with others, using the
-  // erase/remove idiom.
-  MetaRegions.erase(remove_if(MetaRegions.begin(),
-                              MetaRegions.end(),
-                              [&BlacklistedMetaregions](MetaRegionBB &M) {
-                                return BlacklistedMetaregions.count(&M) == 1;
-                              }),
-                    MetaRegions.end());
-}
 
 static void sortMetaRegions(MetaRegionBBVect &MetaRegions) {
   std::sort(MetaRegions.begin(),
@@ -290,27 +187,7 @@ createMetaRegions(const llvm::SmallDenseSet<EdgeDescriptor> &Backedges) {
 
   // Include in the regions found before other possible sub-regions, if an edge
   // which is the target of a backedge is included in an outer region.
-  for (auto &Region : Regions) {
-    BasicBlockNodeBB *Head = Region.first;
-    std::set<BasicBlockNodeBB *> &Nodes = Region.second;
-    std::set<BasicBlockNodeBB *> AdditionalNodes;
-    std::set<BasicBlockNodeBB *> OldNodes;
-    do {
-      OldNodes = Nodes;
-      for (BasicBlockNodeBB *Node : Nodes) {
-        if ((Node != Head) and (AdditionalSCSNodes.contains(Node))) {
-          CombLogger << "Adding additional nodes for region with head: ";
-          CombLogger << Head->getNameStr();
-          CombLogger << " and relative to node: ";
-          CombLogger << Node->getNameStr() << "\n";
-          AdditionalNodes.insert(AdditionalSCSNodes[Node].begin(),
-                                 AdditionalSCSNodes[Node].end());
-        }
-      }
-      Nodes.insert(AdditionalNodes.begin(), AdditionalNodes.end());
-      AdditionalNodes.clear();
-    } while (Nodes != OldNodes);
-  }
+  expandNestedSCSs(Regions, AdditionalSCSNodes);
 
   MetaRegionBBVect MetaRegions;
   int SCSIndex = 1;
@@ -458,13 +335,11 @@ static MetaRegionBB *computePredecessorsParent(MetaRegionBBPtrVect &MetaRegions,
   return mostNestedRegion(PredecessorMetaRegions);
 }
 
-bool restructureCFG(Function &F, ASTTree &AST) {
+bool restructureCFG(Function &F, ASTTree &AST, RestructureContext &Context) {
   revng_log(CombLogger, "restructuring Function: " << F.getName());
   revng_log(CombLogger, "Num basic blocks: " << F.size());
 
-  DuplicationCounter = 0;
-  UntangleTentativeCounter = 0;
-  UntanglePerformedCounter = 0;
+  Context.Combing = CombingStatistics();
 
   // Clear graph object from the previous pass.
   RegionCFG<BasicBlock *> RootCFG;
@@ -518,7 +393,11 @@ bool restructureCFG(Function &F, ASTTree &AST) {
 
   // Simplify SCS if they contain an edge which goes outside the scope of the
   // current region.
-  simplifySCSAbnormalRetreating(MetaRegions, Backedges);
+  // The metaregions have been created in the order in which Backedges is
+  // iterated, which is the order in which they must be handled.
+  std::vector<EdgeDescriptor> OrderedBackedges(Backedges.begin(),
+                                               Backedges.end());
+  simplifySCSAbnormalRetreating(MetaRegions, OrderedBackedges);
   LogMetaRegions(MetaRegions, "Metaregions after first simplification:");
   revng_assert(checkMetaregionConsistency(MetaRegions, Backedges));
 
@@ -1409,6 +1288,11 @@ bool restructureCFG(Function &F, ASTTree &AST) {
   // now is directly the entire AST, since there's no flattening anymore).
   normalize(AST, F);
 
+  // Gather the combing statistics from all the regions.
+  Context.Combing += RootCFG.getStatistics();
+  for (const RegionCFG<BasicBlock *> &Region : Regions)
+    Context.Combing += Region.getStatistics();
+
   // Serialize the collected metrics in the outputfile.
   if (MetricsOutputPath.getNumOccurrences()) {
     // Compute the increase in weight, on the AST
@@ -1457,9 +1341,10 @@ bool restructureCFG(Function &F, ASTTree &AST) {
                                               Output);
     OutputStream << "function,"
                     "duplications,percentage,tuntangle,puntangle,iweight\n";
-    OutputStream << F.getName().data() << "," << DuplicationCounter << ","
-                 << Increase << "," << UntangleTentativeCounter << ","
-                 << UntanglePerformedCounter << "," << InitialWeight << "\n";
+    const CombingStatistics &Combing = Context.Combing;
+    OutputStream << F.getName().data() << "," << Combing.Duplications << ","
+                 << Increase << "," << Combing.UntangleTentative << ","
+                 << Combing.UntanglePerformed << "," << InitialWeight << "\n";
   }
 
   return false;
@@ -173,10 +173,7 @@ populateAssociatedExprMap(ASTTree &AST, ASTNode *Node, BBExprsMap &BBExprs) {
   rc_return;
 }
 
-enum NotKind {
-  SimpleIR,
-  BooleanNot
-};
+using NotKind = ASTTree::NotKind;
 
 using BBSet = llvm::SmallPtrSet<BasicBlock *, 4>;
 
@@ -271,7 +268,7 @@ static void invertPredicate(llvm::Value *Condition) {
   Compare->setPredicate(Compare->getInversePredicate());
 }
 
-static void flipIRNot(BasicBlock *BB, const NotKind &NotKind) {
+void flipIRNot(BasicBlock *BB, const NotKind &NotKind) {
   if (NotKind == NotKind::SimpleIR) {
 
     // Go back up in order to find the comparison instruction and check that is
@@ -340,8 +337,10 @@ static void simplifyHybridNotImpl(ASTTree &AST,
                                   ConsensusMap &ConsensusBB) {
   for (const auto &[BB, NotKind] : ConsensusBB) {
 
-    // Flip the condition on the LLVMIR
+    // Flip the condition on the LLVMIR, and keep track of it, so that it can
+    // be replayed when the AST is deserialized
     flipIRNot(BB, NotKind);
+    AST.addIRFlip(BB, NotKind);
 
     // Flip the condition on the `ExprNode`s
     flipAssociatedExprs(AST, BBExprs, BB);
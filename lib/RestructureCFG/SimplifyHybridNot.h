@@ -4,8 +4,16 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include "revng-c/RestructureCFG/ASTTree.h"
+
 // Forward declarations
+namespace llvm {
+class BasicBlock;
+} // namespace llvm
+
 class ASTNode;
-class ASTTree;
 
 extern ASTNode *simplifyHybridNot(ASTTree &AST, ASTNode *RootNode);
+
+/// Negate the condition of the conditional branch terminating \p BB
+extern void flipIRNot(llvm::BasicBlock *BB, const ASTTree::NotKind &NotKind);
@@ -0,0 +1,282 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <map>
+#include <optional>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/SparseBitVector.h"
+
+#include "revng/Support/Assert.h"
+
+#include "revng-c/RestructureCFG/BasicBlockNode.h"
+#include "revng-c/RestructureCFG/MetaRegion.h"
+
+/// Add to the nodes of each SCS all the nodes of the SCSs whose head it
+/// contains (except for its own head), transitively.
+///
+/// \p HeadSCSNodes maps the head of each SCS to the union of all the SCSs
+/// with that head.
+/// Each head is visited at most once per SCS, instead of recomputing unions of
+/// sets until a fixed point is reached.
+template<class NodeT>
+void expandNestedSCSs(std::vector<std::pair<BasicBlockNode<NodeT> *,
+                                            std::set<BasicBlockNode<NodeT> *>>>
+                        &Regions,
+                      const std::map<BasicBlockNode<NodeT> *,
+                                     std::set<BasicBlockNode<NodeT> *>>
+                        &HeadSCSNodes) {
+  using BBNodeT = BasicBlockNode<NodeT>;
+
+  for (auto &[Head, Nodes] : Regions) {
+    llvm::SmallPtrSet<BBNodeT *, 8> Visited;
+    llvm::SmallVector<BBNodeT *, 8> Worklist;
+    auto Enqueue = [&, Head = Head](BBNodeT *Node) {
+      if (Node != Head and HeadSCSNodes.contains(Node)
+          and Visited.insert(Node).second)
+        Worklist.push_back(Node);
+    };
+
+    for (BBNodeT *Node : Nodes)
+      Enqueue(Node);
+
+    while (not Worklist.empty()) {
+      BBNodeT *NestedHead = Worklist.pop_back_val();
+      for (BBNodeT *Node : HeadSCSNodes.at(NestedHead))
+        if (Nodes.insert(Node).second)
+          Enqueue(Node);
+    }
+  }
+}
+
+/// Merge each SCS containing only one of the two ends of a backedge with the
+/// SCS identified by that backedge.
+///
+/// \p MetaRegions has to contain the SCS of each element of \p Backedges, in
+/// the same order.
+///
+/// The regions are handled in order, and the backedges of each region are
+/// handled in the order of \p Backedges, so that the result is the same as
+/// restarting from the first region after each merge. However, the backedges
+/// leaving or entering each region are kept up to date as nodes are added to
+/// it, instead of being looked for from scratch, and membership is tracked
+/// with a bit vector over the nodes.
+template<class NodeT>
+void simplifySCSAbnormalRetreating(std::vector<MetaRegion<NodeT>> &MetaRegions,
+                                   llvm::ArrayRef<typename BasicBlockNode<
+                                     NodeT>::EdgeDescriptor> Backedges) {
+  using BBNodeT = BasicBlockNode<NodeT>;
+  using MetaRegionT = MetaRegion<NodeT>;
+  revng_assert(MetaRegions.size() == Backedges.size());
+
+  // The region each backedge is currently associated to
+  std::vector<MetaRegionT *> BackedgeRegion;
+  for (MetaRegionT &Region : MetaRegions)
+    BackedgeRegion.push_back(&Region);
+
+  // Give each node a dense index
+  llvm::DenseMap<BBNodeT *, unsigned> NodeIndices;
+  auto GetIndex = [&NodeIndices](BBNodeT *Node) {
+    unsigned NextIndex = NodeIndices.size();
+    return NodeIndices.try_emplace(Node, NextIndex).first->second;
+  };
+
+  for (const MetaRegionT &Region : MetaRegions)
+    for (BBNodeT *Node : Region.nodes())
+      GetIndex(Node);
+
+  std::vector<std::pair<unsigned, unsigned>> BackedgeEnds;
+  for (const auto &[Source, Target] : Backedges)
+    BackedgeEnds.push_back({ GetIndex(Source), GetIndex(Target) });
+
+  // The indices of the backedges starting or ending in each node
+  std::vector<llvm::SmallVector<unsigned, 2>> IncidentBackedges;
+  IncidentBackedges.resize(NodeIndices.size());
+  for (auto &[Index, Ends] : llvm::enumerate(BackedgeEnds)) {
+    IncidentBackedges[Ends.first].push_back(Index);
+    if (Ends.second != Ends.first)
+      IncidentBackedges[Ends.second].push_back(Index);
+  }
+
+  llvm::BitVector Merged(MetaRegions.size());
+  llvm::BitVector Contained(NodeIndices.size());
+  for (size_t RegionIndex = 0; RegionIndex < MetaRegions.size();
+       ++RegionIndex) {
+    // Do not re-analyze metaregions that have been merged into others
+    if (Merged[RegionIndex])
+      continue;
+
+    MetaRegionT &Region = MetaRegions[RegionIndex];
+    Contained.reset();
+    for (BBNodeT *Node : Region.nodes())
+      Contained.set(NodeIndices.lookup(Node));
+
+    // The indices of the backedges with exactly one end in Region
+    std::set<unsigned> Abnormal;
+    for (auto &[Index, Ends] : llvm::enumerate(BackedgeEnds))
+      if (Contained[Ends.first] != Contained[Ends.second])
+        Abnormal.insert(Index);
+
+    while (not Abnormal.empty()) {
+      unsigned Index = *Abnormal.begin();
+
+      // Merge with the metaregion identified by the backedge which goes
+      // outside the scope of the current one
+      MetaRegionT *OtherRegion = BackedgeRegion[Index];
+      revng_assert(OtherRegion != &Region);
+      for (BBNodeT *Node : OtherRegion->nodes()) {
+        unsigned NodeIndex = NodeIndices.lookup(Node);
+        if (Contained[NodeIndex])
+          continue;
+
+        Contained.set(NodeIndex);
+        Region.insertNode(Node);
+        for (unsigned Incident : IncidentBackedges[NodeIndex]) {
+          const auto &[Source, Target] = BackedgeEnds[Incident];
+          if (Contained[Source] != Contained[Target])
+            Abnormal.insert(Incident);
+          else
+            Abnormal.erase(Incident);
+        }
+      }
+
+      BackedgeRegion[Index] = &Region;
+      Merged.set(OtherRegion - MetaRegions.data());
+    }
+  }
+
+  // Remove all the metaregions that have been merged with others
+  std::vector<MetaRegionT> Result;
+  for (auto &[Index, Region] : llvm::enumerate(MetaRegions))
+    if (not Merged[Index])
+      Result.push_back(std::move(Region));
+  MetaRegions = std::move(Result);
+}
+
+/// Merge the SCSs that intersect but are not nested into each other, and the
+/// ones with the same nodes, until no more SCSs can be merged.
+///
+/// The result is the same as repeatedly merging the first pair of regions
+/// (in lexicographic order of their indices) that can be merged, and then
+/// restarting from scratch, as the original quadratic implementation did.
+/// However, after a merge only the pairs involving the region that changed
+/// are reconsidered, the node sets are compared as sparse bit vectors, and only
+/// regions that share at least a node are compared at all.
+template<class NodeT>
+void simplifySCS(std::vector<MetaRegion<NodeT>> &MetaRegions) {
+  using BBNodeT = BasicBlockNode<NodeT>;
+  using MetaRegionT = MetaRegion<NodeT>;
+
+  // Give each node a dense index
+  llvm::DenseMap<BBNodeT *, unsigned> NodeIndices;
+  for (const MetaRegionT &Region : MetaRegions) {
+    for (BBNodeT *Node : Region.nodes()) {
+      unsigned NextIndex = NodeIndices.size();
+      NodeIndices.try_emplace(Node, NextIndex);
+    }
+  }
+
+  // The nodes of each region, and the regions containing each node. The
+  // latter might also contain regions that have been merged into others.
+  size_t RegionCount = MetaRegions.size();
+  std::vector<llvm::SparseBitVector<>> Nodes(RegionCount);
+  std::vector<llvm::SmallVector<unsigned, 4>> Containing(NodeIndices.size());
+  for (auto &[Index, Region] : llvm::enumerate(MetaRegions)) {
+    for (BBNodeT *Node : Region.nodes()) {
+      unsigned NodeIndex = NodeIndices.lookup(Node);
+      Nodes[Index].set(NodeIndex);
+      Containing[NodeIndex].push_back(Index);
+    }
+  }
+
+  llvm::BitVector Alive(RegionCount, true);
+
+  auto CanMerge = [&Nodes](unsigned First, unsigned Second) {
+    const llvm::SparseBitVector<> &FirstNodes = Nodes[First];
+    const llvm::SparseBitVector<> &SecondNodes = Nodes[Second];
+    if (not FirstNodes.intersects(SecondNodes))
+      return false;
+
+    if (FirstNodes == SecondNodes)
+      return true;
+
+    bool IsIncluded = SecondNodes.contains(FirstNodes);
+    bool IsIncludedReverse = FirstNodes.contains(SecondNodes);
+    return not IsIncluded and not IsIncludedReverse;
+  };
+
+  // Find the first region that can be merged with \p Index, among the alive
+  // ones after it, or before it
+  auto FindMergeable = [&](unsigned Index,
+                           bool After) -> std::optional<unsigned> {
+    llvm::SmallVector<unsigned, 8> Candidates;
+    for (unsigned NodeIndex : Nodes[Index])
+      for (unsigned Other : Containing[NodeIndex])
+        if (Alive[Other] and (After ? Other > Index : Other < Index))
+          Candidates.push_back(Other);
+
+    llvm::sort(Candidates);
+    Candidates.erase(std::unique(Candidates.begin(), Candidates.end()),
+                     Candidates.end());
+    for (unsigned Other : Candidates)
+      if (CanMerge(Index, Other))
+        return Other;
+
+    return std::nullopt;
+  };
+
+  // Merge the region \p From into \p Into, and drop \p From
+  auto Merge = [&](unsigned Into, unsigned From) {
+    MetaRegions[Into].mergeWith(MetaRegions[From]);
+    for (unsigned NodeIndex : Nodes[From]) {
+      if (not Nodes[Into].test(NodeIndex)) {
+        Nodes[Into].set(NodeIndex);
+        Containing[NodeIndex].push_back(Into);
+      }
+    }
+    Alive.reset(From);
+  };
+
+  // Invariant: no pair of alive regions whose first element comes before
+  // Index can be merged
+  unsigned Index = 0;
+  while (Index < RegionCount) {
+    if (not Alive[Index]) {
+      ++Index;
+      continue;
+    }
+
+    std::optional<unsigned> Other = FindMergeable(Index, /* After */ true);
+    if (not Other) {
+      ++Index;
+      continue;
+    }
+
+    Merge(Index, *Other);
+
+    // Only the region at Index changed, so the first pair that can be merged
+    // now is either made of an earlier region and this one, or it's in the
+    // row of this one
+    while (auto Earlier = FindMergeable(Index, /* After */ false)) {
+      Merge(*Earlier, Index);
+      Index = *Earlier;
+    }
+  }
+
+  std::vector<MetaRegionT> Result;
+  for (auto &[RegionIndex, Region] : llvm::enumerate(MetaRegions))
+    if (Alive[RegionIndex])
+      Result.push_back(std::move(Region));
+  MetaRegions = std::move(Result);
+}
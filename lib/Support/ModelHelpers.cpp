@@ -140,6 +140,18 @@ llvm::Constant *toLLVMString(const model::UpcastableType &Type,
   return getUniqueString(&M, toString(Type));
 }
 
+unsigned ModelTypeTable::getHandle(llvm::Value *V) {
+  // Different constant expressions pointing to the same string share the
+  // handle.
+  const llvm::Value *Key = V->stripPointerCasts();
+
+  auto [It, New] = Handles.try_emplace(Key, Types.size());
+  if (New)
+    Types.push_back(fromLLVMString(V, Model));
+
+  return It->second;
+}
+
 static const model::Type &getFieldType(const model::Type &Parent,
                                        uint64_t Idx) {
   const model::Type &Unwrapped = *Parent.skipConstAndTypedefs();
@@ -179,10 +191,10 @@ static const model::Type &getFieldType(const model::Type &Parent,
   return getFieldType(Parent, NumericIdx);
 }
 
-static model::UpcastableType traverseModelGEP(const model::Binary &Model,
+static model::UpcastableType traverseModelGEP(ModelTypeTable &Types,
                                               const llvm::CallInst *Call) {
   // Deduce the base type from the first argument
-  auto Type = fromLLVMString(Call->getArgOperand(0), Model);
+  const model::UpcastableType &Type = Types.get(Call->getArgOperand(0));
 
   // Compute the first index of variadic arguments that represent the traversal
   // starting from the CurType.
@@ -261,7 +273,8 @@ handleReturnValue(const model::TypeDefinition &Prototype,
 }
 
 RecursiveCoroutine<llvm::SmallVector<model::UpcastableType, 8>>
-getStrongModelInfo(const llvm::Instruction *Inst, const model::Binary &Model) {
+getStrongModelInfo(const llvm::Instruction *Inst, ModelTypeTable &Types) {
+  const model::Binary &Model = Types.getModel();
 
   if (auto *Call = dyn_cast<llvm::CallInst>(Inst)) {
 
@@ -286,25 +299,24 @@ getStrongModelInfo(const llvm::Instruction *Inst, const model::Binary &Model) {
 
       if (FuncName.startswith("revng_call_stack_arguments")) {
         auto *Arg0Operand = Call->getArgOperand(0);
-        auto CallStackArgumentType = fromLLVMString(Arg0Operand, Model);
+        const auto &CallStackArgumentType = Types.get(Arg0Operand);
         revng_assert(not CallStackArgumentType->isVoidPrimitive());
 
         rc_return{ CallStackArgumentType };
       } else if (FTags.contains(FunctionTags::ModelGEP)
                  or FTags.contains(FunctionTags::ModelGEPRef)) {
-        rc_return{ traverseModelGEP(Model, Call) };
+        rc_return{ traverseModelGEP(Types, Call) };
 
       } else if (FTags.contains(FunctionTags::AddressOf)) {
         // The first argument is the base type (not the pointer's type)
-        auto Base = fromLLVMString(Call->getArgOperand(0), Model);
+        model::UpcastableType Base = Types.get(Call->getArgOperand(0));
         rc_return{ model::PointerType::make(std::move(Base),
                                             Model.Architecture()) };
 
       } else if (FTags.contains(FunctionTags::ModelCast)
                  or FTags.contains(FunctionTags::LocalVariable)) {
         // The first argument is the returned type
-        auto Type = fromLLVMString(Call->getArgOperand(0), Model);
-        rc_return{ std::move(Type) };
+        rc_return{ Types.get(Call->getArgOperand(0)) };
 
       } else if (FTags.contains(FunctionTags::StructInitializer)) {
         // Struct initializers are only used to pack together return values of
@@ -317,20 +329,21 @@ getStrongModelInfo(const llvm::Instruction *Inst, const model::Binary &Model) {
       } else if (FTags.contains(FunctionTags::SegmentRef)) {
         const auto &[StartAddress,
                      VirtualSize] = extractSegmentKeyFromMetadata(*CalledFunc);
-        auto Segment = Model.Segments().at({ StartAddress, VirtualSize });
+        const auto &Segment = Model.Segments().at({ StartAddress,
+                                                    VirtualSize });
         if (not Segment.Type().isEmpty())
           rc_return{ Segment.Type() };
 
       } else if (FTags.contains(FunctionTags::Parentheses)) {
         const llvm::Value *Op = Call->getArgOperand(0);
         if (auto *OriginalInst = llvm::dyn_cast<llvm::Instruction>(Op))
-          rc_return rc_recur getStrongModelInfo(OriginalInst, Model);
+          rc_return rc_recur getStrongModelInfo(OriginalInst, Types);
 
       } else if (FTags.contains(FunctionTags::OpaqueExtractValue)) {
         const llvm::Value *Op0 = Call->getArgOperand(0);
         if (auto *Aggregate = llvm::dyn_cast<llvm::Instruction>(Op0)) {
           llvm::SmallVector NestedRVs = rc_recur getStrongModelInfo(Aggregate,
-                                                                    Model);
+                                                                    Types);
           const auto *Op1 = Call->getArgOperand(1);
           const auto *Index = llvm::cast<llvm::ConstantInt>(Op1);
           rc_return{ NestedRVs[Index->getZExtValue()] };
@@ -351,7 +364,8 @@ getStrongModelInfo(const llvm::Instruction *Inst, const model::Binary &Model) {
 }
 
 llvm::SmallVector<model::UpcastableType>
-getExpectedModelType(const llvm::Use *U, const model::Binary &Model) {
+getExpectedModelType(const llvm::Use *U, ModelTypeTable &Types) {
+  const model::Binary &Model = Types.getModel();
   llvm::Instruction *User = dyn_cast<llvm::Instruction>(U->getUser());
 
   if (not User)
@@ -411,7 +425,7 @@ getExpectedModelType(const llvm::Use *U, const model::Binary &Model) {
           return {};
 
         // The type of the base value is contained in the first operand
-        auto Base = fromLLVMString(Call->getArgOperand(0), Model);
+        model::UpcastableType Base = Types.get(Call->getArgOperand(0));
         if (FTags.contains(FunctionTags::ModelGEP))
           Base = model::PointerType::make(std::move(Base),
                                           Model.Architecture());
@@ -419,10 +433,10 @@ getExpectedModelType(const llvm::Use *U, const model::Binary &Model) {
 
       } else if (isCallTo(Call, "revng_call_stack_arguments")) {
         auto *Arg0Operand = Call->getArgOperand(0);
-        auto CallStackArgumentType = fromLLVMString(Arg0Operand, Model);
+        const auto &CallStackArgumentType = Types.get(Arg0Operand);
         revng_assert(not CallStackArgumentType.isEmpty());
 
-        return { std::move(CallStackArgumentType) };
+        return { CallStackArgumentType };
       } else if (FTags.contains(FunctionTags::StructInitializer)) {
         // Struct initializers are only used to pack together return values of
         // RawFunctionTypes that return multiple values, therefore they have
@@ -0,0 +1,56 @@
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <algorithm>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/MathExtras.h"
+
+#include "revng/Support/Assert.h"
+
+#include "revng-c/Support/SegmentIndex.h"
+
+SegmentIndex::SegmentIndex(const model::Binary &Binary) {
+  Entries.reserve(Binary.Segments().size());
+  for (const model::Segment &Segment : Binary.Segments()) {
+    uint64_t Start = Segment.StartAddress().address();
+    uint64_t End = llvm::SaturatingAdd(Start, Segment.VirtualSize());
+    Entries.push_back({ Start, End, End, &Segment });
+  }
+
+  // Segments are sorted by MetaAddress, which for generic addresses of the
+  // same architecture means by address, but don't rely on it
+  llvm::stable_sort(Entries, [](const Entry &LHS, const Entry &RHS) {
+    return LHS.Start < RHS.Start;
+  });
+
+  uint64_t MaxEnd = 0;
+  for (Entry &E : Entries) {
+    MaxEnd = std::max(MaxEnd, E.End);
+    E.MaxEnd = MaxEnd;
+  }
+}
+
+const model::Segment *SegmentIndex::find(uint64_t Address) const {
+  // Find the first segment starting after Address
+  auto It = llvm::upper_bound(Entries, Address, [](uint64_t A, const Entry &E) {
+    return A < E.Start;
+  });
+
+  // Go back through the segments starting at or before Address. Unless
+  // segments overlap, only the first one is inspected.
+  const model::Segment *Result = nullptr;
+  while (It != Entries.begin()) {
+    --It;
+    if (It->MaxEnd <= Address)
+      break;
+
+    if (Address < It->End) {
+      revng_assert(Result == nullptr);
+      Result = It->Segment;
+    }
+  }
+
+  return Result;
+}
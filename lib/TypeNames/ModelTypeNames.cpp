@@ -212,8 +212,8 @@ private:
     rc_return Result;
   }
 
-  std::string constKeyword() {
-    return B.getKeyword(ptml::CBuilder::Keyword::Const).toString();
+  const std::string &constKeyword() {
+    return B.getKeyword(ptml::CBuilder::Keyword::Const);
   }
 };
 
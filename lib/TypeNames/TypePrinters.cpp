@@ -2,6 +2,8 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <memory>
+
 #include "llvm/ADT/PostOrderIterator.h"
 
 #include "revng-c/Support/Annotations.h"
@@ -310,108 +312,114 @@ void ptml::CTypeBuilder::printInlineDefinition(llvm::StringRef Name,
 
 static Logger<> InlineTypeLog{ "inline-type-selection" };
 
-void ptml::CTypeBuilder::collectInlinableTypes(const model::Binary &Binary) {
-  if (not DependencyCache.has_value())
-    DependencyCache = buildDependencyGraph(Binary.TypeDefinitions());
+static ptml::InlinableTypes computeInlinableTypes(const model::Binary &Binary) {
+  ptml::InlinableTypes Result{
+    .Dependencies = buildDependencyGraph(Binary.TypeDefinitions()),
+  };
+  const DependencyGraph &Dependencies = Result.Dependencies;
+  auto &StackFrameTypes = Result.StackFrameTypes;
 
-  StackFrameTypeCache = {};
   for (const model::Function &Function : Binary.Functions())
     if (auto *StackFrame = Function.stackFrameType())
-      StackFrameTypeCache.insert(StackFrame->key());
-
-  if (Configuration.EnableTypeInlining
-      || Configuration.EnableStackFrameInlining) {
-    std::map<model::TypeDefinition::Key, uint64_t> DependentTypeCount;
-    for (const auto *Node : DependencyCache->nodes()) {
-      if (isDeclarationTheSameAsDefinition(*Node->T)) {
-        // Skip types that never produce a definition since there's no point
-        // inlining them.
-        continue;
-      }
-
-      auto [Iterator, _] = DependentTypeCount.try_emplace(Node->T->key(), 0);
-      Iterator->second += Node->predecessorCount();
-      if (Node->K == TypeNode::Kind::Declaration) {
-        // Ignore a reference from a type definition to its own declaration.
-        // But only do so if there is exactly one. If there are more, keep it in
-        // order to ensure it is never marked for inlining.
-        auto SelfEdgeCounter = [Key = Node->T->key()](auto *N) {
-          return N->T->key() == Key;
-        };
-        if (llvm::count_if(Node->predecessors(), SelfEdgeCounter) == 1)
-          --Iterator->second;
-
-        // Since dependency graph does not take functions into account,
-        // explicitly add one "use" to each struct that appears as a function
-        // stack frame.
-        if (StackFrameTypeCache.contains(Node->T->key()))
-          ++Iterator->second;
-      }
+      StackFrameTypes.insert(StackFrame->key());
+
+  std::map<model::TypeDefinition::Key, uint64_t> DependentTypeCount;
+  for (const auto *Node : Dependencies.nodes()) {
+    if (isDeclarationTheSameAsDefinition(*Node->T)) {
+      // Skip types that never produce a definition since there's no point
+      // inlining them.
+      continue;
+    }
 
-      if (InlineTypeLog.isEnabled()) {
-        if (Node->K == TypeNode::Kind::Declaration)
-          InlineTypeLog << "Declaration of '";
-        else
-          InlineTypeLog << "Definition of '";
+    auto [Iterator, _] = DependentTypeCount.try_emplace(Node->T->key(), 0);
+    Iterator->second += Node->predecessorCount();
+    if (Node->K == TypeNode::Kind::Declaration) {
+      // Ignore a reference from a type definition to its own declaration.
+      // But only do so if there is exactly one. If there are more, keep it in
+      // order to ensure it is never marked for inlining.
+      auto SelfEdgeCounter = [Key = Node->T->key()](auto *N) {
+        return N->T->key() == Key;
+      };
+      if (llvm::count_if(Node->predecessors(), SelfEdgeCounter) == 1)
+        --Iterator->second;
+
+      // Since dependency graph does not take functions into account,
+      // explicitly add one "use" to each struct that appears as a function
+      // stack frame.
+      if (StackFrameTypes.contains(Node->T->key()))
+        ++Iterator->second;
+    }
 
-        InlineTypeLog << ::toString(Node->T->key())
-                      << "' is depended on by: {\n";
+    if (InlineTypeLog.isEnabled()) {
+      if (Node->K == TypeNode::Kind::Declaration)
+        InlineTypeLog << "Declaration of '";
+      else
+        InlineTypeLog << "Definition of '";
 
-        for (auto *Predecessor : Node->predecessors()) {
-          if (Predecessor->K == TypeNode::Kind::Declaration)
-            InlineTypeLog << "- Declaration of '";
-          else
-            InlineTypeLog << "- Definition of '";
+      InlineTypeLog << ::toString(Node->T->key()) << "' is depended on by: {\n";
 
-          InlineTypeLog << ::toString(Predecessor->T->key()) << "'\n";
-        }
+      for (auto *Predecessor : Node->predecessors()) {
+        if (Predecessor->K == TypeNode::Kind::Declaration)
+          InlineTypeLog << "- Declaration of '";
+        else
+          InlineTypeLog << "- Definition of '";
 
-        InlineTypeLog << "}\n" << DoLog;
+        InlineTypeLog << ::toString(Predecessor->T->key()) << "'\n";
       }
+
+      InlineTypeLog << "}\n" << DoLog;
     }
+  }
 
-    auto SingleDependencyFilter = std::views::filter([](const auto &Pair) {
-      return Pair.second == 1;
-    });
-    TypesToInlineCache = DependentTypeCount | SingleDependencyFilter
+  auto SingleDependencyFilter = std::views::filter([](const auto &Pair) {
+    return Pair.second == 1;
+  });
+  Result.TypesToInline = DependentTypeCount | SingleDependencyFilter
                          | std::views::keys
                          | revng::to<std::set<model::TypeDefinition::Key>>();
 
-    if (InlineTypeLog.isEnabled()) {
-      revng_log(InlineTypeLog, "Final list of types that can be inlined: {");
-      {
-        LoggerIndent Indent{ InlineTypeLog };
-        for (const model::TypeDefinition::Key &T : TypesToInlineCache)
-          revng_log(InlineTypeLog, ::toString(T));
-      }
-      revng_log(InlineTypeLog, "}");
+  if (InlineTypeLog.isEnabled()) {
+    revng_log(InlineTypeLog, "Final list of types that can be inlined: {");
+    {
+      LoggerIndent Indent{ InlineTypeLog };
+      for (const model::TypeDefinition::Key &T : Result.TypesToInline)
+        revng_log(InlineTypeLog, ::toString(T));
     }
-  }
+    revng_log(InlineTypeLog, "}");
 
-  if (Configuration.EnableStackFrameInlining && InlineTypeLog.isEnabled()) {
     revng_log(InlineTypeLog, "Which also includes stack frames: {");
     {
       LoggerIndent Indent{ InlineTypeLog };
-      for (const model::TypeDefinition::Key &T : StackFrameTypeCache)
-        if (TypesToInlineCache.contains(T))
+      for (const model::TypeDefinition::Key &T : StackFrameTypes)
+        if (Result.TypesToInline.contains(T))
           revng_log(InlineTypeLog, ::toString(T));
     }
     revng_log(InlineTypeLog, "}");
   }
 
-  InlinableCacheIsReady = true;
+  return Result;
+}
+
+std::shared_ptr<const ptml::InlinableTypes>
+ptml::getInlinableTypes(const model::Binary &Binary) {
+  return std::make_shared<InlinableTypes>(computeInlinableTypes(Binary));
+}
+
+void ptml::CTypeBuilder::collectInlinableTypes(const model::Binary &Binary) {
+  collectInlinableTypes(getInlinableTypes(Binary));
 }
 
 static Logger<> TypePrinterLog{ "type-definition-printer" };
 
 void ptml::CTypeBuilder::printTypeDefinitions(const model::Binary &Binary) {
-  if (not DependencyCache.has_value())
-    DependencyCache = buildDependencyGraph(Binary.TypeDefinitions());
+  if (not InlinableCache)
+    InlinableCache = getInlinableTypes(Binary);
 
-  const auto &TypeNodes = DependencyCache->TypeNodes();
+  const DependencyGraph &Dependencies = InlinableCache->Dependencies;
+  const auto &TypeNodes = Dependencies.TypeNodes();
 
   std::set<const TypeDependencyNode *> Defined;
-  for (const auto *Root : DependencyCache->nodes()) {
+  for (const auto *Root : Dependencies.nodes()) {
     revng_log(TypePrinterLog, "PostOrder from Root:" << getNodeLabel(Root));
 
     for (const auto *Node : llvm::post_order_ext(Root, Defined)) {
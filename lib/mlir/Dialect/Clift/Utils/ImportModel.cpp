@@ -2,6 +2,7 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/Support/FormatVariadic.h"
 
@@ -26,6 +27,15 @@ class CliftConverter {
   llvm::DenseMap<uint64_t, clift::TypeDefinitionAttr> Cache;
   llvm::DenseMap<uint64_t, const model::TypeDefinition *> IncompleteTypes;
 
+  /// The definitions that have been verified, which is only done once.
+  llvm::DenseSet<uint64_t> Verified;
+
+  /// The definitions whose complete conversion has read the model since the
+  /// last call to `forgetReads`. The definitions in Cache that are not in this
+  /// set are converted again, the first time they are requested, so that the
+  /// conversion reads the model again.
+  llvm::DenseSet<uint64_t> ReadDefinitions;
+
   llvm::SmallSet<uint64_t, 16> DefinitionGuardSet;
 
   class RecursiveDefinitionGuard {
@@ -65,24 +75,32 @@ public:
 
   ~CliftConverter() { revng_assert(DefinitionGuardSet.empty()); }
 
+  void forgetReads() { ReadDefinitions.clear(); }
+
   clift::ValueType
   convertTypeDefinition(const model::TypeDefinition &ModelType) {
     const clift::ValueType T = fromTypeDefinition(ModelType,
                                                   /* RequireComplete = */ true);
-    if (T and not processIncompleteTypes())
-      return nullptr;
-    return T;
+    return complete(T);
   }
 
   clift::ValueType convertType(const model::Type &ModelType) {
     const clift::ValueType T = fromType(ModelType,
                                         /* RequireComplete = */ true);
-    if (T and not processIncompleteTypes())
-      return nullptr;
-    return T;
+    return complete(T);
   }
 
 private:
+  clift::ValueType complete(clift::ValueType T) {
+    if (T and processIncompleteTypes())
+      return T;
+
+    // Do not leave anything behind for the next conversion, in case the
+    // converter is reused.
+    IncompleteTypes.clear();
+    return nullptr;
+  }
+
   mlir::BoolAttr getBool(bool const Value) {
     return mlir::BoolAttr::get(Context, Value);
   }
@@ -407,16 +425,39 @@ private:
   fromTypeDefinition(const model::TypeDefinition &ModelType,
                      bool RequireComplete = false,
                      const bool Const = false) {
-    if (const auto It = Cache.find(ModelType.ID()); It != Cache.end())
-      rc_return make<clift::DefinedType>(It->second, getBool(Const));
+    const uint64_t ID = ModelType.ID();
+    if (const auto It = Cache.find(ID); It != Cache.end()) {
+      if (ReadDefinitions.contains(ID))
+        rc_return make<clift::DefinedType>(It->second, getBool(Const));
+
+      // The definition has been converted before the last `forgetReads`.
+      // Convert it again, in order to read the same parts of the model as the
+      // first conversion. The result is the very same attribute. Structs and
+      // unions that do not have to be complete are postponed, as the first
+      // time.
+      if (not RequireComplete) {
+        if (llvm::isa<model::StructDefinition>(ModelType)
+            or llvm::isa<model::UnionDefinition>(ModelType)) {
+          IncompleteTypes.try_emplace(ID, &ModelType);
+          rc_return make<clift::DefinedType>(It->second, getBool(Const));
+        }
+        RequireComplete = true;
+      }
+    }
 
-    if (not ModelType.verify()) {
-      if (EmitError)
-        EmitError() << "Invalid model type definition";
+    if (not Verified.contains(ID)) {
+      if (not ModelType.verify()) {
+        if (EmitError)
+          EmitError() << "Invalid model type definition";
 
-      rc_return nullptr;
+        rc_return nullptr;
+      }
+      Verified.insert(ID);
     }
 
+    if (RequireComplete)
+      ReadDefinitions.insert(ID);
+
     const clift::TypeDefinitionAttr Attr = getTypeAttribute(ModelType,
                                                             RequireComplete);
 
@@ -424,8 +465,8 @@ private:
       rc_return nullptr;
 
     if (RequireComplete) {
-      const auto R = Cache.try_emplace(ModelType.ID(), Attr);
-      revng_assert(R.second);
+      const auto R = Cache.try_emplace(ID, Attr);
+      revng_assert(R.second or R.first->second == Attr);
     }
 
     rc_return make<clift::DefinedType>(Attr, getBool(Const));
@@ -510,3 +551,30 @@ clift::importModelType(llvm::function_ref<mlir::InFlightDiagnostic()> EmitError,
                        const model::Type &ModelType) {
   return CliftConverter(Context, EmitError).convertType(ModelType);
 }
+
+class clift::ModelTypeImporter::Implementation : public CliftConverter {
+public:
+  using CliftConverter::CliftConverter;
+};
+
+clift::ModelTypeImporter::
+  ModelTypeImporter(llvm::function_ref<mlir::InFlightDiagnostic()> EmitError,
+                    mlir::MLIRContext &Context) :
+  Impl(std::make_unique<Implementation>(Context, EmitError)) {
+}
+
+clift::ModelTypeImporter::~ModelTypeImporter() = default;
+
+clift::ValueType
+clift::ModelTypeImporter::importType(const model::TypeDefinition &ModelType) {
+  return Impl->convertTypeDefinition(ModelType);
+}
+
+clift::ValueType
+clift::ModelTypeImporter::importType(const model::Type &ModelType) {
+  return Impl->convertType(ModelType);
+}
+
+void clift::ModelTypeImporter::forgetReads() {
+  Impl->forgetReads();
+}
@@ -74,16 +74,21 @@ public:
 };
 using MLIRControlFlowGraphCache = BasicControlFlowGraphCache<MetadataTraits>;
 
+using TypeDefinitionSet = llvm::DenseSet<const model::TypeDefinition *>;
+
+// Import the prototype of the function and the prototypes of its callees, and
+// insert an undef op for each of them, unless that has already been done for
+// another function.
+//
+// The types reached by the function are imported in any case, so that the
+// importer reads them from the model and the function depends on them even
+// when they have been converted for another function.
 static void importReachableModelTypes(const model::Binary &Model,
-                                      const revng::pipes::CFGMap &CFGMap,
-                                      mlir::ModuleOp Module,
+                                      MLIRControlFlowGraphCache &Cache,
+                                      ModelTypeImporter &Importer,
+                                      TypeDefinitionSet &ImportedTypes,
+                                      mlir::OpBuilder &Builder,
                                       mlir::FunctionOpInterface F) {
-  llvm::DenseSet<const model::TypeDefinition *> ImportedTypes;
-
-  MLIRControlFlowGraphCache Cache(CFGMap);
-
-  // Walk the requested function, inserting their prototypes and the prototypes
-  // of their callees into the set of imported types.
   const MetaAddress MA = getMetaAddress(F);
   if (MA.isInvalid())
     return;
@@ -94,41 +99,39 @@ static void importReachableModelTypes(const model::Binary &Model,
   const model::Function &ModelFunction = *It;
   revng_assert(ModelFunction.prototype() != nullptr);
 
-  // Insert the prototype of this function.
-  ImportedTypes.insert(ModelFunction.prototype());
-
   if (F.isExternal())
     return;
 
+  llvm::SmallVector<const model::TypeDefinition *, 8> ReachedTypes;
+  TypeDefinitionSet Reached;
+  const auto Import = [&](const model::TypeDefinition *Type) {
+    if (Reached.insert(Type).second)
+      ReachedTypes.push_back(Type);
+  };
+
+  // Insert the prototype of this function.
+  Import(ModelFunction.prototype());
+
+  // Walk the function, inserting the prototypes of its callees.
   F->walk([&](LLVMCallOp Call) {
     const auto *CalleePrototype = Cache.getCallSitePrototype(Model,
                                                              Call,
                                                              &ModelFunction);
 
     if (CalleePrototype != nullptr)
-      ImportedTypes.insert(CalleePrototype);
+      Import(CalleePrototype);
   });
 
-  if (ImportedTypes.empty())
-    return;
-
-  mlir::MLIRContext &Context = *Module.getContext();
-  Context.loadDialect<CliftDialect>();
-
-  mlir::OpBuilder Builder(Module.getRegion());
-
-  const auto EmitError = [&]() -> mlir::InFlightDiagnostic {
-    return Context.getDiagEngine().emit(mlir::UnknownLoc::get(&Context),
-                                        mlir::DiagnosticSeverity::Error);
-  };
-
-  // Import each model type in the set as a Clift type and insert an undef op
-  // referencing that type in the module.
-  for (const model::TypeDefinition *ModelType : ImportedTypes) {
-    const auto CliftType = importModelType(EmitError, Context, *ModelType);
+  // Import each model type as a Clift type, reading again the definitions
+  // converted for the previous functions on behalf of this one, and insert an
+  // undef op referencing each new type in the module.
+  Importer.forgetReads();
+  for (const model::TypeDefinition *ModelType : ReachedTypes) {
+    const auto CliftType = Importer.importType(*ModelType);
     revng_assert(CliftType);
 
-    Builder.create<UndefOp>(mlir::UnknownLoc::get(&Context), CliftType);
+    if (ImportedTypes.insert(ModelType).second)
+      Builder.create<UndefOp>(Builder.getUnknownLoc(), CliftType);
   }
 }
 
@@ -165,13 +168,32 @@ public:
       FunctionMap[MA] = F;
     });
 
+    mlir::MLIRContext &Context = *Module.getContext();
+    Context.loadDialect<CliftDialect>();
+
+    const auto EmitError = [&]() -> mlir::InFlightDiagnostic {
+      return Context.getDiagEngine().emit(mlir::UnknownLoc::get(&Context),
+                                          mlir::DiagnosticSeverity::Error);
+    };
+
+    // The deserialized CFGs, the converted model types, and the set of types
+    // which already have an undef op are shared by all the functions, since
+    // they mostly call the same functions and share the same types.
+    MLIRControlFlowGraphCache Cache(CFGMap);
+    ModelTypeImporter Importer(EmitError, Context);
+    TypeDefinitionSet ImportedTypes;
+
+    mlir::OpBuilder Builder(Module.getRegion());
+
     const model::Binary &Model = *revng::getModelFromContext(EC);
     for (const model::Function &Function :
          revng::getFunctionsAndCommit(EC, MLIRContainer.name())) {
 
       importReachableModelTypes(Model,
-                                CFGMap,
-                                Module,
+                                Cache,
+                                Importer,
+                                ImportedTypes,
+                                Builder,
                                 FunctionMap.at(Function.Entry()));
     }
   }
@@ -189,9 +211,11 @@ static void importAllModelTypes(const model::Binary &Model,
                                          mlir::DiagnosticSeverity::Error);
   };
 
+  ModelTypeImporter Importer(EmitError, *Context);
+
   mlir::OpBuilder Builder(Module.getRegion());
   for (const auto &ModelType : Model.TypeDefinitions()) {
-    auto CliftType = importModelType(EmitError, *Context, *ModelType);
+    auto CliftType = Importer.importType(*ModelType);
     Builder.create<UndefOp>(mlir::UnknownLoc::get(Context), CliftType);
   }
 }
@@ -2,7 +2,14 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <set>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
 
 #include "mlir/Dialect/DLTI/DLTI.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
@@ -17,6 +24,59 @@
 
 namespace {
 
+using GlobalValueSet = llvm::SmallPtrSet<const llvm::GlobalValue *, 16>;
+
+/// Collect the global values whose definition is needed to import
+/// \p Functions: the functions themselves and the global variables they
+/// reference, directly or through the initializers of other global variables.
+/// Everything else they reference only needs to be declared.
+static GlobalValueSet
+collectDefinitions(llvm::ArrayRef<const llvm::Function *> Functions) {
+  GlobalValueSet Result;
+  llvm::SmallPtrSet<const llvm::Constant *, 32> Visited;
+  llvm::SmallVector<const llvm::Constant *, 32> Worklist;
+
+  const auto Enqueue = [&](const llvm::Value *V) {
+    if (const auto *C = llvm::dyn_cast<llvm::Constant>(V))
+      if (Visited.insert(C).second)
+        Worklist.push_back(C);
+  };
+
+  for (const llvm::Function *F : Functions) {
+    Result.insert(F);
+    for (const llvm::Instruction &I : llvm::instructions(F))
+      for (const llvm::Value *Operand : I.operands())
+        Enqueue(Operand);
+  }
+
+  while (not Worklist.empty()) {
+    const llvm::Constant *C = Worklist.pop_back_val();
+    if (const auto *V = llvm::dyn_cast<llvm::GlobalVariable>(C)) {
+      if (V->hasInitializer()) {
+        Result.insert(V);
+        Enqueue(V->getInitializer());
+      }
+    } else if (not llvm::isa<llvm::GlobalValue>(C)) {
+      for (const llvm::Value *Operand : C->operands())
+        Enqueue(Operand);
+    }
+  }
+
+  return Result;
+}
+
+/// Erase all the functions and global variables that are declared in \p M
+/// but never used
+static void eraseUnusedDeclarations(llvm::Module &M) {
+  for (llvm::Function &F : llvm::make_early_inc_range(M.functions()))
+    if (F.isDeclaration() and F.use_empty())
+      F.eraseFromParent();
+
+  for (llvm::GlobalVariable &V : llvm::make_early_inc_range(M.globals()))
+    if (V.isDeclaration() and V.use_empty())
+      V.eraseFromParent();
+}
+
 class ImportLLVMToMLIRPipe {
 public:
   static constexpr auto Name = "import-llvm-to-mlir";
@@ -36,39 +96,56 @@ public:
            const pipeline::LLVMContainer &LLVMContainer,
            revng::pipes::MLIRContainer &MLIRContainer) {
     auto &Context = *MLIRContainer.getContext();
-
-    // Let's do the MLIR import on a cloned Module, so we can save the old one
-    // untouched.
     const llvm::Module &OldModule = LLVMContainer.getModule();
-    auto NewModule = llvm::CloneModule(OldModule);
-    revng_assert(NewModule);
 
-    const auto eraseGlobalVariable = [&](const llvm::StringRef Symbol) {
-      if (llvm::GlobalVariable *const V = NewModule->getGlobalVariable(Symbol))
-        V->eraseFromParent();
-    };
+    // Only import the requested functions
+    std::set<MetaAddress> RequestedEntries;
+    for (const pipeline::Target &Target :
+         EC.getRequestedTargetsFor(MLIRContainer)) {
+      const auto &Components = Target.getPathComponents();
+      RequestedEntries.insert(MetaAddress::fromString(Components[0]));
+    }
 
-    // Erase the global ctors because translating them would fail due to missing
-    // function definitions.
-    eraseGlobalVariable("llvm.global_ctors");
-    eraseGlobalVariable("llvm.global_dtors");
+    std::vector<std::pair<const llvm::Function *, MetaAddress>> Requested;
+    for (const llvm::Function &F : OldModule.functions()) {
+      MetaAddress Entry = getMetaAddressMetadata(&F, FunctionEntryMDName);
+      if (Entry.isValid() and RequestedEntries.contains(Entry))
+        Requested.emplace_back(&F, Entry);
+    }
+    revng_assert(Requested.size() == RequestedEntries.size());
+
+    if (Requested.empty())
+      return;
+
+    // Let's do the MLIR import on a cloned Module, so we can save the old one
+    // untouched. Only clone the bodies of the requested functions and the
+    // global variables they need, everything else is declared, and
+    // declarations that end up unused are dropped before the import.
+    // This includes the global ctors, which would fail to translate due to
+    // missing function definitions.
+    std::vector<const llvm::Function *> Functions;
+    for (const auto &[F, Entry] : Requested)
+      Functions.push_back(F);
+    GlobalValueSet Definitions = collectDefinitions(Functions);
+
+    llvm::ValueToValueMapTy Map;
+    const auto ShouldCloneDefinition = [&](const llvm::GlobalValue *GV) {
+      return Definitions.contains(GV);
+    };
+    auto NewModule = llvm::CloneModule(OldModule, Map, ShouldCloneDefinition);
+    revng_assert(NewModule);
+    eraseUnusedDeclarations(*NewModule);
 
     // Import LLVM Dialect.
     auto Module = translateLLVMIRToModule(std::move(NewModule), &Context);
     revng_assert(mlir::succeeded(Module->verify()));
 
-    // Loop over each LLVM IR function and convert its function entry and
-    // metadata attributes into named MLIR string attributes on the matching
-    // functions.
-    for (const llvm::Function &F : OldModule.functions()) {
-      MetaAddress Entry = getMetaAddressMetadata(&F, FunctionEntryMDName);
-
-      if (not Entry.isValid())
-        continue;
-
+    // Convert the entry of each imported function into a named MLIR string
+    // attribute on the matching function.
+    for (const auto &[F, Entry] : Requested) {
       // Find the matching function in the new MLIR module.
       mlir::Operation
-        *const NewF = mlir::SymbolTable::lookupSymbolIn(*Module, F.getName());
+        *const NewF = mlir::SymbolTable::lookupSymbolIn(*Module, F->getName());
       revng_assert(NewF != nullptr);
 
       // Store the entry and metadata in named attributes on the new function.
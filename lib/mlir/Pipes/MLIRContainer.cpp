@@ -2,6 +2,7 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <memory>
 #include <optional>
 
 #include "mlir/Bytecode/BytecodeReader.h"
@@ -14,6 +15,8 @@
 #include "mlir/Parser/Parser.h"
 #include "mlir/Target/LLVMIR/Dialect/All.h"
 
+#include "llvm/Support/MemoryBuffer.h"
+
 #include "revng/Pipeline/RegisterContainerFactory.h"
 
 #include "revng-c/mlir/Dialect/Clift/IR/Clift.h"
@@ -30,7 +33,7 @@ using mlir::Operation;
 using mlir::SymbolOpInterface;
 using mlir::SymbolTable;
 
-using ContextPtr = std::unique_ptr<MLIRContext>;
+using ContextPtr = std::shared_ptr<MLIRContext>;
 using OwningModuleRef = mlir::OwningOpRef<ModuleOp>;
 
 static mlir::Block &getModuleBlock(ModuleOp Module) {
@@ -94,16 +97,16 @@ static const mlir::DialectRegistry &getDialectRegistry() {
 
 static ContextPtr makeContext() {
   const auto Threading = MLIRContext::Threading::DISABLED;
-  return std::make_unique<MLIRContext>(getDialectRegistry(), Threading);
+  return std::make_shared<MLIRContext>(getDialectRegistry(), Threading);
 }
 
 // Cloning MLIR from one module into another requires first serialising the
 // source and then deserialising it again into the target module. We do this
-// a) when cloning operations from one container to another, and
+// a) when merging operations from a container not sharing our context, and
 // b) when "garbage collecting" types and attributes during remove.
 //
-// Ideally at least for use case a) we could clone from one context into another
-// directly, but that is not supported at this time.
+// Containers created through cloneFiltered share the context of the original
+// container, so that in the common case a) is not needed.
 static OwningModuleRef cloneModuleInto(ModuleOp SourceModule,
                                        MLIRContext &DestinationContext) {
   llvm::SmallString<1024> Buffer;
@@ -184,10 +187,108 @@ static void pruneUnusedSymbols(ModuleOp Module) {
   });
 }
 
+static size_t countTargetFunctions(ModuleOp Module) {
+  size_t Result = 0;
+  visit(Module, [&](FunctionOpInterface F) {
+    if (not F.isExternal() and isTargetFunction(F))
+      ++Result;
+  });
+  return Result;
+}
+
 const char MLIRContainer::ID = 0;
 
+// When deserializing bytecode, the bodies of the functions are not loaded
+// until somebody needs them. Until then, the functions look like external
+// declarations, and the reader needs to be kept alive along with a copy of the
+// buffer it reads from.
+struct MLIRContainer::LazyBytecode {
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  mlir::ParserConfig Config;
+  mlir::BytecodeReader Reader;
+
+  LazyBytecode(const llvm::MemoryBuffer &Source, MLIRContext &Context) :
+    Buffer(llvm::MemoryBuffer::getMemBufferCopy(Source.getBuffer(),
+                                                Source.getBufferIdentifier())),
+    Config(&Context),
+    Reader(Buffer->getMemBufferRef(), Config, /* lazyLoad */ true) {}
+};
+
+MLIRContainer::~MLIRContainer() = default;
+
+bool MLIRContainer::isDefined(FunctionOpInterface F) const {
+  if (not F.isExternal())
+    return true;
+
+  return Lazy and Lazy->Reader.isMaterializable(F);
+}
+
+void MLIRContainer::materialize(Operation *Op) const {
+  if (not Lazy or not Lazy->Reader.isMaterializable(Op))
+    return;
+
+  const mlir::LogicalResult R = Lazy->Reader.materialize(Op);
+  revng_assert(mlir::succeeded(R));
+
+  if (Lazy->Reader.getNumOpsToMaterialize() == 0)
+    Lazy.reset();
+}
+
+void MLIRContainer::materializeAll() const {
+  if (not Lazy)
+    return;
+
+  const mlir::LogicalResult R = Lazy->Reader.finalize();
+  revng_assert(mlir::succeeded(R));
+
+  Lazy.reset();
+}
+
+// Functions whose body has not been loaded yet look external, so the symbols
+// they use cannot be known: don't prune anything until they are all loaded.
+void MLIRContainer::pruneSymbols() {
+  if (not Lazy)
+    pruneUnusedSymbols(*Module);
+}
+
+mlir::ModuleOp MLIRContainer::getModule() {
+  materializeAll();
+  return *Module;
+}
+
+MLIRContainer::MLIRContainer(const llvm::StringRef Name,
+                             ContextPtr SharedContext) :
+  pipeline::Container<MLIRContainer>(Name), Context(std::move(SharedContext)) {
+  Module = ModuleOp::create(mlir::UnknownLoc::get(Context.get()));
+}
+
+// Types and attributes are never freed by an MLIRContext: the only way to get
+// rid of the ones that are not used anymore is to clone the module into a new
+// context, which costs as much as serializing and deserializing it.
+// Therefore, we only do so when the context is not shared with other
+// containers, and when at least as many functions have been removed since the
+// last time as there are left, so that the cost is amortized over removals.
+//
+// Cloning the module would also load the bodies of all the functions which
+// have been deserialized lazily, so we don't collect until they are loaded.
+void MLIRContainer::collectGarbage() {
+  if (RemovedSinceCollection == 0 or Context.use_count() > 1 or Lazy)
+    return;
+
+  if (RemovedSinceCollection < countTargetFunctions(*Module))
+    return;
+
+  auto NewContext = makeContext();
+  auto NewModule = cloneModuleInto(*Module, *NewContext);
+
+  Module = std::move(NewModule);
+  Context = std::move(NewContext);
+  RemovedSinceCollection = 0;
+}
+
 void MLIRContainer::setModule(OwningModuleRef &&NewModule) {
   revng_assert(NewModule);
+  Lazy.reset();
 
   // Make any non-target functions external.
   visit(*NewModule, [&](FunctionOpInterface F) {
@@ -199,25 +300,34 @@ void MLIRContainer::setModule(OwningModuleRef &&NewModule) {
   Module = std::move(NewModule);
 }
 
-// 1. Temporarily clone the source module within the source context.
-// 2. Filter from the temporary module operations that we are not interested in.
-// 3. Clone the temporary module into the context of the new container.
+// 1. Clone the source module within the source context.
+// 2. Filter from the cloned module operations that we are not interested in.
+// 3. Hand the cloned module to a new container sharing the same context.
 //
-// Filtering in the source module and not after cloning into the new context
-// is important to avoid polluting the new context with types and attributes
-// not used by the remaining functions.
+// Sharing the context avoids serializing and deserializing the module, both
+// here and when the new container is merged back.
 std::unique_ptr<pipeline::ContainerBase>
 MLIRContainer::cloneFiltered(const pipeline::TargetsList &Filter) const {
-  auto DestinationContainer = std::make_unique<MLIRContainer>(name());
+  std::unique_ptr<MLIRContainer>
+    DestinationContainer(new MLIRContainer(name(), Context));
 
   if (getModuleBlock(*Module).empty())
     return DestinationContainer;
 
-  // The temporary module is automatically deleted at end of scope.
-  OwningModuleRef TemporaryModule(mlir::cast<ModuleOp>((*Module)->clone()));
+  // Load the bodies of the requested functions, the others are made external
+  // in the clone anyway.
+  if (Lazy) {
+    visit(*Module, [&](FunctionOpInterface F) {
+      const MetaAddress MA = mlir::clift::getMetaAddress(F);
+      if (not MA.isValid() or Filter.contains(makeTarget(MA)))
+        materialize(F);
+    });
+  }
+
+  OwningModuleRef ClonedModule(mlir::cast<ModuleOp>((*Module)->clone()));
 
   bool RemovedSome = false;
-  visit(*TemporaryModule, [&](FunctionOpInterface F) {
+  visit(*ClonedModule, [&](FunctionOpInterface F) {
     if (F.isExternal())
       return;
 
@@ -229,14 +339,9 @@ MLIRContainer::cloneFiltered(const pipeline::TargetsList &Filter) const {
   });
 
   if (RemovedSome)
-    pruneUnusedSymbols(*TemporaryModule);
+    pruneUnusedSymbols(*ClonedModule);
 
-  MLIRContext &DestinationContext = *DestinationContainer->Context;
-  DestinationContext.appendDialectRegistry(Context->getDialectRegistry());
-
-  OwningModuleRef &DestinationModule = DestinationContainer->Module;
-  DestinationModule = cloneModuleInto(*TemporaryModule,
-                                      *DestinationContainer->Context);
+  DestinationContainer->Module = std::move(ClonedModule);
 
   return DestinationContainer;
 }
@@ -246,28 +351,45 @@ void MLIRContainer::mergeBackImpl(MLIRContainer &&SourceContainer) {
     return;
 
   if (getModuleBlock(*Module).empty()) {
+    Lazy = std::move(SourceContainer.Lazy);
     Module = std::move(SourceContainer.Module);
     Context = std::move(SourceContainer.Context);
+    RemovedSinceCollection = SourceContainer.RemovedSinceCollection;
     return;
   }
 
-  // Register the dialects of the other container in this container.
-  Context->appendDialectRegistry(SourceContainer.Context->getDialectRegistry());
-
-  // Clone the other container's module into this container's context.
-  // This module is automatically erased at the end of scope.
-  OwningModuleRef TemporaryModule = cloneModuleInto(*SourceContainer.Module,
-                                                    *Context);
+  // Functions which have not been loaded yet would be moved or cloned as
+  // external declarations.
+  SourceContainer.materializeAll();
+
+  // If the other container shares our context, its operations can be moved
+  // directly. Otherwise, clone the other container's module into this
+  // container's context. This module is automatically erased at the end of
+  // scope.
+  OwningModuleRef TemporaryModule;
+  ModuleOp SourceModule = *SourceContainer.Module;
+  if (SourceContainer.Context != Context) {
+    // Register the dialects of the other container in this container.
+    const auto &SourceRegistry = SourceContainer.Context->getDialectRegistry();
+    Context->appendDialectRegistry(SourceRegistry);
+
+    TemporaryModule = cloneModuleInto(SourceModule, *Context);
+    SourceModule = *TemporaryModule;
+  }
 
   mlir::Block &DestinationBlock = getModuleBlock(*Module);
-  visit(*TemporaryModule, [&](SymbolOpInterface Symbol) {
+  visit(SourceModule, [&](SymbolOpInterface Symbol) {
     // Erase an existing symbol with the same name, if one exists.
     if (auto S = SymbolTable::lookupSymbolIn(*Module, Symbol.getName())) {
       if (auto F = mlir::dyn_cast<FunctionOpInterface>(Symbol.getOperation())) {
         if (F.isExternal())
           return;
       }
+
+      // The reader must not be left pointing to an erased operation.
+      materialize(S);
       S->erase();
+      ++RemovedSinceCollection;
     }
 
     // Move each new symbol from the temporary module to the container's module.
@@ -276,14 +398,15 @@ void MLIRContainer::mergeBackImpl(MLIRContainer &&SourceContainer) {
   });
 
   // Assume that at least some symbols were copied over and always prune.
-  pruneUnusedSymbols(*Module);
+  pruneSymbols();
+  collectGarbage();
 }
 
 pipeline::TargetsList MLIRContainer::enumerate() const {
   pipeline::TargetsList::List List;
 
   visit(Module.get(), [&](FunctionOpInterface F) {
-    if (F.isExternal())
+    if (not isDefined(F))
       return;
 
     const MetaAddress MA = mlir::clift::getMetaAddress(F);
@@ -304,57 +427,87 @@ bool MLIRContainer::remove(const pipeline::TargetsList &List) {
 
   bool RemovedSome = false;
   visit(*Module, [&](FunctionOpInterface F) {
-    if (F.isExternal())
+    if (not isDefined(F))
       return;
 
-    if (not isTargetFunction(F))
+    const MetaAddress MA = mlir::clift::getMetaAddress(F);
+    if (not MA.isValid() or not List.contains(makeTarget(MA)))
       return;
 
+    // The reader must not be left pointing to a function it would later fill.
+    materialize(F);
     makeExternal(F);
     RemovedSome = true;
+    ++RemovedSinceCollection;
   });
 
   if (RemovedSome) {
-    // If any functions were removed, prune symbols and garbage collect types by
-    // cloning the module into a new context.
-
-    pruneUnusedSymbols(*Module);
-
-    auto NewContext = makeContext();
-    auto NewModule = cloneModuleInto(*Module, *NewContext);
-
-    Module = std::move(NewModule);
-    Context = std::move(NewContext);
+    // If any functions were removed, prune symbols and, if worth it, garbage
+    // collect types by cloning the module into a new context.
+    pruneSymbols();
+    collectGarbage();
   }
 
   return RemovedSome;
 }
 
 void MLIRContainer::clear() {
+  Lazy.reset();
   auto NewContext = makeContext();
 
   Module = ModuleOp::create(mlir::UnknownLoc::get(NewContext.get()));
   Context = std::move(NewContext);
+  RemovedSinceCollection = 0;
 }
 
 llvm::Error MLIRContainer::serialize(llvm::raw_ostream &OS) const {
+  materializeAll();
   mlir::writeBytecodeToFile(*Module, OS);
   return llvm::Error::success();
 }
 
+static bool isFunction(Operation *Op) {
+  return mlir::isa<FunctionOpInterface>(Op);
+}
+
 llvm::Error MLIRContainer::deserialize(const llvm::MemoryBuffer &Buffer) {
   auto NewContext = makeContext();
 
-  const mlir::ParserConfig Config(NewContext.get());
-  OwningModuleRef
+  OwningModuleRef NewModule;
+  std::unique_ptr<LazyBytecode> NewLazy;
+  if (mlir::isBytecode(Buffer.getMemBufferRef())) {
+    // Read the module and the declarations of all the symbols right away, but
+    // leave the bodies of the functions to when they are first needed.
+    NewLazy = std::make_unique<LazyBytecode>(Buffer, *NewContext);
+
+    mlir::Block OuterBlock;
+    auto &Reader = NewLazy->Reader;
+    if (mlir::succeeded(Reader.readTopLevel(&OuterBlock, isFunction))) {
+      auto &Operations = OuterBlock.getOperations();
+      if (Operations.size() == 1) {
+        if (auto M = mlir::dyn_cast<ModuleOp>(Operations.front())) {
+          M->remove();
+          NewModule = M;
+        }
+      }
+    }
+
+    if (Reader.getNumOpsToMaterialize() == 0)
+      NewLazy.reset();
+  } else {
+    const mlir::ParserConfig Config(NewContext.get());
     NewModule = mlir::parseSourceString<ModuleOp>(Buffer.getBuffer(), Config);
+  }
 
   if (not NewModule)
     return llvm::createStringError(llvm::inconvertibleErrorCode(),
                                    "Cannot load MLIR module.");
 
+  Lazy.reset();
   Module = std::move(NewModule);
   Context = std::move(NewContext);
+  Lazy = std::move(NewLazy);
+  RemovedSinceCollection = 0;
 
   return llvm::Error::success();
 }
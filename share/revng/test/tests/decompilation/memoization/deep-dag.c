@@ -0,0 +1,22 @@
+/*
+ * This file is distributed under the MIT License. See LICENSE.md for details.
+ */
+
+/*
+ * Each step uses the result of the previous one three times, so that the
+ * returned expression is a DAG in which the shared subexpressions are used
+ * many times. Six steps are enough for that, while keeping the fully
+ * expanded expression, with its 3^6 leaves, small.
+ */
+
+#define STEP(X) ((X) * (X) + ((X) >> 3))
+#define STEP3(X) STEP(STEP(STEP(X)))
+
+__attribute__((noinline)) unsigned long deep_dag(unsigned long X) {
+  return STEP3(STEP3(X));
+}
+
+int main(int argc, char **argv) {
+  (void) argv;
+  return (int) deep_dag((unsigned long) argc);
+}
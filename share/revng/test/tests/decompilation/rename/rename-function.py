@@ -0,0 +1,32 @@
+#
+# This file is distributed under the MIT License. See LICENSE.md for details.
+#
+
+# Give a new name to the function with the lowest entry address of a model
+
+import sys
+
+import yaml
+
+
+def main():
+    if len(sys.argv) != 4:
+        sys.exit(f"Usage: {sys.argv[0]} INPUT_MODEL NEW_NAME OUTPUT_MODEL")
+
+    input_path, new_name, output_path = sys.argv[1:]
+
+    with open(input_path) as input_file:
+        model = yaml.safe_load(input_file)
+
+    functions = model.get("Functions", [])
+    if not functions:
+        sys.exit("The model has no functions")
+
+    functions[0]["CustomName"] = new_name
+
+    with open(output_path, "w") as output_file:
+        yaml.safe_dump(model, output_file, sort_keys=False)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,191 @@
+/// \file ASTSerialization.cpp
+/// Tests that GHASTs can be serialized and restored on another copy of the
+/// function they have been built on
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <iterator>
+#include <memory>
+#include <string>
+
+#define BOOST_TEST_MODULE ASTSerialization
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng/Support/Assert.h"
+
+#include "revng-c/RestructureCFG/ASTNode.h"
+#include "revng-c/RestructureCFG/ASTSerialization.h"
+#include "revng-c/RestructureCFG/ASTTree.h"
+#include "revng-c/RestructureCFG/ExprNode.h"
+
+#include "lib/RestructureCFG/SimplifyHybridNot.h"
+
+using namespace llvm;
+
+using ExprPtr = ASTTree::expr_unique_ptr;
+using NodePtr = ASTTree::ast_unique_ptr;
+using DispatcherKind = ASTNode::DispatcherKind;
+
+static const char *const FunctionIR = R"LLVM(
+define i64 @f(i64 %a) {
+entry:
+  %c = icmp ne i64 %a, 0
+  br i1 %c, label %head, label %exit
+
+head:
+  %x = add i64 %a, 1
+  switch i64 %x, label %exit [ i64 1, label %exit
+                               i64 2, label %case ]
+
+case:
+  ret i64 2
+
+exit:
+  ret i64 %a
+}
+)LLVM";
+
+static std::unique_ptr<Module> parse(LLVMContext &Context) {
+  SMDiagnostic Error;
+  auto Result = parseAssemblyString(FunctionIR, Error, Context);
+  revng_check(Result != nullptr);
+  return Result;
+}
+
+static BasicBlock *getBlock(Function &F, unsigned Index) {
+  return &*std::next(F.begin(), Index);
+}
+
+static std::string serialize(ASTTree &AST, const Function &F) {
+  std::string Result;
+  raw_string_ostream Stream(Result);
+  serializeAST(AST, F, Stream);
+  Stream.flush();
+  return Result;
+}
+
+/// Build an AST containing all the kinds of nodes and expressions, and negate
+/// the condition of the entry block as beautification would
+static void buildAST(ASTTree &AST, Function &F) {
+  BasicBlock *Entry = getBlock(F, 0);
+  BasicBlock *Head = getBlock(F, 1);
+
+  flipIRNot(Entry, ASTTree::NotKind::SimpleIR);
+  AST.addIRFlip(Entry, ASTTree::NotKind::SimpleIR);
+
+  ExprNode *Atomic = AST.addCondExpr(ExprPtr(new AtomicNode(Entry)));
+  ExprNode *Not = AST.addCondExpr(ExprPtr(new NotNode(Atomic)));
+  auto *Compare = new ValueCompareNode(CompareNode::Comparison_Equal, Head, 3);
+  ExprNode *Value = AST.addCondExpr(ExprPtr(Compare));
+  auto *LoopState = new LoopStateCompareNode(CompareNode::Comparison_NotPresent,
+                                             7);
+  ExprNode *State = AST.addCondExpr(ExprPtr(LoopState));
+  ExprNode *And = AST.addCondExpr(ExprPtr(new AndNode(Not, Value)));
+  AST.addCondExpr(ExprPtr(new OrNode(And, State)));
+
+  // Names can contain anything
+  auto *Code = new CodeNode("entry block\nwith newline", Entry);
+  Code->setImplicitReturn();
+  AST.addASTNode(NodePtr(Code));
+
+  auto *Break = new BreakNode("break", nullptr);
+  Break->setBreakFromWithinSwitch();
+  AST.addASTNode(NodePtr(Break));
+
+  auto *If = new IfNode(And, Code, nullptr, "if", true, Entry);
+  AST.addASTNode(NodePtr(If));
+
+  auto *Continue = new ContinueNode("continue", nullptr);
+  Continue->setImplicit();
+  Continue->addComputationIfNode(If);
+  AST.addASTNode(NodePtr(Continue));
+
+  SwitchNode::case_container Cases;
+  SwitchNode::label_set_t Labels;
+  Labels.insert(1);
+  Labels.insert(5);
+  Cases.push_back({ Labels, Break });
+  Cases.push_back({ {}, Continue });
+  llvm::Value *Condition = cast<SwitchInst>(Head->getTerminator())
+                             ->getCondition();
+  auto *Switch = new SwitchNode("switch",
+                                Head,
+                                Condition,
+                                std::move(Cases),
+                                false,
+                                DispatcherKind::DK_NotADispatcher);
+  Switch->setNeedsLoopBreakDispatcher();
+  AST.addASTNode(NodePtr(Switch));
+
+  AST.addASTNode(NodePtr(new SwitchNode("dispatcher",
+                                        nullptr,
+                                        nullptr,
+                                        {},
+                                        true,
+                                        DispatcherKind::DK_Exit)));
+  AST.addASTNode(NodePtr(new SwitchBreakNode(Switch)));
+  AST.addASTNode(NodePtr(new SetNode("set",
+                                     nullptr,
+                                     42,
+                                     DispatcherKind::DK_Entry)));
+
+  auto *Loop = new ScsNode("loop", nullptr, Switch);
+  Loop->setDoWhile(If);
+  AST.addASTNode(NodePtr(Loop));
+
+  SequenceNode *Sequence = AST.addSequenceNode();
+  Sequence->addNode(If);
+  Sequence->addNode(Loop);
+  AST.setRoot(Sequence);
+}
+
+BOOST_AUTO_TEST_CASE(RoundTrip) {
+  LLVMContext Context;
+  std::unique_ptr<Module> Original = parse(Context);
+  std::unique_ptr<Module> Copy = parse(Context);
+  Function &F = *Original->getFunction("f");
+  Function &FCopy = *Copy->getFunction("f");
+
+  ASTTree AST;
+  buildAST(AST, F);
+  std::string Serialized = serialize(AST, F);
+
+  ASTTree Restored = deserializeAST(Serialized, FCopy);
+  BOOST_TEST(serialize(Restored, FCopy) == Serialized);
+
+  // The negation of the condition has been replayed on the copy
+  auto *Branch = cast<BranchInst>(getBlock(FCopy, 0)->getTerminator());
+  auto *Compare = cast<ICmpInst>(Branch->getCondition());
+  BOOST_TEST(Compare->getPredicate() == ICmpInst::ICMP_EQ);
+
+  // References to the IR point to the copy
+  auto *Root = cast<SequenceNode>(Restored.getRoot());
+  BOOST_TEST(Root->length() == 2u);
+  auto *If = cast<IfNode>(Root->getNodeN(0));
+  BOOST_TEST(If->getBB() == getBlock(FCopy, 0));
+  BOOST_TEST(If->isWeaved());
+  BOOST_TEST(cast<CodeNode>(If->getThen())->containsImplicitReturn());
+
+  auto *Loop = cast<ScsNode>(Root->getNodeN(1));
+  BOOST_TEST(Loop->isDoWhile());
+  BOOST_TEST(Loop->getRelatedCondition() == If);
+
+  auto *Switch = cast<SwitchNode>(Loop->getBody());
+  auto *Head = getBlock(FCopy, 1);
+  auto *SwitchInstruction = cast<SwitchInst>(Head->getTerminator());
+  BOOST_TEST(Switch->getCondition() == SwitchInstruction->getCondition());
+  BOOST_TEST(Switch->needsLoopBreakDispatcher());
+  BOOST_TEST(not Switch->needsStateVariable());
+  BOOST_TEST(Switch->cases_size() == 2u);
+  BOOST_TEST(Switch->hasDefault());
+}
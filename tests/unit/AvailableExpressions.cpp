@@ -0,0 +1,285 @@
+/// \file AvailableExpressions.cpp
+/// Tests for the available expressions analysis used by SwitchToStatements
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#define BOOST_TEST_MODULE AvailableExpressions
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+
+#include "revng/Support/Assert.h"
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+
+#include "revng-c/Support/FunctionTags.h"
+
+#include "lib/Canonicalize/AvailableExpressions.h"
+
+using namespace llvm;
+
+/// The reference implementation: a plain set of AvailableExpressions, updated
+/// one instruction at a time, as the analysis used to do
+using ReferenceSet = std::set<AvailableExpression>;
+
+static bool referenceNoAlias(const Instruction *I, const Instruction *J) {
+  const auto DoesNotAccessMemory = [](const Instruction *I) {
+    auto *Call = dyn_cast_or_null<CallInst>(I);
+    return Call and Call->getMemoryEffects().doesNotAccessMemory();
+  };
+  if (DoesNotAccessMemory(I) or DoesNotAccessMemory(J))
+    return true;
+
+  std::optional<const Value *> AccessedByI = getAccessedLocalVariable(I);
+  std::optional<const Value *> AccessedByJ = getAccessedLocalVariable(J);
+  if (not AccessedByI.has_value() or not AccessedByJ.has_value())
+    return true;
+
+  if (*AccessedByI == nullptr or *AccessedByJ == nullptr)
+    return false;
+
+  return *AccessedByI != *AccessedByJ;
+}
+
+static void referenceTransfer(Instruction *I, ReferenceSet &Available) {
+  if (isStatement(I)) {
+    std::erase_if(Available, [I](const AvailableExpression &A) {
+      return not referenceNoAlias(I, A.Expression)
+             or not referenceNoAlias(I, A.Assign);
+    });
+  }
+
+  for (const AvailableExpression &A : getGeneratedExpressions(I))
+    Available.insert(A);
+}
+
+/// Compute the AvailableExpressions right before each instruction of \p F.
+/// The entry block of \p F must have no predecessors.
+static std::map<const Instruction *, ReferenceSet>
+computeReference(Function &F) {
+  ReferenceSet All;
+  for (Instruction &I : instructions(F))
+    for (const AvailableExpression &A : getGeneratedExpressions(&I))
+      All.insert(A);
+
+  std::map<const BasicBlock *, ReferenceSet> Out;
+  for (BasicBlock &BB : F)
+    Out[&BB] = All;
+
+  const auto In = [&](BasicBlock &BB) {
+    if (&BB == &F.getEntryBlock())
+      return ReferenceSet{};
+
+    ReferenceSet Result = All;
+    for (BasicBlock *Predecessor : predecessors(&BB))
+      std::erase_if(Result, [&](const AvailableExpression &A) {
+        return not Out.at(Predecessor).contains(A);
+      });
+    return Result;
+  };
+
+  bool Changed = true;
+  while (Changed) {
+    Changed = false;
+    for (BasicBlock &BB : F) {
+      ReferenceSet Available = In(BB);
+      for (Instruction &I : BB)
+        referenceTransfer(&I, Available);
+
+      if (Available != Out.at(&BB)) {
+        Out[&BB] = std::move(Available);
+        Changed = true;
+      }
+    }
+  }
+
+  std::map<const Instruction *, ReferenceSet> Result;
+  for (BasicBlock &BB : F) {
+    ReferenceSet Available = In(BB);
+    for (Instruction &I : BB) {
+      Result[&I] = Available;
+      referenceTransfer(&I, Available);
+    }
+  }
+
+  return Result;
+}
+
+/// Generates random functions made of Copy, Assign and other calls that read
+/// or write memory, on a few local variables
+class FunctionGenerator {
+private:
+  LLVMContext Context;
+  Module M{ "AvailableExpressions", Context };
+  std::mt19937 Random;
+
+  Type *Int64 = Type::getInt64Ty(Context);
+  Type *Void = Type::getVoidTy(Context);
+
+  Function *Assign = nullptr;
+  Function *Copy = nullptr;
+  Function *LocalVariable = nullptr;
+  Function *ModelGEPRef = nullptr;
+  Function *Pure = nullptr;
+  Function *Read = nullptr;
+  Function *Opaque = nullptr;
+
+public:
+  FunctionGenerator(unsigned Seed) : Random(Seed) {
+    Assign = declare("Assign", Void, { Int64, Int64 });
+    Assign->setMemoryEffects(MemoryEffects::writeOnly());
+    FunctionTags::Assign.addTo(Assign);
+
+    Copy = declare("Copy", Int64, { Int64 });
+    Copy->setMemoryEffects(MemoryEffects::readOnly());
+    FunctionTags::Copy.addTo(Copy);
+
+    LocalVariable = declare("LocalVariable", Int64, {});
+    LocalVariable->setMemoryEffects(MemoryEffects::none());
+    FunctionTags::LocalVariable.addTo(LocalVariable);
+    FunctionTags::AllocatesLocalVariable.addTo(LocalVariable);
+
+    ModelGEPRef = declare("ModelGEPRef", Int64, { Int64, Int64, Int64 });
+    ModelGEPRef->setMemoryEffects(MemoryEffects::none());
+    FunctionTags::ModelGEPRef.addTo(ModelGEPRef);
+
+    Pure = declare("Pure", Int64, { Int64 });
+    Pure->setMemoryEffects(MemoryEffects::none());
+
+    Read = declare("Read", Int64, {});
+    Read->setMemoryEffects(MemoryEffects::readOnly());
+
+    Opaque = declare("Opaque", Void, {});
+  }
+
+public:
+  Function &generate(unsigned BlockCount, unsigned InstructionCount) {
+    auto *Int1 = Type::getInt1Ty(Context);
+    auto *FT = FunctionType::get(Void, { Int64, Int64, Int1 }, false);
+    auto *F = Function::Create(FT, GlobalValue::ExternalLinkage, "F", M);
+
+    std::vector<BasicBlock *> Blocks;
+    for (unsigned I = 0; I < BlockCount; ++I)
+      Blocks.push_back(BasicBlock::Create(Context, "", F));
+
+    // The locations that can be accessed, and the values that can be used,
+    // from all the blocks
+    std::vector<Value *> Locations = { F->getArg(0) };
+    std::vector<Value *> Values = { F->getArg(1) };
+
+    IRBuilder<> Builder(Blocks[0]);
+    for (unsigned I = 0; I < 3; ++I) {
+      Value *Variable = Builder.CreateCall(LocalVariable);
+      Locations.push_back(Variable);
+
+      // A reference to a field of the variable, and one to an unknown element
+      Value *Zero = Builder.getInt64(0);
+      Value *Field = Builder.getInt64(I);
+      Value *Index = F->getArg(1);
+      Locations.push_back(Builder.CreateCall(ModelGEPRef,
+                                             { Zero, Variable, Field }));
+      Locations.push_back(Builder.CreateCall(ModelGEPRef,
+                                             { Zero, Variable, Index }));
+    }
+
+    for (unsigned Index = 0; Index < BlockCount; ++Index) {
+      Builder.SetInsertPoint(Blocks[Index]);
+      std::vector<Value *> LocalValues = Values;
+
+      for (unsigned I = 0; I < InstructionCount; ++I) {
+        switch (pick(5)) {
+        case 0:
+          LocalValues.push_back(Builder.CreateCall(Copy,
+                                                   { pickFrom(Locations) }));
+          break;
+        case 1:
+          Builder.CreateCall(Assign,
+                             { pickFrom(LocalValues), pickFrom(Locations) });
+          break;
+        case 2:
+          LocalValues.push_back(Builder.CreateCall(Pure,
+                                                   { pickFrom(LocalValues) }));
+          break;
+        case 3:
+          LocalValues.push_back(Builder.CreateCall(Read));
+          break;
+        case 4:
+          Builder.CreateCall(Opaque);
+          break;
+        }
+      }
+
+      // The values of the entry block dominate all the others
+      if (Index == 0)
+        Values = LocalValues;
+
+      // Chain all the blocks, so that they are all reachable, and add some
+      // random edges, never going back to the entry block
+      if (Index + 1 == BlockCount) {
+        Builder.CreateRetVoid();
+      } else if (pick(2) == 0) {
+        Builder.CreateBr(Blocks[Index + 1]);
+      } else {
+        BasicBlock *Other = Blocks[1 + pick(BlockCount - 1)];
+        Builder.CreateCondBr(F->getArg(2), Blocks[Index + 1], Other);
+      }
+    }
+
+    revng_check(not verifyFunction(*F, &dbgs()));
+    return *F;
+  }
+
+private:
+  Function *
+  declare(StringRef Name, Type *ReturnType, ArrayRef<Type *> Arguments) {
+    auto *FT = FunctionType::get(ReturnType, Arguments, false);
+    return Function::Create(FT, GlobalValue::ExternalLinkage, Name, M);
+  }
+
+  unsigned pick(unsigned Count) {
+    return std::uniform_int_distribution<unsigned>(0, Count - 1)(Random);
+  }
+
+  Value *pickFrom(const std::vector<Value *> &Candidates) {
+    return Candidates[pick(Candidates.size())];
+  }
+};
+
+BOOST_AUTO_TEST_CASE(RandomFunctionsMatchReference) {
+  for (unsigned Seed = 0; Seed < 200; ++Seed) {
+    FunctionGenerator Generator(Seed);
+    Function &F = Generator.generate(2 + Seed % 7, 1 + Seed % 12);
+
+    auto Reference = computeReference(F);
+    AvailableExpressions Analysis(F);
+
+    std::set<Instruction *> Expressions;
+    for (Instruction &I : instructions(F))
+      for (const AvailableExpression &A : getGeneratedExpressions(&I))
+        Expressions.insert(A.Expression);
+
+    for (Instruction &Where : instructions(F)) {
+      const ReferenceSet &Expected = Reference.at(&Where);
+      for (Instruction *I : Expressions) {
+        AvailableExpressionVector ExpectedRange;
+        for (const AvailableExpression &A : Expected)
+          if (A.Expression == I)
+            ExpectedRange.push_back(A);
+
+        BOOST_TEST((Analysis.getAvailableAt(I, &Where) == ExpectedRange));
+      }
+    }
+  }
+}
@@ -0,0 +1,121 @@
+/// \file CliftTypeImporter.cpp
+/// Tests that a ModelTypeImporter shared among several imports produces the
+/// same types as independent imports
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#define BOOST_TEST_MODULE CliftTypeImporter
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "mlir/IR/Diagnostics.h"
+
+#include "revng/Model/Binary.h"
+#include "revng/Support/Assert.h"
+#include "revng/TupleTree/TupleTree.h"
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+
+#include "revng-c/mlir/Dialect/Clift/IR/Clift.h"
+#include "revng-c/mlir/Dialect/Clift/Utils/ImportModel.h"
+
+using namespace mlir::clift;
+
+namespace {
+
+struct Fixture {
+  mlir::MLIRContext Context;
+  TupleTree<model::Binary> Model;
+
+  const model::TypeDefinition *Struct = nullptr;
+  const model::TypeDefinition *ByValue = nullptr;
+  const model::TypeDefinition *ByPointer = nullptr;
+
+  Fixture() {
+    Context.loadDialect<CliftDialect>();
+
+    // struct S { int64_t Field; S *Next; };
+    auto [StructDefinition, StructType] = Model->makeStructDefinition(16);
+    auto Next = model::PointerType::make(StructType.copy(), 8);
+    StructDefinition.addField(0, model::PrimitiveType::makeSigned(8));
+    StructDefinition.addField(8, std::move(Next));
+    Struct = &StructDefinition;
+
+    // void ByValue(S);
+    auto [Value, ValueType] = Model->makeCABIFunctionDefinition();
+    Value.ABI() = model::ABI::SystemV_x86_64;
+    Value.Arguments()[0].Type() = StructType.copy();
+    ByValue = &Value;
+
+    // S *ByPointer(S *);
+    auto [Pointer, PointerType] = Model->makeCABIFunctionDefinition();
+    Pointer.ABI() = model::ABI::SystemV_x86_64;
+    Pointer.Arguments()[0].Type() = model::PointerType::make(StructType.copy(),
+                                                             8);
+    Pointer.ReturnType() = model::PointerType::make(StructType.copy(), 8);
+    ByPointer = &Pointer;
+
+    revng_check(Model->verify(true));
+  }
+
+  mlir::InFlightDiagnostic emitError() {
+    return Context.getDiagEngine().emit(mlir::UnknownLoc::get(&Context),
+                                        mlir::DiagnosticSeverity::Remark);
+  }
+
+  ValueType importAlone(const model::TypeDefinition &ModelType) {
+    return importModelType([this]() { return emitError(); },
+                           Context,
+                           ModelType);
+  }
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(SharedImporterMatchesIndependentImports, Fixture) {
+  const auto EmitError = [this]() { return emitError(); };
+  ModelTypeImporter Importer(EmitError, Context);
+
+  // Import the types in an order in which the later ones reuse the
+  // definitions converted for the earlier ones.
+  ValueType SharedByValue = Importer.importType(*ByValue);
+  ValueType SharedByPointer = Importer.importType(*ByPointer);
+  ValueType SharedStruct = Importer.importType(*Struct);
+
+  BOOST_TEST(static_cast<bool>(SharedByValue));
+  BOOST_TEST(static_cast<bool>(SharedByPointer));
+  BOOST_TEST(static_cast<bool>(SharedStruct));
+
+  // Clift types are uniqued in the context: the same type definition has to
+  // produce the very same type.
+  BOOST_TEST((SharedByValue == importAlone(*ByValue)));
+  BOOST_TEST((SharedByPointer == importAlone(*ByPointer)));
+  BOOST_TEST((SharedStruct == importAlone(*Struct)));
+
+  // Importing again returns the memoized types.
+  BOOST_TEST((Importer.importType(*ByPointer) == SharedByPointer));
+  BOOST_TEST((Importer.importType(*Struct) == SharedStruct));
+}
+
+BOOST_FIXTURE_TEST_CASE(ForgetReadsKeepsTheImportedTypes, Fixture) {
+  const auto EmitError = [this]() { return emitError(); };
+  ModelTypeImporter Importer(EmitError, Context);
+
+  ValueType SharedByValue = Importer.importType(*ByValue);
+  ValueType SharedByPointer = Importer.importType(*ByPointer);
+  BOOST_TEST(static_cast<bool>(SharedByValue));
+  BOOST_TEST(static_cast<bool>(SharedByPointer));
+
+  // Converting again the definitions already imported, including the
+  // recursive struct, both behind a pointer and by value, produces the same
+  // types.
+  Importer.forgetReads();
+  BOOST_TEST((Importer.importType(*ByPointer) == SharedByPointer));
+  BOOST_TEST((Importer.importType(*ByValue) == SharedByValue));
+  BOOST_TEST((Importer.importType(*Struct) == importAlone(*Struct)));
+
+  Importer.forgetReads();
+  BOOST_TEST((Importer.importType(*Struct) == importAlone(*Struct)));
+  BOOST_TEST((Importer.importType(*ByValue) == SharedByValue));
+}
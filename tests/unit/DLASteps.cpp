@@ -7,6 +7,12 @@ bool init_unit_test();
 
 #include "boost/test/unit_test.hpp"
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "llvm/Support/raw_ostream.h"
+
 #include "revng-c/DataLayoutAnalysis/DLATypeSystem.h"
 
 #include "lib/DataLayoutAnalysis/Middleend/DLAStep.h"
@@ -807,3 +813,251 @@ BOOST_AUTO_TEST_CASE(DeduplicateFields_commonNodeAsymmetricCollapse) {
   checkNode(TS, NodeC, 10, AllChildrenAreNonInterfering, { 3 });
   checkNode(TS, NodeA1, 8, AllChildrenAreNonInterfering, { 4, 5, 6, 7 });
 }
+
+/// Test that running a step on the partitions of a type system, and absorbing
+/// them back, gives the same result as running it on the whole type system
+BOOST_AUTO_TEST_CASE(PartitionAndAbsorb) {
+  dla::LayoutTypeSystem TS;
+
+  // First component: an equality SCC with a pointer edge
+  LTSN *Root = createRoot(TS);
+  LTSN *Node1 = addEquality(TS, Root);
+  LTSN *Node2 = addEquality(TS, Root);
+  LTSN *Node3 = addEquality(TS, Node2);
+  TS.addEqualityLink(Node1, Node3);
+  LTSN *PtrNode = createRoot(TS);
+  TS.addPointerLink(Node3, PtrNode);
+
+  // Second component: a struct with two fields, one of which is in an equality
+  // SCC with another node
+  LTSN *Struct = createRoot(TS, 16);
+  LTSN *Field1 = addInstanceAtOffset(TS, Struct, 0, 8);
+  LTSN *Field2 = addInstanceAtOffset(TS, Struct, 8, 8);
+  LTSN *Other = addEquality(TS, Field2, 8);
+
+  auto Partitions = TS.partition(2);
+  revng_check(Partitions.size() == 2);
+  revng_check(Partitions[0].TS->getNumLayouts()
+                + Partitions[1].TS->getNumLayouts()
+              == 9);
+  for (const LTSN *N : TS.getLayoutsRange())
+    revng_check(N->Successors.empty() and N->Predecessors.empty());
+
+  VerifyLog.enable();
+  for (auto &Partition : Partitions) {
+    // Components are never split
+    revng_check(Partition.TS->getNumLayouts() == 4
+                or Partition.TS->getNumLayouts() == 5);
+    revng_check(Partition.OriginalIDs.size()
+                == Partition.TS->getNumLayouts());
+
+    dla::StepManager SM;
+    revng_check(SM.addStep<CollapseEqualitySCC>());
+    SM.run(*Partition.TS);
+  }
+
+  TS.absorb(std::move(Partitions));
+  revng_check(TS.verifyConsistency());
+
+  dla::VectEqClasses &Eq = TS.getEqClasses();
+  Eq.compress();
+
+  revng_check(TS.getNumLayouts() == 5);
+  revng_check(Eq.getNumElements() == 9);
+  revng_check(Eq.getNumClasses() == 5);
+  checkNode(TS, Node2, 0, InterferingChildrenInfo::Unknown, { 0, 1, 2, 3 });
+  checkNode(TS, PtrNode, 0, InterferingChildrenInfo::Unknown, { 4 });
+  checkNode(TS, Struct, 16, InterferingChildrenInfo::Unknown, { 5 });
+  checkNode(TS, Field1, 8, InterferingChildrenInfo::Unknown, { 6 });
+  bool Field2Survived = llvm::is_contained(TS.getLayoutsRange(), Field2);
+  revng_check(Field2Survived
+              != llvm::is_contained(TS.getLayoutsRange(), Other));
+  LTSN *MergedField = Field2Survived ? Field2 : Other;
+  checkNode(TS, MergedField, 8, InterferingChildrenInfo::Unknown, { 7, 8 });
+
+  revng_check(Node2->Successors.size() == 1);
+  revng_check(Node2->Successors.begin()->first == PtrNode);
+  revng_check(Struct->Successors.size() == 2);
+}
+
+/// Build a type system made of several independent components, each one
+/// exercising a different part of the middle-end
+static void buildComponents(LayoutTypeSystem &TS) {
+  // An equality SCC with a pointer edge
+  LTSN *Root = createRoot(TS, 8);
+  LTSN *Node1 = addEquality(TS, Root, 8);
+  LTSN *Node2 = addEquality(TS, Root, 8);
+  TS.addEqualityLink(Node1, Node2);
+  TS.addPointerLink(Node2, createRoot(TS, 16));
+
+  // A struct with two fields, one of which is in an equality SCC with another
+  // node
+  LTSN *Struct = createRoot(TS, 16);
+  addInstanceAtOffset(TS, Struct, 0, 8);
+  LTSN *Field = addInstanceAtOffset(TS, Struct, 8, 8);
+  addEquality(TS, Field, 8);
+
+  // An instance-at-offset-0 loop
+  LTSN *Loop = createRoot(TS, 8);
+  LTSN *LoopChild = addInstanceAtOffset(TS, Loop, 0, 8);
+  TS.addInstanceLink(LoopChild, Loop, OffsetExpression{});
+
+  // A struct containing an array, pointed by two different pointers
+  LTSN *Outer = createRoot(TS, 40);
+  addInstanceAtOffset(TS, Outer, 0, 8);
+  LTSN *Element = TS.createArtificialLayoutType();
+  Element->Size = 8;
+  OffsetExpression ArrayOE(8);
+  ArrayOE.Strides = { 8U };
+  ArrayOE.TripCounts = { 4U };
+  TS.addInstanceLink(Outer, Element, std::move(ArrayOE));
+  TS.addPointerLink(createRoot(TS, 8), Outer);
+  TS.addPointerLink(createRoot(TS, 8), Outer);
+
+  // Two structs sharing the same field layout
+  for (unsigned I = 0; I < 2; ++I) {
+    LTSN *Duplicate = createRoot(TS, 24);
+    addInstanceAtOffset(TS, Duplicate, 0, 8);
+    addInstanceAtOffset(TS, Duplicate, 16, 8);
+  }
+}
+
+/// Describe \p TS in a way that does not depend on the IDs of the nodes
+/// created by the middle-end: each node is identified by the nodes, among the
+/// first \p InitialCount, that have been merged into it
+static std::vector<std::string> describe(LayoutTypeSystem &TS,
+                                         unsigned InitialCount) {
+  dla::VectEqClasses &Eq = TS.getEqClasses();
+  Eq.compress();
+
+  const auto Label = [&](const LTSN *N) {
+    std::string Result;
+    for (unsigned ID : Eq.computeEqClass(N->ID))
+      if (ID < InitialCount)
+        Result += std::to_string(ID) + ",";
+    return Result.empty() ? std::string("artificial") : Result;
+  };
+
+  std::vector<std::string> Result;
+  for (unsigned ID = 0; ID < InitialCount; ++ID) {
+    std::string Line = std::to_string(ID) + ": ";
+    if (Eq.isRemoved(ID)) {
+      Line += "removed";
+    } else {
+      for (unsigned Other : Eq.computeEqClass(ID))
+        if (Other < InitialCount)
+          Line += std::to_string(Other) + ",";
+    }
+    Result.push_back(std::move(Line));
+  }
+
+  for (const LTSN *N : TS.getLayoutsRange()) {
+    std::vector<std::string> Successors;
+    for (const auto &[Child, Tag] : N->Successors) {
+      std::string Successor;
+      llvm::raw_string_ostream Stream(Successor);
+      Stream << dla::TypeLinkTag::toString(Tag->getKind()) << " ";
+      if (Tag->getKind() == dla::TypeLinkTag::LK_Instance)
+        Tag->getOffsetExpr().print(Stream);
+      Stream << " -> " << Label(Child);
+      Successors.push_back(std::move(Successor));
+    }
+    llvm::sort(Successors);
+
+    std::string Line = Label(N) + " size " + std::to_string(N->Size)
+                       + " info " + std::to_string(N->InterferingInfo)
+                       + " non-scalar " + std::to_string(N->NonScalar);
+    for (const std::string &Successor : Successors)
+      Line += "\n  " + Successor;
+    Result.push_back(std::move(Line));
+  }
+
+  llvm::sort(Result);
+  return Result;
+}
+
+/// Test that running the middle-end on multiple threads gives the same result
+/// as running it serially
+BOOST_AUTO_TEST_CASE(ParallelMiddleendMatchesSerial) {
+  VerifyLog.enable();
+
+  dla::LayoutTypeSystem Serial;
+  buildComponents(Serial);
+  const unsigned InitialCount = Serial.getEqClasses().getNumElements();
+  dla::runMiddleend(Serial, 8, 1);
+  std::vector<std::string> Expected = describe(Serial, InitialCount);
+
+  for (unsigned Threads : { 2U, 3U, 8U }) {
+    dla::LayoutTypeSystem Parallel;
+    buildComponents(Parallel);
+    revng_check(Parallel.getEqClasses().getNumElements() == InitialCount);
+    dla::runMiddleend(Parallel, 8, Threads);
+    revng_check(Parallel.verifyConsistency());
+
+    BOOST_TEST(describe(Parallel, InitialCount) == Expected,
+               boost::test_tools::per_element());
+  }
+}
+
+/// Test that the nodes are visited in ID order, skipping the merged and
+/// removed ones, and including the ones created while iterating
+BOOST_AUTO_TEST_CASE(NodesAreVisitedInIDOrder) {
+  dla::LayoutTypeSystem TS;
+  auto Nodes = TS.createArtificialLayoutTypes(6);
+
+  TS.mergeNodes({ Nodes[4], Nodes[1] });
+  TS.removeNode(Nodes[2]);
+  revng_check(TS.getNumLayouts() == 4);
+
+  std::vector<uint64_t> Visited;
+  for (LTSN *N : llvm::nodes(&TS)) {
+    Visited.push_back(N->ID);
+    revng_check(TS.getLayout(N->ID) == N);
+    if (N->ID == 3)
+      TS.createArtificialLayoutType();
+  }
+
+  revng_check((Visited == std::vector<uint64_t>{ 0, 3, 4, 5, 6 }));
+  revng_check(TS.getLayout(1) == nullptr);
+  revng_check(TS.getLayout(2) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(GenerationTracksChanges) {
+  dla::LayoutTypeSystem TS;
+  uint64_t Generation = TS.getGeneration();
+  const auto HasChanged = [&TS, &Generation]() {
+    bool Result = TS.getGeneration() != Generation;
+    Generation = TS.getGeneration();
+    return Result;
+  };
+
+  LTSN *Root = createRoot(TS);
+  revng_check(HasChanged());
+  LTSN *Child = addInstanceAtOffset(TS, Root, 0U, 8U);
+  revng_check(HasChanged());
+
+  // Adding an existing edge again changes nothing
+  TS.addInstanceLink(Root, Child, OffsetExpression{});
+  revng_check(not HasChanged());
+
+  // The steps run on a type system they have already processed do not change
+  // it
+  ComputeUpperMemberAccesses UpperMemberAccesses;
+  revng_check(UpperMemberAccesses.runOnTypeSystem(TS));
+  revng_check(HasChanged());
+  revng_check(not UpperMemberAccesses.runOnTypeSystem(TS));
+  revng_check(not HasChanged());
+
+  // This step does not report computing the InterferingInfo, but the
+  // generation tracks it
+  ComputeNonInterferingComponents NonInterferingComponents;
+  revng_check(not NonInterferingComponents.runOnTypeSystem(TS));
+  revng_check(HasChanged());
+  revng_check(not NonInterferingComponents.runOnTypeSystem(TS));
+  revng_check(not HasChanged());
+
+  TS.eraseEdge(Root, Root->Successors.begin());
+  revng_check(HasChanged());
+  TS.removeNode(Child);
+  revng_check(HasChanged());
+}
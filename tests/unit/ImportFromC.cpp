@@ -0,0 +1,111 @@
+/// \file ImportFromC.cpp
+/// Tests that running import-from-c multiple times on the same input, and
+/// therefore reusing the precompiled model headers, leads to the same results
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#define BOOST_TEST_MODULE ImportFromC
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include <string>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include "revng/Model/Binary.h"
+#include "revng/Support/Assert.h"
+#include "revng/Support/YAMLTraits.h"
+#include "revng/TupleTree/TupleTree.h"
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+
+#include "lib/ImportFromC/ImportFromCAnalysis.h"
+
+struct ArgsFixture {
+  int argc;
+  char **argv;
+
+  ArgsFixture() :
+    argc(boost::unit_test::framework::master_test_suite().argc),
+    argv(boost::unit_test::framework::master_test_suite().argv) {}
+};
+
+static std::string readFile(const std::string &Path) {
+  auto MaybeBuffer = llvm::MemoryBuffer::getFile(Path);
+  revng_check(MaybeBuffer);
+  return MaybeBuffer->get()->getBuffer().str();
+}
+
+/// The location in the `type-to-edit.location` file, skipping comments
+static std::string readLocation(const std::string &Path) {
+  std::string Contents = readFile(Path);
+  llvm::SmallVector<llvm::StringRef, 8> Lines;
+  llvm::StringRef(Contents).split(Lines, '\n');
+  for (llvm::StringRef Line : Lines)
+    if (not Line.empty() and not Line.startswith("#"))
+      return Line.str();
+  return "";
+}
+
+/// Import the edit in \p Directory into a fresh copy of its input model
+///
+/// \return the resulting model or the error, serialized
+static std::string importOnce(const std::string &Directory) {
+  auto MaybeModel = TupleTree<model::Binary>::fromFile(Directory
+                                                       + "/input-model.yml");
+  revng_check(MaybeModel);
+  TupleTree<model::Binary> Model = std::move(*MaybeModel);
+
+  std::string Location = readLocation(Directory + "/type-to-edit.location");
+  std::string CCode = readFile(Directory + "/edit.c");
+  if (llvm::Error Error = importFromC(Model, Location, CCode))
+    return "error: " + llvm::toString(std::move(Error));
+
+  return toString(*Model);
+}
+
+static void runTest(const std::string &Directory) {
+  // The first run prints and precompiles the model header, the following ones
+  // reuse the precompiled header
+  std::string First = importOnce(Directory);
+  BOOST_TEST(importOnce(Directory) == First);
+  BOOST_TEST(importOnce(Directory) == First);
+}
+
+BOOST_FIXTURE_TEST_SUITE(FixtureTestSuite, ArgsFixture)
+
+BOOST_AUTO_TEST_CASE(Struct) {
+  runTest(std::string(argv[1]) + "struct");
+}
+
+BOOST_AUTO_TEST_CASE(Union) {
+  runTest(std::string(argv[1]) + "union");
+}
+
+BOOST_AUTO_TEST_CASE(Enum) {
+  runTest(std::string(argv[1]) + "enum");
+}
+
+BOOST_AUTO_TEST_CASE(Typedef) {
+  runTest(std::string(argv[1]) + "typedef");
+}
+
+BOOST_AUTO_TEST_CASE(CABIFunction) {
+  runTest(std::string(argv[1]) + "cft");
+}
+
+BOOST_AUTO_TEST_CASE(RawFunction) {
+  runTest(std::string(argv[1]) + "rft");
+}
+
+BOOST_AUTO_TEST_CASE(StructWithATypo) {
+  std::string Directory = std::string(argv[1]) + "struct-with-a-typo";
+  BOOST_TEST(llvm::StringRef(importOnce(Directory)).startswith("error: "));
+  runTest(Directory);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,129 @@
+/// \file ImportFromCModelEdit.cpp
+/// Tests rolling back and verifying the in-place edits of import-from-c
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#define BOOST_TEST_MODULE ImportFromCModelEdit
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "revng/Model/Binary.h"
+#include "revng/Model/VerifyHelper.h"
+#include "revng/Support/Assert.h"
+#include "revng/Support/YAMLTraits.h"
+#include "revng/TupleTree/TupleTree.h"
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+
+#include "lib/ImportFromC/ImportFromCHelpers.h"
+#include "lib/ImportFromC/ModelEdit.h"
+
+namespace {
+
+struct Fixture {
+  TupleTree<model::Binary> Model;
+
+  model::TypeDefinition::Key Struct;
+  MetaAddress Entry = MetaAddress::fromString("0x1000:Code_x86_64");
+  MetaAddress SegmentStart = MetaAddress::fromString("0x2000:Generic64");
+
+  Fixture() {
+    Model->Architecture() = model::Architecture::x86_64;
+
+    // struct S { int64_t A; int64_t B; };
+    auto [StructDefinition, StructType] = Model->makeStructDefinition(16);
+    StructDefinition.addField(0, model::PrimitiveType::makeSigned(8));
+    StructDefinition.addField(8, model::PrimitiveType::makeSigned(8));
+    Struct = StructDefinition.key();
+
+    // void F(int64_t);
+    auto [Prototype, PrototypeType] = Model->makeCABIFunctionDefinition();
+    Prototype.ABI() = model::ABI::SystemV_x86_64;
+    Prototype.Arguments()[0].Type() = model::PrimitiveType::makeSigned(8);
+
+    model::Function &Function = Model->Functions()[Entry];
+    Function.Prototype() = PrototypeType.copy();
+    Function.StackFrameType() = StructType.copy();
+
+    model::Segment &Segment = Model->Segments()[{ SegmentStart, 16 }];
+    Segment.Type() = StructType.copy();
+
+    revng_check(Model->verify(true));
+  }
+
+  model::StructDefinition &getStruct() {
+    return llvm::cast<model::StructDefinition>(*Model->TypeDefinitions()
+                                                  .at(Struct));
+  }
+
+  /// Check that verifying only what \p Edit touched agrees with verifying the
+  /// whole model
+  bool verify(const ModelEdit &Edit) {
+    model::VerifyHelper Partial(false);
+    bool Result = Edit.verify(Partial);
+
+    model::VerifyHelper Full(false);
+    BOOST_TEST(Result == Model->verify(Full));
+    return Result;
+  }
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(RollbackRestoresEditedType, Fixture) {
+  std::string Before = toString(*Model);
+
+  ModelEdit Edit(Model);
+  Edit.editType(getStruct(), collectDependentTypes(getStruct(), Model));
+
+  getStruct().Fields().at(8).Type() = model::PrimitiveType::makeUnsigned(8);
+  Model->makeStructDefinition(8);
+  BOOST_TEST(toString(*Model) != Before);
+
+  Edit.rollback();
+  BOOST_TEST(toString(*Model) == Before);
+}
+
+BOOST_FIXTURE_TEST_CASE(RollbackRestoresEditedFunction, Fixture) {
+  std::string Before = toString(*Model);
+
+  ModelEdit Edit(Model);
+  Edit.editFunction(Model->Functions().at(Entry));
+
+  auto [NewPrototype, NewType] = Model->makeCABIFunctionDefinition();
+  NewPrototype.ABI() = model::ABI::SystemV_x86_64;
+  Model->Functions().at(Entry).Prototype() = NewType.copy();
+  BOOST_TEST(toString(*Model) != Before);
+
+  Edit.rollback();
+  BOOST_TEST(toString(*Model) == Before);
+}
+
+BOOST_FIXTURE_TEST_CASE(ValidEditVerifies, Fixture) {
+  ModelEdit Edit(Model);
+  Edit.editType(getStruct(), collectDependentTypes(getStruct(), Model));
+
+  getStruct().Fields().at(8).Type() = model::PrimitiveType::makeUnsigned(8);
+  BOOST_TEST(verify(Edit));
+}
+
+BOOST_FIXTURE_TEST_CASE(EditBreakingSegmentDoesNotVerify, Fixture) {
+  ModelEdit Edit(Model);
+  Edit.editType(getStruct(), collectDependentTypes(getStruct(), Model));
+
+  // The struct is still valid on its own, but it no longer fits the segment
+  getStruct().Size() = 32;
+  BOOST_TEST(getStruct().verify(true));
+  BOOST_TEST(not verify(Edit));
+}
+
+BOOST_FIXTURE_TEST_CASE(EditBreakingFunctionDoesNotVerify, Fixture) {
+  ModelEdit Edit(Model);
+  Edit.editFunction(Model->Functions().at(Entry));
+
+  // Using a struct as a prototype
+  auto StructType = Model->makeType(Struct);
+  Model->Functions().at(Entry).Prototype() = std::move(StructType);
+  BOOST_TEST(not verify(Edit));
+}
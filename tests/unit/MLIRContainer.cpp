@@ -0,0 +1,226 @@
+/// \file MLIRContainer.cpp
+/// Tests for the container of MLIR modules
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <chrono>
+#include <string>
+
+#define BOOST_TEST_MODULE MLIRContainer
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng-c/mlir/Dialect/Clift/Utils/Helpers.h"
+#include "revng-c/mlir/Pipes/MLIRContainer.h"
+
+using revng::pipes::MLIRContainer;
+
+static std::string getEntry(unsigned Index) {
+  uint64_t Address = 0x400000 + 16 * Index;
+  return "0x" + llvm::utohexstr(Address, /* LowerCase */ true)
+         + ":Code_x86_64";
+}
+
+/// A module with \p Count target functions, each using a different type, so
+/// that removing a function leaves some garbage in the context
+static std::string makeModule(unsigned Count) {
+  std::string Result;
+  llvm::raw_string_ostream Out(Result);
+  Out << "module {\n";
+  for (unsigned I = 0; I < Count; ++I) {
+    Out << "  llvm.func @f" << I << "(%arg0: !llvm.array<" << (I + 1)
+        << " x i8>) attributes {\"" << FunctionEntryMDName << "\" = \""
+        << getEntry(I) << "\"} {\n"
+        << "    llvm.return\n"
+        << "  }\n";
+  }
+  Out << "}\n";
+  return Result;
+}
+
+static void load(MLIRContainer &Container, unsigned Count) {
+  auto Buffer = llvm::MemoryBuffer::getMemBuffer(makeModule(Count));
+  llvm::Error Error = Container.deserialize(*Buffer);
+  BOOST_REQUIRE(not Error);
+}
+
+static std::string toBytecode(const MLIRContainer &Container) {
+  std::string Result;
+  llvm::raw_string_ostream Out(Result);
+  llvm::Error Error = Container.serialize(Out);
+  BOOST_REQUIRE(not Error);
+  return Out.str();
+}
+
+static void loadBytecode(MLIRContainer &Container, llvm::StringRef Bytecode) {
+  auto Buffer = llvm::MemoryBuffer::getMemBuffer(Bytecode, "bytecode", false);
+  llvm::Error Error = Container.deserialize(*Buffer);
+  BOOST_REQUIRE(not Error);
+}
+
+static pipeline::Target makeTarget(unsigned Index) {
+  return pipeline::Target(getEntry(Index), revng::kinds::MLIRFunctionKind);
+}
+
+static pipeline::TargetsList makeTargets(unsigned Begin, unsigned End) {
+  pipeline::TargetsList::List List;
+  for (unsigned I = Begin; I < End; ++I)
+    List.push_back(makeTarget(I));
+  llvm::sort(List);
+  return pipeline::TargetsList(std::move(List));
+}
+
+static size_t countTargets(const MLIRContainer &Container) {
+  size_t Result = 0;
+  for (const pipeline::Target &Target : Container.enumerate()) {
+    (void) Target;
+    ++Result;
+  }
+  return Result;
+}
+
+static MLIRContainer &asMLIR(pipeline::ContainerBase &Container) {
+  return static_cast<MLIRContainer &>(Container);
+}
+
+BOOST_AUTO_TEST_CASE(RemoveOnlyRemovesTheRequestedTargets) {
+  MLIRContainer Container("mlir");
+  load(Container, 8);
+  BOOST_TEST(countTargets(Container) == 8);
+
+  BOOST_TEST(Container.remove(makeTargets(2, 4)));
+  BOOST_TEST(countTargets(Container) == 6);
+  BOOST_TEST(not Container.enumerate().contains(makeTarget(2)));
+  BOOST_TEST(Container.enumerate().contains(makeTarget(4)));
+
+  // Removing functions that are not there does nothing
+  BOOST_TEST(not Container.remove(makeTargets(2, 4)));
+  BOOST_TEST(countTargets(Container) == 6);
+}
+
+BOOST_AUTO_TEST_CASE(CloneFilteredSharesTheContext) {
+  MLIRContainer Container("mlir");
+  load(Container, 8);
+
+  auto Clone = Container.cloneFiltered(makeTargets(0, 3));
+  MLIRContainer &Filtered = asMLIR(*Clone);
+  BOOST_TEST(Filtered.getContext() == Container.getContext());
+  BOOST_TEST(countTargets(Filtered) == 3);
+
+  // Merging the clone back replaces the functions with the same name
+  BOOST_TEST(Container.remove(makeTargets(0, 8)));
+  BOOST_TEST(countTargets(Container) == 0);
+  Container.mergeBackImpl(std::move(Filtered));
+  BOOST_TEST(countTargets(Container) == 3);
+  BOOST_TEST(Container.enumerate().contains(makeTarget(1)));
+}
+
+BOOST_AUTO_TEST_CASE(MergeFromAnotherContext) {
+  MLIRContainer Container("mlir");
+  load(Container, 4);
+
+  MLIRContainer Other("mlir");
+  load(Other, 8);
+  BOOST_TEST(Other.remove(makeTargets(0, 6)));
+  BOOST_TEST(Other.getContext() != Container.getContext());
+
+  Container.mergeBackImpl(std::move(Other));
+  BOOST_TEST(countTargets(Container) == 6);
+}
+
+BOOST_AUTO_TEST_CASE(LazyDeserialization) {
+  MLIRContainer Original("mlir");
+  load(Original, 8);
+  std::string Bytecode = toBytecode(Original);
+
+  // Functions whose body has not been loaded yet are still targets
+  MLIRContainer Container("mlir");
+  loadBytecode(Container, Bytecode);
+  BOOST_TEST(countTargets(Container) == 8);
+
+  auto Clone = Container.cloneFiltered(makeTargets(2, 3));
+  BOOST_TEST(countTargets(asMLIR(*Clone)) == 1);
+  BOOST_TEST(asMLIR(*Clone).enumerate().contains(makeTarget(2)));
+
+  BOOST_TEST(Container.remove(makeTargets(0, 2)));
+  BOOST_TEST(countTargets(Container) == 6);
+
+  // Serializing loads the bodies which have not been loaded yet
+  MLIRContainer Reloaded("mlir");
+  loadBytecode(Reloaded, toBytecode(Container));
+  BOOST_TEST(countTargets(Reloaded) == 6);
+
+  size_t Defined = 0;
+  Reloaded.getModule().walk([&](mlir::FunctionOpInterface F) {
+    if (not F.isExternal())
+      ++Defined;
+  });
+  BOOST_TEST(Defined == 6);
+}
+
+BOOST_AUTO_TEST_CASE(RemoveAndMergeBenchmark) {
+  using Clock = std::chrono::steady_clock;
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+
+  for (unsigned Count : { 250, 1000, 4000 }) {
+    MLIRContainer Container("mlir");
+    load(Container, Count);
+
+    // What each operation used to cost: a full bytecode round trip
+    auto RoundTripStart = Clock::now();
+    {
+      std::string Bytecode;
+      llvm::raw_string_ostream Out(Bytecode);
+      BOOST_REQUIRE(not Container.serialize(Out));
+      auto Buffer = llvm::MemoryBuffer::getMemBuffer(Out.str());
+      MLIRContainer Copy("mlir");
+      BOOST_REQUIRE(not Copy.deserialize(*Buffer));
+    }
+    auto RoundTrip = duration_cast<microseconds>(Clock::now()
+                                                 - RoundTripStart);
+
+    // Open a serialized module and extract a single function from it
+    std::string Bytecode = toBytecode(Container);
+    auto ExtractStart = Clock::now();
+    {
+      MLIRContainer Copy("mlir");
+      loadBytecode(Copy, Bytecode);
+      std::string Extracted;
+      llvm::raw_string_ostream Out(Extracted);
+      BOOST_REQUIRE(not Copy.extractOne(Out, makeTarget(0)));
+    }
+    auto Extract = duration_cast<microseconds>(Clock::now() - ExtractStart);
+
+    // Invalidate and recompute a single function
+    auto Start = Clock::now();
+    {
+      auto Clone = Container.cloneFiltered(makeTargets(0, 1));
+      BOOST_TEST(Container.remove(makeTargets(0, 1)));
+      Container.mergeBackImpl(std::move(asMLIR(*Clone)));
+    }
+    auto SingleFunction = duration_cast<microseconds>(Clock::now() - Start);
+    BOOST_TEST(countTargets(Container) == Count);
+
+    // Invalidate most of the functions, which triggers a garbage collection
+    Start = Clock::now();
+    BOOST_TEST(Container.remove(makeTargets(0, Count - Count / 4)));
+    auto RemoveMost = duration_cast<microseconds>(Clock::now() - Start);
+    BOOST_TEST(countTargets(Container) == Count / 4);
+
+    BOOST_TEST_MESSAGE(Count << " functions");
+    BOOST_TEST_MESSAGE("  bytecode round trip: " << RoundTrip.count() << "us");
+    BOOST_TEST_MESSAGE("  open and extract one function: " << Extract.count()
+                                                           << "us");
+    BOOST_TEST_MESSAGE("  clone, remove and merge back one function: "
+                       << SingleFunction.count() << "us");
+    BOOST_TEST_MESSAGE("  remove 3/4 of the functions: " << RemoveMost.count()
+                                                         << "us");
+  }
+}
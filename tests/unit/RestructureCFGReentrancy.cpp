@@ -0,0 +1,363 @@
+/// \file RestructureCFGReentrancy.cpp
+/// Tests that combing different regions, and restructuring different
+/// functions, concurrently gives the same results as doing it serially
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MODULE RestructureCFGReentrancy
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng/Support/Assert.h"
+#include "revng/Support/Debug.h"
+#include "revng/UnitTestHelpers/DotGraphObject.h"
+
+#include "revng-c/RestructureCFG/ASTNode.h"
+#include "revng-c/RestructureCFG/ASTTree.h"
+#include "revng-c/RestructureCFG/BasicBlockNode.h"
+#include "revng-c/RestructureCFG/BasicBlockNodeImpl.h"
+#include "revng-c/RestructureCFG/ExprNode.h"
+#include "revng-c/RestructureCFG/RegionCFGTree.h"
+#include "revng-c/RestructureCFG/RegionCFGTreeImpl.h"
+#include "revng-c/RestructureCFG/RestructureCFG.h"
+#include "revng-c/RestructureCFG/RestructureContext.h"
+
+using namespace llvm;
+
+template<>
+struct WeightTraits<DotNode *> {
+  static inline size_t getWeight(DotNode *) { return 1; }
+};
+
+struct ArgsFixture {
+  int argc;
+  char **argv;
+
+  ArgsFixture() :
+    argc(boost::unit_test::framework::master_test_suite().argc),
+    argv(boost::unit_test::framework::master_test_suite().argv) {}
+};
+
+static constexpr unsigned ThreadCount = 8;
+static constexpr unsigned Iterations = 64;
+
+static const std::vector<std::string> GraphNames = { "trivial.dot",
+                                                     "simple.dot",
+                                                     "comb.dot",
+                                                     "crossed.dot" };
+
+/// A combed graph, together with the `DotGraph` owning its original nodes
+struct CombedGraph {
+  DotGraph Dot;
+  RegionCFG<DotNode *> Region;
+};
+
+static std::unique_ptr<CombedGraph> comb(const std::string &FileName) {
+  auto Result = std::make_unique<CombedGraph>();
+  Result->Dot.parseDotFromFile(FileName, "entry");
+  Result->Region.initialize(&Result->Dot);
+  Result->Region.inflate();
+  return Result;
+}
+
+/// Functions with loops, multiple exits and irreducible control flow, which
+/// make restructureCFG comb, untangle and add dispatchers
+static const char *const FunctionsIR = R"LLVM(
+define i64 @loop_with_two_exits(i64 %a, i1 %c, i1 %d) {
+entry:
+  br label %head
+
+head:
+  %i = phi i64 [ 0, %entry ], [ %next, %latch ]
+  br i1 %c, label %body, label %exit1
+
+body:
+  %next = add i64 %i, 1
+  br i1 %d, label %latch, label %exit2
+
+latch:
+  br label %head
+
+exit1:
+  ret i64 %i
+
+exit2:
+  ret i64 %next
+}
+
+define void @irreducible(i1 %c, i1 %d, i1 %e) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br i1 %d, label %b, label %exit
+
+b:
+  br i1 %e, label %a, label %exit
+
+exit:
+  ret void
+}
+
+define i64 @crossed(i1 %c, i1 %d, i1 %e) {
+entry:
+  br i1 %c, label %left, label %right
+
+left:
+  br i1 %d, label %join1, label %join2
+
+right:
+  br i1 %e, label %join1, label %join2
+
+join1:
+  br label %exit
+
+join2:
+  br label %exit
+
+exit:
+  %r = phi i64 [ 1, %join1 ], [ 2, %join2 ]
+  ret i64 %r
+}
+
+define void @nested_loops_with_switch(i64 %x, i1 %c, i1 %d) {
+entry:
+  br label %outer
+
+outer:
+  br i1 %c, label %inner, label %exit
+
+inner:
+  switch i64 %x, label %outer [ i64 1, label %inner
+                                i64 2, label %case
+                                i64 3, label %exit ]
+
+case:
+  br i1 %d, label %inner, label %outer
+
+exit:
+  ret void
+}
+)LLVM";
+
+static void printExpr(const ExprNode *E, raw_ostream &OS) {
+  switch (E->getKind()) {
+  case ExprNode::NK_ValueCompare: {
+    auto *Compare = cast<ValueCompareNode>(E);
+    OS << "(value-compare " << Compare->getBasicBlock()->getName() << " "
+       << Compare->getComparison() << " " << Compare->getConstant() << ")";
+  } break;
+
+  case ExprNode::NK_LoopStateCompare: {
+    auto *Compare = cast<LoopStateCompareNode>(E);
+    OS << "(loop-state-compare " << Compare->getComparison() << " "
+       << Compare->getConstant() << ")";
+  } break;
+
+  case ExprNode::NK_Atomic:
+    OS << cast<AtomicNode>(E)->getConditionalBasicBlock()->getName();
+    break;
+
+  case ExprNode::NK_Not:
+    OS << "(not ";
+    printExpr(cast<NotNode>(E)->getNegatedNode(), OS);
+    OS << ")";
+    break;
+
+  case ExprNode::NK_And:
+  case ExprNode::NK_Or: {
+    auto [LHS, RHS] = cast<BinaryNode>(E)->getInternalNodes();
+    OS << (isa<AndNode>(E) ? "(and " : "(or ");
+    printExpr(LHS, OS);
+    OS << " ";
+    printExpr(RHS, OS);
+    OS << ")";
+  } break;
+
+  default:
+    revng_abort("Unexpected expression kind");
+  }
+}
+
+/// Print the structure of the AST rooted at \p N, with the names of the basic
+/// blocks it refers to, so that ASTs built on different copies of a function
+/// can be compared
+static void printAST(const ASTNode *N, raw_ostream &OS) {
+  if (N == nullptr) {
+    OS << "(none)";
+    return;
+  }
+
+  OS << "(" << N->getName();
+  switch (N->getKind()) {
+  case ASTNode::NK_Code:
+  case ASTNode::NK_Continue:
+  case ASTNode::NK_Break:
+  case ASTNode::NK_SwitchBreak:
+    break;
+
+  case ASTNode::NK_If: {
+    auto *If = cast<IfNode>(N);
+    OS << " if ";
+    printExpr(If->getCondExpr(), OS);
+    OS << " ";
+    printAST(If->getThen(), OS);
+    OS << " ";
+    printAST(If->getElse(), OS);
+  } break;
+
+  case ASTNode::NK_Scs:
+    OS << " loop ";
+    printAST(cast<ScsNode>(N)->getBody(), OS);
+    break;
+
+  case ASTNode::NK_List:
+    for (const ASTNode *Child : cast<SequenceNode>(N)->nodes()) {
+      OS << " ";
+      printAST(Child, OS);
+    }
+    break;
+
+  case ASTNode::NK_Set:
+    OS << " set " << cast<SetNode>(N)->getStateVariableValue();
+    break;
+
+  case ASTNode::NK_Switch: {
+    auto *Switch = cast<SwitchNode>(N);
+    OS << " switch";
+    if (const Value *Condition = Switch->getCondition())
+      OS << " " << Condition->getName();
+    for (const auto &[Labels, Case] : Switch->cases_const_range()) {
+      OS << " [";
+      for (uint64_t Label : Labels)
+        OS << " " << Label;
+      OS << " ] ";
+      printAST(Case, OS);
+    }
+  } break;
+
+  default:
+    revng_abort("Unexpected AST node kind");
+  }
+  OS << ")";
+}
+
+/// The printed AST and the combing statistics of each function in
+/// FunctionsIR
+struct RestructureResult {
+  std::vector<std::string> ASTs;
+  std::vector<CombingStatistics> Statistics;
+
+  bool operator==(const RestructureResult &) const = default;
+};
+
+/// Parse FunctionsIR in a new LLVMContext, and restructure each function of it
+/// with its own RestructureContext
+static RestructureResult restructureAll() {
+  LLVMContext Context;
+  SMDiagnostic Error;
+  std::unique_ptr<Module> M = parseAssemblyString(FunctionsIR, Error, Context);
+  revng_check(M != nullptr);
+
+  RestructureResult Result;
+  for (Function &F : *M) {
+    ASTTree AST;
+    RestructureContext FunctionContext;
+    restructureCFG(F, AST, FunctionContext);
+
+    std::string Printed;
+    raw_string_ostream Stream(Printed);
+    printAST(AST.getRoot(), Stream);
+    Stream.flush();
+
+    Result.ASTs.push_back(std::move(Printed));
+    Result.Statistics.push_back(FunctionContext.Combing);
+  }
+
+  return Result;
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentRestructureMatchesSerial) {
+  RestructureResult Expected = restructureAll();
+  revng_check(Expected.ASTs.size() == 4);
+
+  std::vector<unsigned> Mismatches(ThreadCount, 0);
+  std::vector<std::thread> Threads;
+  for (unsigned ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex) {
+    Threads.emplace_back([&, ThreadIndex]() {
+      for (unsigned I = 0; I < Iterations; ++I)
+        if (not(restructureAll() == Expected))
+          ++Mismatches[ThreadIndex];
+    });
+  }
+
+  for (std::thread &Thread : Threads)
+    Thread.join();
+
+  for (unsigned ThreadMismatches : Mismatches)
+    BOOST_TEST(ThreadMismatches == 0);
+}
+
+BOOST_FIXTURE_TEST_SUITE(FixtureTestSuite, ArgsFixture)
+
+BOOST_AUTO_TEST_CASE(ConcurrentCombMatchesSerial) {
+  std::string DotPath = argv[1];
+
+  // Comb all the graphs serially, to obtain the reference results.
+  std::vector<std::unique_ptr<CombedGraph>> References;
+  for (const std::string &Name : GraphNames)
+    References.push_back(comb(DotPath + Name));
+
+  // Comb the same graphs over and over from many threads at the same time.
+  std::vector<unsigned> Mismatches(ThreadCount, 0);
+  std::vector<std::thread> Threads;
+  for (unsigned ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex) {
+    Threads.emplace_back([&, ThreadIndex]() {
+      for (unsigned I = 0; I < Iterations; ++I) {
+        for (size_t GraphIndex = 0; GraphIndex < GraphNames.size();
+             ++GraphIndex) {
+          auto Combed = comb(DotPath + GraphNames[GraphIndex]);
+          RegionCFG<DotNode *> &Expected = References[GraphIndex]->Region;
+
+          const RegionCFG<DotNode *> &Actual = Combed->Region;
+          bool Equivalent = Actual.isTopologicallyEquivalent(Expected);
+          bool SameStatistics = Actual.getStatistics()
+                                == Expected.getStatistics();
+          if (not Equivalent or not SameStatistics)
+            ++Mismatches[ThreadIndex];
+        }
+      }
+    });
+  }
+
+  for (std::thread &Thread : Threads)
+    Thread.join();
+
+  for (unsigned ThreadMismatches : Mismatches)
+    BOOST_TEST(ThreadMismatches == 0);
+}
+
+BOOST_AUTO_TEST_CASE(CombingStatisticsArePerRegion) {
+  std::string DotPath = argv[1];
+
+  // Combing a graph must not affect the statistics of any other graph.
+  auto First = comb(DotPath + "crossed.dot");
+  CombingStatistics Before = First->Region.getStatistics();
+  auto Second = comb(DotPath + "crossed.dot");
+  BOOST_TEST((First->Region.getStatistics() == Before));
+  BOOST_TEST((Second->Region.getStatistics() == Before));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,253 @@
+/// \file SimplifySCS.cpp
+/// Tests that the construction of the metaregions gives the same results as
+/// the original fixed-point implementation
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <chrono>
+#include <map>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#define BOOST_TEST_MODULE SimplifySCS
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "revng/UnitTestHelpers/DotGraphObject.h"
+
+#include "revng-c/RestructureCFG/BasicBlockNode.h"
+#include "revng-c/RestructureCFG/BasicBlockNodeImpl.h"
+#include "revng-c/RestructureCFG/MetaRegion.h"
+#include "revng-c/RestructureCFG/MetaRegionImpl.h"
+#include "revng-c/RestructureCFG/RegionCFGTree.h"
+#include "revng-c/RestructureCFG/RegionCFGTreeImpl.h"
+
+#include "lib/RestructureCFG/SimplifySCS.h"
+
+using BBNode = BasicBlockNode<DotNode *>;
+using Edge = BBNode::EdgeDescriptor;
+using NodeSet = std::set<BBNode *>;
+using Region = MetaRegion<DotNode *>;
+using RegionVector = std::vector<Region>;
+using HeadRegions = std::vector<std::pair<BBNode *, NodeSet>>;
+using HeadNodesMap = std::map<BBNode *, NodeSet>;
+
+//
+// The original implementations
+//
+
+static void referenceExpandNestedSCSs(HeadRegions &Regions,
+                                      HeadNodesMap &HeadSCSNodes) {
+  for (auto &[Head, Nodes] : Regions) {
+    NodeSet OldNodes;
+    do {
+      OldNodes = Nodes;
+      NodeSet AdditionalNodes;
+      for (BBNode *Node : Nodes)
+        if (Node != Head and HeadSCSNodes.contains(Node))
+          AdditionalNodes.insert(HeadSCSNodes[Node].begin(),
+                                 HeadSCSNodes[Node].end());
+      Nodes.insert(AdditionalNodes.begin(), AdditionalNodes.end());
+    } while (Nodes != OldNodes);
+  }
+}
+
+static void
+referenceSimplifySCSAbnormalRetreating(RegionVector &MetaRegions,
+                                       const std::vector<Edge> &Backedges) {
+  std::map<Edge, Region *> BackedgeRegion;
+  for (size_t I = 0; I < Backedges.size(); ++I)
+    BackedgeRegion[Backedges[I]] = &MetaRegions.at(I);
+
+  std::set<Region *> Blacklisted;
+  bool Changes = true;
+  while (Changes) {
+    Changes = false;
+    for (Region &Current : MetaRegions) {
+      if (Blacklisted.contains(&Current))
+        continue;
+
+      for (Edge Backedge : Backedges) {
+        bool FirstIn = Current.containsNode(Backedge.first);
+        bool SecondIn = Current.containsNode(Backedge.second);
+        if (FirstIn != SecondIn) {
+          Region *Other = BackedgeRegion.at(Backedge);
+          Current.mergeWith(*Other);
+          BackedgeRegion[Backedge] = &Current;
+          Blacklisted.insert(Other);
+          Changes = true;
+          break;
+        }
+      }
+
+      if (Changes)
+        break;
+    }
+  }
+
+  std::erase_if(MetaRegions, [&Blacklisted](Region &M) {
+    return Blacklisted.contains(&M);
+  });
+}
+
+static bool referenceMergeSCSStep(RegionVector &MetaRegions) {
+  for (auto It1 = MetaRegions.begin(); It1 != MetaRegions.end(); ++It1) {
+    for (auto It2 = std::next(It1); It2 != MetaRegions.end(); ++It2) {
+      bool Intersects = It1->intersectsWith(*It2);
+      bool IsIncluded = It1->isSubSet(*It2);
+      bool IsIncludedReverse = It2->isSubSet(*It1);
+      bool AreEquivalent = It1->nodesEquality(*It2);
+      if (Intersects
+          and ((not IsIncluded and not IsIncludedReverse) or AreEquivalent)) {
+        It1->mergeWith(*It2);
+        MetaRegions.erase(It2);
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+static void referenceSimplifySCS(RegionVector &MetaRegions) {
+  while (referenceMergeSCSStep(MetaRegions))
+    ;
+}
+
+//
+// Synthetic loop nests
+//
+
+/// A set of SCSs over a chain of nodes. Each backedge goes from a node to one
+/// that comes before it, and its SCS contains the nodes in between, except
+/// for a few randomly chosen ones, to obtain irreducible-looking shapes.
+struct LoopNest {
+  RegionCFG<DotNode *> Graph;
+  std::vector<BBNode *> Nodes;
+  std::vector<Edge> Backedges;
+  HeadRegions Regions;
+  HeadNodesMap HeadSCSNodes;
+
+  LoopNest(unsigned Seed, unsigned NodeCount, unsigned BackedgeCount) {
+    std::mt19937 Generator(Seed);
+    auto Random = [&Generator](unsigned Max) {
+      return std::uniform_int_distribution<unsigned>(0, Max)(Generator);
+    };
+
+    for (unsigned I = 0; I < NodeCount; ++I)
+      Nodes.push_back(Graph.addArtificialNode());
+
+    std::set<Edge> Seen;
+    while (Backedges.size() < BackedgeCount) {
+      unsigned Source = Random(NodeCount - 1);
+      unsigned Target = Random(Source);
+      Edge Backedge{ Nodes[Source], Nodes[Target] };
+      if (not Seen.insert(Backedge).second)
+        continue;
+
+      NodeSet SCS;
+      for (unsigned I = Target; I <= Source; ++I)
+        if (I == Target or I == Source or Random(7) != 0)
+          SCS.insert(Nodes[I]);
+
+      Backedges.push_back(Backedge);
+      HeadSCSNodes[Backedge.second].insert(SCS.begin(), SCS.end());
+      Regions.push_back({ Backedge.second, std::move(SCS) });
+    }
+  }
+};
+
+static RegionVector makeMetaRegions(const HeadRegions &Regions) {
+  RegionVector Result;
+  int Index = 1;
+  for (const auto &[Head, Nodes] : Regions) {
+    NodeSet Copy = Nodes;
+    Result.push_back(Region(Index++, Copy, true));
+  }
+  return Result;
+}
+
+static std::vector<NodeSet> toNodeSets(const RegionVector &MetaRegions) {
+  std::vector<NodeSet> Result;
+  for (const Region &M : MetaRegions)
+    Result.push_back(M.getNodes());
+  return Result;
+}
+
+/// Run all the steps with both implementations, checking that they agree
+static void checkLoopNest(LoopNest &Nest) {
+  HeadRegions Expected = Nest.Regions;
+  referenceExpandNestedSCSs(Expected, Nest.HeadSCSNodes);
+  HeadRegions Actual = Nest.Regions;
+  expandNestedSCSs(Actual, Nest.HeadSCSNodes);
+  BOOST_TEST((Actual == Expected));
+
+  RegionVector ExpectedRegions = makeMetaRegions(Expected);
+  referenceSimplifySCSAbnormalRetreating(ExpectedRegions, Nest.Backedges);
+  RegionVector ActualRegions = makeMetaRegions(Expected);
+  simplifySCSAbnormalRetreating(ActualRegions, Nest.Backedges);
+  BOOST_TEST((toNodeSets(ActualRegions) == toNodeSets(ExpectedRegions)));
+
+  referenceSimplifySCS(ExpectedRegions);
+  simplifySCS(ActualRegions);
+  BOOST_TEST((toNodeSets(ActualRegions) == toNodeSets(ExpectedRegions)));
+}
+
+BOOST_AUTO_TEST_CASE(RandomLoopNestsMatchReference) {
+  for (unsigned Seed = 0; Seed < 200; ++Seed) {
+    LoopNest Nest(Seed, 8 + Seed % 40, 1 + Seed % 24);
+    checkLoopNest(Nest);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SimplifySCSMergesFirstPair) {
+  LoopNest Nest(0, 6, 0);
+  auto &N = Nest.Nodes;
+  NodeSet A = { N[0], N[1] };
+  NodeSet B = { N[1], N[2] };
+  NodeSet C = { N[3], N[4] };
+  NodeSet D = { N[3], N[4] };
+  NodeSet E = { N[3] };
+  RegionVector MetaRegions = makeMetaRegions(
+    { { N[0], A }, { N[1], B }, { N[3], C }, { N[3], D }, { N[3], E } });
+  simplifySCS(MetaRegions);
+
+  // A and B overlap, C and D are equal, and E is nested in both of them
+  std::vector<NodeSet> Expected = { { N[0], N[1], N[2] }, C, E };
+  BOOST_TEST((toNodeSets(MetaRegions) == Expected));
+}
+
+BOOST_AUTO_TEST_CASE(LargeLoopNestBenchmark) {
+  using Clock = std::chrono::steady_clock;
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+
+  // A state-machine-like function with many overlapping loops
+  LoopNest Nest(42, 600, 200);
+  HeadRegions Regions = Nest.Regions;
+  expandNestedSCSs(Regions, Nest.HeadSCSNodes);
+
+  RegionVector Expected = makeMetaRegions(Regions);
+  auto ReferenceStart = Clock::now();
+  referenceSimplifySCSAbnormalRetreating(Expected, Nest.Backedges);
+  referenceSimplifySCS(Expected);
+  auto ReferenceTime = duration_cast<microseconds>(Clock::now()
+                                                   - ReferenceStart);
+
+  RegionVector Actual = makeMetaRegions(Regions);
+  auto Start = Clock::now();
+  simplifySCSAbnormalRetreating(Actual, Nest.Backedges);
+  simplifySCS(Actual);
+  auto Time = duration_cast<microseconds>(Clock::now() - Start);
+
+  BOOST_TEST_MESSAGE(Nest.Nodes.size() << " nodes, " << Nest.Backedges.size()
+                                       << " backedges");
+  BOOST_TEST_MESSAGE("  reference: " << ReferenceTime.count() << "us");
+  BOOST_TEST_MESSAGE("  incremental: " << Time.count() << "us");
+
+  BOOST_TEST((toNodeSets(Actual) == toNodeSets(Expected)));
+}
@@ -0,0 +1,201 @@
+/// \file StoredBytesLattice.cpp
+/// Tests for the lattice used by SegregateStackAccesses
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#define BOOST_TEST_MODULE StoredBytesLattice
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <random>
+#include <set>
+#include <tuple>
+#include <type_traits>
+
+#include "lib/PromoteStackPointer/StoredBytesLattice.h"
+
+struct FakeStore {
+  unsigned Size = 0;
+};
+
+using Lattice = StoredBytesLattice<FakeStore>;
+
+/// The reference implementation: one element per stored byte
+using ByteSet = std::set<std::tuple<int64_t, FakeStore *, uint64_t>>;
+
+static void eraseBytes(ByteSet &Bytes, int64_t Start, int64_t End) {
+  Bytes.erase(Bytes.lower_bound({ Start, nullptr, 0 }),
+              Bytes.lower_bound({ End, nullptr, 0 }));
+}
+
+static void storeBytes(ByteSet &Bytes, int64_t Start, FakeStore *Store) {
+  eraseBytes(Bytes, Start, Start + Store->Size);
+  for (unsigned I = 0; I < Store->Size; ++I)
+    Bytes.insert({ Start + I, Store, I });
+}
+
+static void storeBytes(Lattice &Bytes, int64_t Start, FakeStore *Store) {
+  Bytes.erase(Start, Start + Store->Size);
+  Bytes.insert(Start, Start + Store->Size, Store);
+}
+
+static ByteSet toByteSet(const Lattice &Bytes) {
+  ByteSet Result;
+  for (const auto &[Start, Interval] : Bytes)
+    for (const auto &[Store, StoreOffset] : Interval.Writers)
+      for (int64_t Offset = Start; Offset < Interval.End; ++Offset)
+        Result.insert({ Offset, Store, StoreOffset + (Offset - Start) });
+  return Result;
+}
+
+static ByteSet combine(const ByteSet &LHS, const ByteSet &RHS) {
+  ByteSet Result = LHS;
+  Result.insert(RHS.begin(), RHS.end());
+  return Result;
+}
+
+BOOST_AUTO_TEST_CASE(RandomOperationsMatchByteSet) {
+  std::mt19937 Generator(42);
+  std::vector<FakeStore> Stores;
+  for (unsigned Size : { 1, 2, 4, 8, 16, 4, 8, 1 })
+    Stores.push_back({ Size });
+
+  auto RandomOffset = [&Generator]() -> int64_t {
+    return std::uniform_int_distribution<int64_t>(-64, 64)(Generator);
+  };
+  auto RandomIndex = [&Generator](size_t Size) -> size_t {
+    return std::uniform_int_distribution<size_t>(0, Size - 1)(Generator);
+  };
+
+  std::vector<Lattice> States(4);
+  std::vector<ByteSet> References(4);
+
+  for (unsigned Iteration = 0; Iteration < 4000; ++Iteration) {
+    size_t Index = RandomIndex(States.size());
+    Lattice &State = States[Index];
+    ByteSet &Reference = References[Index];
+
+    switch (RandomIndex(4)) {
+    case 0: {
+      FakeStore *Store = &Stores[RandomIndex(Stores.size())];
+      int64_t Start = RandomOffset();
+      storeBytes(State, Start, Store);
+      storeBytes(Reference, Start, Store);
+    } break;
+
+    case 1: {
+      int64_t Start = RandomOffset();
+      int64_t End = Start + RandomIndex(16);
+      State.erase(Start, End);
+      eraseBytes(Reference, Start, End);
+    } break;
+
+    case 2: {
+      size_t Other = RandomIndex(States.size());
+      State = Lattice::combine(State, States[Other]);
+      Reference = combine(Reference, References[Other]);
+    } break;
+
+    case 3: {
+      // Copy, and then modify the copy only
+      size_t Other = RandomIndex(States.size());
+      States[Other] = State;
+      References[Other] = Reference;
+      FakeStore *Store = &Stores[RandomIndex(Stores.size())];
+      int64_t Start = RandomOffset();
+      storeBytes(States[Other], Start, Store);
+      storeBytes(References[Other], Start, Store);
+    } break;
+    }
+
+    for (size_t I = 0; I < States.size(); ++I) {
+      BOOST_TEST((toByteSet(States[I]) == References[I]));
+      for (size_t J = 0; J < States.size(); ++J) {
+        bool Expected = std::includes(References[J].begin(),
+                                      References[J].end(),
+                                      References[I].begin(),
+                                      References[I].end());
+        BOOST_TEST(Lattice::isLessOrEqual(States[I], States[J]) == Expected);
+        bool Equal = References[I] == References[J];
+        BOOST_TEST(((States[I] == States[J]) == Equal));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(AdjacentStoresDoNotMerge) {
+  FakeStore A{ 4 };
+  FakeStore B{ 4 };
+  Lattice Bytes;
+  storeBytes(Bytes, 0, &A);
+  storeBytes(Bytes, 4, &B);
+  BOOST_TEST(Bytes.intervalsCount() == 2);
+
+  // Overwriting the middle of a store splits it
+  FakeStore C{ 2 };
+  storeBytes(Bytes, 1, &C);
+  BOOST_TEST(Bytes.intervalsCount() == 4);
+
+  // Writing it again brings it back to a single interval
+  storeBytes(Bytes, 0, &A);
+  BOOST_TEST(Bytes.intervalsCount() == 2);
+}
+
+template<typename T>
+static void simulateCopyLoop(T &State,
+                             std::vector<FakeStore> &Stores,
+                             unsigned Iterations) {
+  // A memcpy-like loop body writing the whole frame, joined with the state
+  // coming from the loop header, as the MFP would do
+  for (unsigned Iteration = 0; Iteration < Iterations; ++Iteration) {
+    T Body = State;
+    int64_t Offset = 0;
+    for (FakeStore &Store : Stores) {
+      storeBytes(Body, Offset, &Store);
+      Offset += Store.Size;
+    }
+
+    if constexpr (std::is_same_v<T, Lattice>)
+      State = Lattice::combine(State, Body);
+    else
+      State = combine(State, Body);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(LargeFrameBenchmark) {
+  using Clock = std::chrono::steady_clock;
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+
+  // An 8 KiB stack frame written 8 bytes at a time
+  constexpr unsigned FrameSize = 8 * 1024;
+  constexpr unsigned Iterations = 16;
+  std::vector<FakeStore> Stores(FrameSize / 8, FakeStore{ 8 });
+
+  ByteSet Reference;
+  auto ReferenceStart = Clock::now();
+  simulateCopyLoop(Reference, Stores, Iterations);
+  auto ReferenceTime = duration_cast<microseconds>(Clock::now()
+                                                   - ReferenceStart);
+
+  Lattice Intervals;
+  auto IntervalsStart = Clock::now();
+  simulateCopyLoop(Intervals, Stores, Iterations);
+  auto IntervalsTime = duration_cast<microseconds>(Clock::now()
+                                                   - IntervalsStart);
+
+  BOOST_TEST_MESSAGE("Frame of " << FrameSize << " bytes, " << Iterations
+                                 << " iterations");
+  BOOST_TEST_MESSAGE("  std::set of bytes: " << ReferenceTime.count() << "us, "
+                                             << Reference.size()
+                                             << " nodes");
+  BOOST_TEST_MESSAGE("  interval map: " << IntervalsTime.count() << "us, "
+                                        << Intervals.intervalsCount()
+                                        << " nodes");
+
+  BOOST_TEST((toByteSet(Intervals) == Reference));
+  BOOST_TEST(Intervals.intervalsCount() == Stores.size());
+}
@@ -0,0 +1,104 @@
+/// \file StringLiteralTable.cpp
+/// Tests for the single scan of the string literals in a segment
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#define BOOST_TEST_MODULE StringLiteralTable
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+
+#include "lib/RemoveLiftingArtifacts/StringLiteralTable.h"
+
+using namespace std::string_literals;
+
+/// Check that the table agrees with the scan starting at each offset,
+/// including the ones past the end of the segment
+static void checkAllOffsets(const std::string &Segment) {
+  llvm::StringRef Data(Segment);
+  StringLiteralTable Table(Data);
+
+  for (uint64_t Offset = 0; Offset <= Data.size() + 1; ++Offset) {
+    std::optional<llvm::StringRef> Expected = findStringLiteral(Data, Offset);
+    std::optional<llvm::StringRef> Actual = Table.get(Offset);
+
+    BOOST_TEST_CONTEXT("Offset " << Offset) {
+      BOOST_TEST(Actual.has_value() == Expected.has_value());
+      if (Actual.has_value() and Expected.has_value()) {
+        BOOST_TEST(Actual->data() == Expected->data());
+        BOOST_TEST(Actual->size() == Expected->size());
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(EmptySegment) {
+  checkAllOffsets("");
+  BOOST_TEST(not StringLiteralTable("").get(0).has_value());
+}
+
+BOOST_AUTO_TEST_CASE(EmptyStrings) {
+  checkAllOffsets("\0"s);
+  checkAllOffsets("\0\0"s);
+  checkAllOffsets("a\0\0b\0"s);
+
+  std::string Segment = "\0\0"s;
+  std::optional<llvm::StringRef> String = StringLiteralTable(Segment).get(1);
+  BOOST_TEST(String.has_value());
+  BOOST_TEST(String->empty());
+}
+
+BOOST_AUTO_TEST_CASE(EmbeddedTerminatorRuns) {
+  checkAllOffsets("hello\0\0\0\0world\0"s);
+  checkAllOffsets("\0\0\0first\0\0second\0\0\0third\0\0\0"s);
+  checkAllOffsets("a\0b\0c\0\0\0\0\0\0\0\0d\0"s);
+}
+
+BOOST_AUTO_TEST_CASE(UnterminatedTail) {
+  checkAllOffsets("unterminated");
+  checkAllOffsets("first\0unterminated"s);
+  checkAllOffsets("first\0\0\0unterminated"s);
+
+  std::string Segment = "first\0tail"s;
+  BOOST_TEST(not StringLiteralTable(Segment).get(6).has_value());
+}
+
+BOOST_AUTO_TEST_CASE(NonPrintableCharacters) {
+  checkAllOffsets("bad\x01prefix\0"s);
+  checkAllOffsets("\x7f\0line\nwith\ttabs\0\xff\xfe\0"s);
+  checkAllOffsets("\x01\x02\x03\0\x04text\0"s);
+}
+
+BOOST_AUTO_TEST_CASE(RandomSegments) {
+  // Draw the bytes mostly among terminators, printable and non-printable
+  // characters, so that each kind of run shows up often
+  std::mt19937 Generator(42);
+  std::uniform_int_distribution<int> Kind(0, 9);
+  std::uniform_int_distribution<int> Printable(' ', '~');
+  std::uniform_int_distribution<int> Byte(1, 255);
+  std::uniform_int_distribution<int> Size(0, 64);
+
+  for (unsigned I = 0; I < 1000; ++I) {
+    std::string Segment;
+    for (int J = Size(Generator); J > 0; --J) {
+      int K = Kind(Generator);
+      if (K < 3)
+        Segment.push_back('\0');
+      else if (K < 9)
+        Segment.push_back(static_cast<char>(Printable(Generator)));
+      else
+        Segment.push_back(static_cast<char>(Byte(Generator)));
+    }
+
+    BOOST_TEST_CONTEXT("Segment " << I) {
+      checkAllOffsets(Segment);
+    }
+  }
+}